@@ -0,0 +1,45 @@
+function result = advise(varargin)
+%ADVISE Recommend page and cache geometry for the database.
+%
+%    result = bdb.advise(...)
+%    result = bdb.advise(id, ...)
+%
+% The function samples record sizes through a cursor and recommends a page
+% size that keeps records off overflow pages, a buffer pool size for the
+% working set, and hash table parameters. When the id is omitted, the default
+% session is used. Apply the recommendation with the _PageSize_,
+% _HashFfactor_ and _HashNelem_ options of bdb.open when creating a new
+% database, and with the _CacheSize_ option of bdb.env_open or bdb.open.
+%
+% The result is a struct with the following fields.
+%
+%    pagesize                       Current page size.
+%    samples                        Number of sampled records.
+%    nkeys                          Estimated number of records.
+%    key_mean                       Mean key size in bytes.
+%    value_mean                     Mean value size in bytes.
+%    value_max                      Largest sampled value size in bytes.
+%    item_p95                       95th percentile of item sizes in bytes.
+%    overflow_fraction              Fraction of sampled records on overflow
+%                                   pages at the current page size.
+%    recommended_pagesize           Recommended page size.
+%    recommended_overflow_fraction  Overflow fraction at the recommended size.
+%    estimated_bytes                Estimated file size at the recommended size.
+%    recommended_cachesize          Recommended buffer pool size.
+%    recommended_h_ffactor          Recommended hash fill factor.
+%    recommended_h_nelem            Recommended hash table size.
+%
+% ## Options
+%
+% _Samples_ [10000]
+%
+% Maximum number of records to sample from the head of the database.
+%
+% _WorkingSet_ [1.0]
+%
+% Fraction of the leaf pages expected to be hot. Interior pages are always
+% counted in the recommended cache size.
+%
+% See also bdb.open bdb.env_open bdb.stat
+  result = libbdb(mfilename, varargin{:});
+end
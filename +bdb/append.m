@@ -0,0 +1,28 @@
+function recnos = append(varargin)
+%APPEND Append values to a queue or recno database.
+%
+%    recnos = bdb.append(values, ...)
+%    recnos = bdb.append(id, values, ...)
+%
+% The function stores a cell array of values at new record numbers at the
+% end of a queue or recno database, and returns the assigned record numbers
+% in a column vector. Values are encoded before any record is written, and
+% in a transactional environment all of them are appended in a single
+% transaction. For a queue database, each encoded value must fit in the
+% RecordLength given to bdb.open. When the id is omitted, the default
+% session is used.
+%
+% ## Options
+%
+% _Transaction_ [0]
+%
+% Transaction in which to append the values.
+%
+% Example:
+%
+% >> id = bdb.open('jobs.db', 'Type', 'queue', 'RecordLength', 256);
+% >> recnos = bdb.append(id, {struct('task', 1), struct('task', 2)});
+%
+% See also bdb.consume bdb.open
+  recnos = libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,23 @@
+function num_elements = append_to(varargin)
+%APPEND_TO Atomically append elements to a vector value.
+%
+%    num_elements = bdb.append_to(key, values)
+%    num_elements = bdb.append_to(id, key, values)
+%
+% The function appends the elements of a real numeric, logical or char array
+% to the vector stored for the key, and returns the new number of elements.
+% The stored value must be in the native codec and of the same class. A row
+% vector grows to the right and any other vector grows downward. A missing
+% key is created. The first form uses the default database. The read and the
+% write happen in one transaction in a transactional environment, and under
+% a write lock of the key in an environment with locking. A free-threaded
+% database without locking is refused.
+%
+% Example:
+%
+% >> id = bdb.open('events.db', 'Codec', 'native');
+% >> bdb.append_to(id, 'object1', [10, 11, 12]);
+%
+% See also bdb.incr bdb.cas bdb.open
+  num_elements = libbdb(mfilename, varargin{:});
+end
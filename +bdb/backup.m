@@ -0,0 +1,41 @@
+function backup(varargin)
+%BACKUP Back up an environment while it is in use.
+%
+%    bdb.backup(target_dir, ...)
+%    bdb.backup(environment_id, target_dir, ...)
+%
+% The function copies the database files page by page and then the log
+% files into target_dir, which is created if missing. Writers are not
+% blocked; the copied logs make the backup consistent when it is opened with
+% the _Recover_ option of bdb.env_open. When environment_id is skipped, the
+% default environment is used. Berkeley DB 5.3 or later is required.
+%
+% ## Options
+%
+% _Incremental_ [false]
+%
+% Only copy log files written since the last backup into an existing backup.
+%
+% _Clean_ [false]
+%
+% Remove all files from target_dir before the backup.
+%
+% _SingleDir_ [false]
+%
+% Place all files directly in target_dir regardless of the data and log
+% directories of the environment.
+%
+% _Rate_ [0]
+%
+% If positive, limit reading of database pages to about the specified
+% megabytes per second.
+%
+% Example:
+%
+% >> bdb.backup(env_id, '/backup/full', 'Clean', true, 'Rate', 20);
+% >> % Later, copy only new log files.
+% >> bdb.backup(env_id, '/backup/full', 'Incremental', true);
+%
+% See also bdb.env_open bdb.checkpoint bdb.log_archive
+  libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,34 @@
+function num_records = bulk_load(varargin)
+%BULK_LOAD Store many records in key order.
+%
+%    num_records = bdb.bulk_load(keys, values, ...)
+%    num_records = bdb.bulk_load(id, keys, values, ...)
+%
+% The function stores records of cell arrays of keys and values. Records are
+% encoded first and sorted by their encoded keys, then inserted in that
+% order so that btree pages are filled densely, and the database is synced
+% once at the end. When the encoded records exceed the memory limit, sorted
+% runs are written to temporary files and merged. For equal keys, the last
+% value wins. In a transactional environment, the records are inserted in
+% bulk transactions of 10000 records each, so that a failure keeps the
+% records of the committed transactions. Values are encoded with the codec of
+% the database, and large values go to the value log when it is enabled. Only
+% btree and hash databases are supported; a hash database gains nothing from
+% the order and only benefits from the batched commits. When the id is omitted, the default session
+% is used. The function returns the number of records stored.
+%
+% ## Options
+%
+% _MemoryLimit_ [67108864]
+%
+% Maximum bytes of encoded records kept in memory while sorting.
+%
+% Example:
+%
+% >> keys = num2cell(randperm(100000));
+% >> values = cellfun(@(x)rand(4), keys, 'UniformOutput', false);
+% >> bdb.bulk_load(id, keys, values, 'MemoryLimit', 16 * 1024 * 1024);
+%
+% See also bdb.put bdb.compact
+  num_records = libbdb(mfilename, varargin{:});
+end
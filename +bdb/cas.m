@@ -0,0 +1,23 @@
+function swapped = cas(varargin)
+%CAS Replace a value only if it equals an expected value.
+%
+%    swapped = bdb.cas(key, expected, value)
+%    swapped = bdb.cas(id, key, expected, value)
+%
+% The function stores the value for the key only if the stored value is
+% identical to the expected one, and returns true if it did. An empty
+% expected value also matches a missing key. The first form uses the default
+% database. The comparison and the write happen in one transaction in a
+% transactional environment, and under a write lock of the key in an
+% environment with locking. A free-threaded database without locking is
+% refused.
+%
+% Example:
+%
+% >> if ~bdb.cas(id, 'lock', [], 'owner1')
+% >>   disp('Already taken.');
+% >> end
+%
+% See also bdb.incr bdb.append_to
+  swapped = libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,30 @@
+function checkpoint(varargin)
+%CHECKPOINT Checkpoint the transaction subsystem.
+%
+%    bdb.checkpoint(...)
+%    bdb.checkpoint(environment_id, ...)
+%
+% The function flushes modified pages in the buffer pool and writes a
+% checkpoint record to the log, so that recovery only needs to replay logs
+% written after the checkpoint. When environment_id is skipped, the default
+% environment is used.
+%
+% ## Options
+%
+% _KBytes_ [0]
+%
+% If non-zero, checkpoint only if more than the specified kilobytes of log
+% have been written since the last checkpoint.
+%
+% _Minutes_ [0]
+%
+% If non-zero, checkpoint only if more than the specified minutes have passed
+% since the last checkpoint.
+%
+% _Force_ [false]
+%
+% Checkpoint even if there has been no activity since the last checkpoint.
+%
+% See also bdb.env_open bdb.log_archive
+  libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,16 @@
+function close_sharded(varargin)
+%CLOSE_SHARDED Close a sharded database.
+%
+%    bdb.close_sharded(id, ...)
+%
+% The function closes all shards of the handle.
+%
+% ## Options
+%
+% _Nosync_ [false]
+%
+% Do not flush cached information to disk.
+%
+% See also bdb.open_sharded
+  libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,29 @@
+function [values, recnos] = consume(varargin)
+%CONSUME Remove and return records from the head of a queue.
+%
+%    [values, recnos] = bdb.consume(N, ...)
+%    [values, recnos] = bdb.consume(id, N, ...)
+%
+% The function removes up to N records from the head of a queue database
+% and returns their values in a column cell array and their record numbers
+% in a column vector. Fewer records are returned when the queue runs empty.
+% In a transactional environment, all of the records are consumed in a
+% single transaction. When the id is omitted, the default session is used.
+%
+% ## Options
+%
+% _Wait_ [false]
+%
+% Block until at least one record is available.
+%
+% _Transaction_ [0]
+%
+% Transaction in which to consume the records.
+%
+% Example:
+%
+% >> [values, recnos] = bdb.consume(id, 1000, 'Wait', true);
+%
+% See also bdb.append bdb.open
+  [values, recnos] = libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,19 @@
+function num_values = count(varargin)
+%COUNT Count duplicate values of a key.
+%
+%    num_values = bdb.count(key)
+%    num_values = bdb.count(id, key, ...)
+%
+% The function returns the number of values stored for the given key without
+% reading them, or 0 when the key is not found. When the id is omitted, the
+% default session is used.
+%
+% ## Options
+%
+% _Transaction_ [0]
+%
+% Transaction in which to count the values.
+%
+% See also bdb.get_all bdb.open
+  num_values = libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,44 @@
+function index_id = create_index(varargin)
+%CREATE_INDEX Create a secondary index on a struct field.
+%
+%    index_id = bdb.create_index('FieldName', name, ...)
+%    index_id = bdb.create_index(id, 'FieldName', name, ...)
+%
+% The function opens a secondary database keyed by a field of the struct
+% values stored in the database and associates it with the database, so that
+% later puts and deletes keep the index up to date. Existing records are
+% indexed when the index is new. Records whose value is not a scalar struct
+% or whose field is missing or empty are not indexed. The function returns a
+% session id of the index to be used with bdb.get_by. The index does not
+% become the default session. When the id is omitted, the default session is
+% used.
+%
+% Real numeric or logical scalars and char rows are indexed in their natural
+% order and support range queries; numbers sort before strings. Other values
+% only support exact matches. Integers beyond 2^53 lose precision.
+%
+% Closing the database also closes its indices. Indices are not maintained
+% for records changed while the index is closed; delete the index file to
+% rebuild it. Asynchronous puts are not supported on an indexed database.
+%
+% ## Options
+%
+% _FieldName_ ['']
+%
+% Name of the struct field to index. Required.
+%
+% _Filename_ ['']
+%
+% File of the index. By default, the name of the database file with the
+% field name and .idx appended, or in memory if the database is in memory.
+%
+% Example:
+%
+% >> id = bdb.open('/path/to/db.bdb');
+% >> bdb.put(id, 1, struct('subject_id', 3, 'data', rand(4)));
+% >> index_id = bdb.create_index(id, 'FieldName', 'subject_id');
+% >> [values, keys] = bdb.get_by(index_id, 3);
+%
+% See also bdb.get_by bdb.open
+  index_id = libbdb(mfilename, varargin{:});
+end
@@ -2,10 +2,38 @@ function cursor_id = cursor_open(varargin)
 %CURSOR_OPEN Open a new cursor.
 %
 %    cursor_id = bdb.cursor_open()
-%    cursor_id = bdb.cursor_open(db_id)
+%    cursor_id = bdb.cursor_open(db_id, ...)
 %
 % The function creates a new cursor.
 %
-% See also bdb.cursor_close
+% ## Options
+%
+% _Prefetch_ [0]
+%
+% If positive, a background thread reads up to the specified number of
+% records ahead of bdb.cursor_next, so that storage access overlaps with
+% processing in matlab. A prefetch cursor only moves forward and
+% bdb.cursor_prev fails. The database must be opened with the _Thread_
+% option. bdb.cursor_close cancels the background reading. In a locking
+% environment, the cursor keeps a read lock on the page it is reading while
+% the buffer is full, so writes to that page wait until the cursor advances
+% or is closed.
+%
+% _KeysOnly_ [false]
+%
+% Never read values, so that scanning keys of a database with large values
+% only touches the tree pages, not the overflow pages. bdb.cursor_get of
+% such a cursor only returns keys.
+%
+% Example:
+%
+% >> id = bdb.open('/path/to/db.bdb', 'Thread', true);
+% >> cursor_id = bdb.cursor_open(id, 'Prefetch', 64);
+% >> while bdb.cursor_next(cursor_id)
+%      [key, value] = bdb.cursor_get(cursor_id);
+%    end
+% >> bdb.cursor_close(cursor_id);
+%
+% See also bdb.cursor_close bdb.cursor_next
   cursor_id = libbdb(mfilename, varargin{:});
 end
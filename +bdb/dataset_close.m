@@ -0,0 +1,11 @@
+function dataset_close(dataset_id)
+%DATASET_CLOSE Close a dataset.
+%
+%    bdb.dataset_close(dataset_id)
+%
+% The function closes a dataset handle. Written chunks are already stored.
+%
+% See also bdb.dataset_create bdb.dataset_open bdb.dataset_write
+% bdb.dataset_read
+  libbdb(mfilename, dataset_id);
+end
@@ -0,0 +1,27 @@
+function dataset_id = dataset_create(id, name, size, class_name, chunk)
+%DATASET_CREATE Create a chunked N-D array dataset.
+%
+%    dataset_id = bdb.dataset_create(id, name, size, class_name, chunk)
+%
+% The function creates a dataset of the given size and element class under
+% the name, and returns its handle. A dataset splits an N-D numeric, logical
+% or char array into chunks of the given size, each stored as a compressed
+% record in a companion database, e.g., data.bdb.stream. Chunks that are
+% never written read as zeros, and chunks at the edge of the array are
+% stored in the full chunk size.
+%
+% The existing value of the name is removed. bdb.get on the name returns the
+% metadata struct, and bdb.delete removes the chunks with it.
+%
+% Example:
+%
+% >> dataset_id = bdb.dataset_create(id, 'volume', [2048 2048 512], ...
+% >>                                 'uint16', [256 256 16]);
+% >> bdb.dataset_write(dataset_id, {':', ':', 1:16}, frames);
+% >> slice = bdb.dataset_read(dataset_id, {1:512, 1:512, 8});
+% >> bdb.dataset_close(dataset_id);
+%
+% See also bdb.dataset_open bdb.dataset_write bdb.dataset_read
+% bdb.dataset_close
+  dataset_id = libbdb(mfilename, id, name, size, class_name, chunk);
+end
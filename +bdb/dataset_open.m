@@ -0,0 +1,12 @@
+function dataset_id = dataset_open(id, name)
+%DATASET_OPEN Open an existing dataset.
+%
+%    dataset_id = bdb.dataset_open(id, name)
+%
+% The function opens a dataset created by bdb.dataset_create under the name
+% and returns its handle.
+%
+% See also bdb.dataset_create bdb.dataset_write bdb.dataset_read
+% bdb.dataset_close
+  dataset_id = libbdb(mfilename, id, name);
+end
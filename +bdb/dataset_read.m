@@ -0,0 +1,15 @@
+function data = dataset_read(dataset_id, varargin)
+%DATASET_READ Read a hyperslab of a dataset.
+%
+%    data = bdb.dataset_read(dataset_id)
+%    data = bdb.dataset_read(dataset_id, subs)
+%
+% The function reads the hyperslab given by subs, a cell array of one
+% contiguous index vector or ':' per dimension, and returns it as an array of
+% the class of the dataset. When subs is omitted, the whole array is read.
+% Only the intersecting chunks are read, and they are decoded in parallel.
+%
+% See also bdb.dataset_create bdb.dataset_open bdb.dataset_write
+% bdb.dataset_close
+  data = libbdb(mfilename, dataset_id, varargin{:});
+end
@@ -0,0 +1,15 @@
+function dataset_write(dataset_id, subs, data)
+%DATASET_WRITE Write a hyperslab of a dataset.
+%
+%    bdb.dataset_write(dataset_id, subs, data)
+%
+% The function writes data to the hyperslab given by subs, a cell array of
+% one contiguous index vector or ':' per dimension. The data must be of the
+% class of the dataset and have as many elements as the hyperslab, in
+% column-major order. Only the intersecting chunks are read and rewritten,
+% and chunks entirely covered by the hyperslab are not read at all.
+%
+% See also bdb.dataset_create bdb.dataset_open bdb.dataset_read
+% bdb.dataset_close
+  libbdb(mfilename, dataset_id, subs, data);
+end
@@ -13,6 +13,12 @@ function env_close(varargin)
 %
 % When closing each database handle internally, synchronize the database.
 %
-% See also bdb.open
+% _WarmList_ ['']
+%
+% Path to a file to save the list of pages preloaded by bdb.warm or by the
+% _WarmList_ option of bdb.env_open. Pass the same path to bdb.env_open to
+% restore the pages after a restart.
+%
+% See also bdb.open bdb.warm
   libbdb(mfilename, varargin{:});
 end
@@ -87,6 +87,46 @@ function id = env_open(home_dir, varargin)
 % 
 % UNIX file mode.
 %
+% _CacheSize_ [0]
+%
+% Size of the shared memory buffer pool in bytes. When 0, the Berkeley DB
+% default (256KB) is used. Use bdb.advise to estimate a size for the data.
+%
+% _CacheRegions_ [0]
+%
+% Number of regions the buffer pool is split into. When 0 or 1, the buffer
+% pool is allocated contiguously.
+%
+% _MmapSize_ [0]
+%
+% Maximum size in bytes of a read-only database file that is mapped into
+% process memory instead of being read through the buffer pool.
+%
+% _LogBufferSize_ [0]
+%
+% Size of the in-memory log buffer in bytes. Larger buffers reduce log writes
+% of write-heavy transactions.
+%
+% _WarmList_ ['']
+%
+% Path to a file saved by the _WarmList_ option of bdb.env_close. When the
+% file exists, the listed pages are loaded into the buffer pool in sequential
+% file order right after the environment is opened.
+%
+% _LogAutoRemove_ [false]
+%
+% Automatically remove log files that are no longer needed for recovery. Note
+% that catastrophic recovery is not possible without archived log files.
+%
+% _CheckpointEvery_ [0]
+%
+% If positive, a background thread checkpoints the environment at the given
+% interval in seconds, so that recovery on the next open only replays the
+% logs written since the last checkpoint. The option requires _InitTXN_ and
+% implies _Thread_. A final checkpoint is taken on bdb.env_close. The count
+% and the last error of background checkpoints are reported by bdb.env_stat,
+% and bdb.env_close raises the error of the last checkpoint if it failed.
+%
 % See also bdb.close_environment bdb.open
   id = libbdb(mfilename, home_dir, varargin{:});
 end
@@ -0,0 +1,47 @@
+function result = env_stat(varargin)
+%ENV_STAT Get buffer pool, lock, log and transaction statistics.
+%
+%    result = bdb.env_stat(...)
+%    result = bdb.env_stat(environment_id, ...)
+%    result = bdb.env_stat('Database', id, ...)
+%
+% The function retrieves statistics of the subsystems of an environment. When
+% environment_id is skipped, the default environment is used, or the private
+% environment of the default database session if there is no environment.
+%
+% The result is a struct with the following fields. A field is empty when the
+% subsystem is not initialized in the environment.
+%
+%    mpool   Buffer pool statistics, including cache_hit, cache_miss,
+%            hit_ratio, page_in, page_out, ro_evict, rw_evict and page_dirty.
+%    files   Struct array of per-file buffer pool statistics.
+%    lock    Lock subsystem statistics.
+%    log     Log subsystem statistics.
+%    txn     Transaction subsystem statistics.
+%    checkpoint  Background checkpoint of the _CheckpointEvery_ option of
+%            bdb.env_open, with the number of checkpoints taken in count and
+%            the message of the last failed checkpoint in error, or '' if
+%            it succeeded.
+%
+% ## Options
+%
+% _Database_ [0]
+%
+% Database session id. When specified, statistics of the environment of the
+% database are returned. This is the only way to query the private buffer
+% pool of a database opened outside of an environment.
+%
+% _Clear_ [false]
+%
+% Reset the counters after returning them, so that the next call returns the
+% activity since this call. Counters are shared by every process using the
+% environment. For example, to measure the hit ratio over a minute:
+%
+%    bdb.env_stat(env_id, 'Clear');
+%    pause(60);
+%    result = bdb.env_stat(env_id, 'Clear');
+%    disp(result.mpool.hit_ratio);
+%
+% See also bdb.env_open bdb.stat
+  result = libbdb(mfilename, varargin{:});
+end
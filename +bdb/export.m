@@ -0,0 +1,31 @@
+function num_records = export(varargin)
+%EXPORT Write all records to a binary dump file.
+%
+%    num_records = bdb.export(filename, ...)
+%    num_records = bdb.export(id, filename, ...)
+%
+% The function writes the encoded records of the database to a dump file as
+% they are stored, without decoding them in matlab. Values kept in a value
+% log are written in place of their pointers. Records are grouped into
+% blocks of about a megabyte with a CRC-32 checksum each. Use bdb.import to
+% load the file into another database. When the id is omitted, the default
+% session is used. The function returns the number of records written.
+%
+% The dump file is only compatible with drivers using the same value
+% encoding, i.e., built with the same _--enable_zlib_ setting.
+%
+% ## Options
+%
+% _Compress_ [false]
+%
+% Compress each block with zlib. The driver must be built with zlib.
+%
+% Example:
+%
+% >> bdb.export(id, '/path/to/db.dump', 'Compress', true);
+% >> new_id = bdb.open('/path/to/new.bdb', 'Create', true);
+% >> bdb.import(new_id, '/path/to/db.dump');
+%
+% See also bdb.import bdb.bulk_load
+  num_records = libbdb(mfilename, varargin{:});
+end
@@ -3,6 +3,7 @@ function value = get(varargin)
 %
 %    value = bdb.get(key)
 %    value = bdb.get(id, key, ...)
+%    slice = bdb.get(id, key, 'Range', [offset, count])
 %
 % The function retrieves an entry with the given key in the specified
 % database session. The first form is used when retrieving a record from the
@@ -56,6 +57,13 @@ function value = get(varargin)
 % Acquire write locks instead of read locks when doing the read, if locking is
 % configured.
 %
+% _Range_ []
+%
+% Read count elements from the zero-based element offset of a value stored
+% with the native codec, returned as a column vector. Only the requested bytes
+% are read from the database. The range is clipped to the stored value. A value
+% kept in the value log is read whole and sliced.
+%
 % See also bdb.put bdb.delete
   value = libbdb(mfilename, varargin{:});
 end
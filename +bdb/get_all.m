@@ -0,0 +1,29 @@
+function values = get_all(varargin)
+%GET_ALL Retrieve all duplicate values of a key.
+%
+%    values = bdb.get_all(key)
+%    values = bdb.get_all(id, key, ...)
+%
+% The function retrieves every value stored for the given key in a database
+% opened with the Duplicates option, and returns them in a column cell array.
+% The values are read in bulk, many per call to Berkeley DB. In a sorted
+% duplicate database, the values are in the order of their encoded bytes,
+% otherwise in insertion order. An empty cell array is returned when the key
+% is not found. When the id is omitted, the default session is used.
+%
+% ## Options
+%
+% _Transaction_ [0]
+%
+% Transaction in which to read the values.
+%
+% Example:
+%
+% >> id = bdb.open('events.db', 'Duplicates', 'sorted');
+% >> bdb.put(id, 'object1', struct('time', 1, 'event', 'created'));
+% >> bdb.put(id, 'object1', struct('time', 2, 'event', 'moved'));
+% >> events = bdb.get_all(id, 'object1');
+%
+% See also bdb.count bdb.get bdb.open
+  values = libbdb(mfilename, varargin{:});
+end
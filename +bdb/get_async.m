@@ -0,0 +1,24 @@
+function handle = get_async(varargin)
+%GET_ASYNC Retrieve a value in the background.
+%
+%    handle = bdb.get_async(key)
+%    handle = bdb.get_async(id, key)
+%
+% The function queues a retrieval of the given key to the worker threads of
+% the database and returns a handle immediately. Use bdb.wait to collect the
+% value, which is [] when the key is not found. The database must be opened
+% with the _Thread_ option. The operation runs outside of any transaction and
+% bypasses the value cache. Queued operations run on several threads in no
+% particular order, so a get queued after a bdb.put_async of the same key may
+% not see the new value; wait for the put first.
+%
+% Example:
+%
+% >> id = bdb.open('/path/to/db.bdb', 'Thread', true);
+% >> handle = bdb.get_async(id, 'foo');
+% >> % Do other work here.
+% >> value = bdb.wait(handle);
+%
+% See also bdb.wait bdb.poll bdb.wait_any bdb.put_async bdb.mget_async
+  handle = libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,23 @@
+function [values, keys] = get_by(varargin)
+%GET_BY Find records by an indexed field value.
+%
+%    [values, keys] = bdb.get_by(index_id, value, ...)
+%
+% The function looks up the index created by bdb.create_index and returns
+% column cell arrays of the values and the keys of the matching records of
+% the primary database, in the order of the field value.
+%
+% ## Options
+%
+% _Upper_ [[]]
+%
+% If given, return records whose field is between value and upper,
+% inclusive. Otherwise, return records whose field equals value.
+%
+% Example:
+%
+% >> values = bdb.get_by(index_id, 10, 'Upper', 20);
+%
+% See also bdb.create_index
+  [values, keys] = libbdb(mfilename, varargin{:});
+end
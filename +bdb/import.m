@@ -0,0 +1,16 @@
+function num_records = import(varargin)
+%IMPORT Store all records of a binary dump file.
+%
+%    num_records = bdb.import(filename)
+%    num_records = bdb.import(id, filename)
+%
+% The function reads a dump file written by bdb.export and stores the
+% records without decoding them in matlab. Every block is verified by its
+% checksum, and the function fails at the first corrupted block. Existing
+% records of the same keys are overwritten. In a transactional environment,
+% records are committed in batches. When the id is omitted, the default
+% session is used. The function returns the number of records stored.
+%
+% See also bdb.export bdb.bulk_load
+  num_records = libbdb(mfilename, varargin{:});
+end
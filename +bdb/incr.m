@@ -0,0 +1,25 @@
+function value = incr(varargin)
+%INCR Atomically add to a numeric value.
+%
+%    value = bdb.incr(key)
+%    value = bdb.incr(id, key)
+%    value = bdb.incr(id, key, delta)
+%
+% The function adds delta to every element of the value stored for the key
+% and returns the new value. The first form increments the default database
+% by 1. The value must be stored in the native codec; a missing key starts
+% from a double zero. Integer classes round and saturate as matlab arithmetic
+% does. The read and the write happen in one transaction in a transactional
+% environment, and under a write lock of the key in an environment with
+% locking, so that concurrent increments are never lost. A free-threaded
+% database without locking is refused.
+%
+% Example:
+%
+% >> id = bdb.open('metrics.db', 'Codec', 'native');
+% >> bdb.incr(id, 'requests');
+% >> total = bdb.incr(id, 'bytes', 1024);
+%
+% See also bdb.append_to bdb.cas bdb.open
+  value = libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,28 @@
+function [values, keys] = join(varargin)
+%JOIN Find records matching indexed field values of several indices.
+%
+%    [values, keys] = bdb.join(id, {index_id1, value1; index_id2, value2}, ...)
+%
+% The function returns column cell arrays of the values and the keys of the
+% records in the database whose indexed fields equal all of the given values.
+% The conditions are an N-by-2 cell array of index ids created by
+% bdb.create_index on the database and the field values. The intersection is
+% computed inside Berkeley DB by DB->join without listing the matching keys
+% of each index in matlab.
+%
+% ## Options
+%
+% _NoSort_ [false]
+%
+% Do not sort the index cursors by the number of matches. By default, the
+% index with the fewest matches drives the join.
+%
+% Example:
+%
+% >> subject_index = bdb.create_index(id, 'FieldName', 'subject');
+% >> session_index = bdb.create_index(id, 'FieldName', 'session');
+% >> values = bdb.join(id, {subject_index, 3; session_index, 'morning'});
+%
+% See also bdb.create_index bdb.get_by
+  [values, keys] = libbdb(mfilename, varargin{:});
+end
@@ -7,7 +7,8 @@ function results = keys(varargin)
 % The function retrieves all keys from the specified database session. When
 % the id is omitted, the default session is used.
 %
-% The results are returned as a cell array.
+% The results are returned as a cell array. In a database with duplicates,
+% each key appears once.
 %
 % See also bdb.values
   results = libbdb(mfilename, varargin{:});
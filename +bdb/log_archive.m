@@ -0,0 +1,39 @@
+function files = log_archive(varargin)
+%LOG_ARCHIVE List or remove log files no longer in use.
+%
+%    files = bdb.log_archive(...)
+%    files = bdb.log_archive(environment_id, ...)
+%
+% The function returns a cell array of log files that are no longer needed
+% for normal recovery and can be archived. When environment_id is skipped,
+% the default environment is used.
+%
+% ## Options
+%
+% _Abs_ [false]
+%
+% Return absolute path names.
+%
+% _Data_ [false]
+%
+% Return the database files that need to be archived to recover the
+% environment from catastrophic failure.
+%
+% _Log_ [false]
+%
+% Return all log files, in use or not.
+%
+% _Remove_ [false]
+%
+% Remove log files no longer needed. The result is empty.
+%
+% Example:
+%
+% >> bdb.checkpoint(env_id);
+% >> files = bdb.log_archive(env_id, 'Abs', true);
+% >> % Copy the files to a backup media here.
+% >> bdb.log_archive(env_id, 'Remove', true);
+%
+% See also bdb.checkpoint bdb.env_open
+  files = libbdb(mfilename, varargin{:});
+end
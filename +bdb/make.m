@@ -8,7 +8,8 @@ function make(varargin)
 % See below for the supported build options.
 %
 % The libdb must be installed in the system. Also, for data compression,
-% zlib library is required.
+% zlib library is required. On unix, the driver links against pthread for
+% background operations.
 %
 % Options:
 %
@@ -28,6 +29,9 @@ function make(varargin)
 % enabled is not compatible with the driver built without the compression
 % flag, or vice versa. By default, compression is turned on.
 %
+% The heap access method is compiled in when the db.h found by the compiler
+% is Berkeley DB 5.2 or later.
+%
 % Example:
 %
 % Disable ZLIB compression.
@@ -48,11 +52,12 @@ function make(varargin)
   package_dir = fileparts(mfilename('fullpath'));
   [config, compiler_flags] = parse_options(varargin{:});
   cmd = sprintf(...
-    'mex -largeArrayDims%s -outdir %s -output libbdb %s %s%s',...
+    'mex -largeArrayDims%s -outdir %s -output libbdb %s %s%s%s',...
     find_source_files(fullfile(fileparts(package_dir), 'src')),...
     fullfile(package_dir, 'private'),...
     config.db_path,...
     repmat(['-DENABLE_ZLIB ', config.zlib_path], 1, config.enable_zlib),...
+    repmat(' -lpthread', 1, isunix),...
     compiler_flags...
     );
   disp(cmd);
@@ -0,0 +1,14 @@
+function handle = mget_async(varargin)
+%MGET_ASYNC Retrieve values of multiple keys in the background.
+%
+%    handle = bdb.mget_async(keys)
+%    handle = bdb.mget_async(id, keys)
+%
+% The function queues retrievals of a cell array of keys to a worker thread
+% of the database and returns a handle immediately. Use bdb.wait to collect
+% the values as a column cell array, where missing keys give []. The
+% database must be opened with the _Thread_ option.
+%
+% See also bdb.wait bdb.poll bdb.wait_any bdb.get_async
+  handle = libbdb(mfilename, varargin{:});
+end
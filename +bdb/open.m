@@ -72,7 +72,88 @@ function id = open(filename, varargin)
 % UNIX file mode to create the file. When it is 0, it follows the system
 % default configuration.
 %
+% _CacheSize_ [0]
+%
+% Size of the private buffer pool in bytes. Only valid for a database opened
+% outside of an environment; use the option of bdb.env_open otherwise.
+%
+% _PageSize_ [0]
+%
+% Page size in bytes, a power of two between 512 and 65536. Only effective
+% when the database is created. Records larger than about a quarter of the
+% page size are stored in overflow pages. Use bdb.advise to choose a size.
+%
+% _HashNelem_ [0]
+%
+% Estimated final number of elements in a hash database.
+%
+% _HashFfactor_ [0]
+%
+% Desired number of elements in a hash bucket.
+%
+% _Duplicates_ ['none']
+%
+% Duplicate data items for a key in a btree or hash database. One of 'none',
+% 'unsorted', or 'sorted'. Use bdb.get_all and bdb.count to read duplicates.
+%
+% _RecordLength_ [0]
+%
+% Fixed record length in bytes. Required for a queue database, where every
+% encoded value must fit in the length; optional for a recno database.
+%
+% _RecordPad_ [-1]
+%
+% Byte used to pad fixed-length records. Negative means the default.
+%
+% _ExtentSize_ [0]
+%
+% Number of pages in each extent file of a queue database. With extents,
+% disk space of consumed records is returned to the file system.
+%
+% _HeapSize_ [0]
+%
+% Maximum size in bytes of a heap database file. Heap databases reuse the
+% space of deleted and replaced records without compaction, and are only
+% available when the driver is built against Berkeley DB 5.2 or later.
+%
+% _Codec_ ['mxarray']
+%
+% Encoding of stored values. 'mxarray' serializes and compresses any value.
+% 'native' stores real 2-D numeric, logical and char arrays uncompressed as
+% a small header followed by the raw elements, and falls back to 'mxarray'
+% for other values. Native values are decoded without deserialization, and
+% are required by bdb.incr and bdb.append_to. Values of either codec are
+% read regardless of this option.
+%
+% _ValueLog_ [0]
+%
+% If non-zero, encoded values larger than the given number of bytes are
+% appended to value log files next to the database, e.g., test.db.vlog.000001,
+% and the database only stores a small pointer in their place. Writes of large
+% values become sequential appends, and bdb.keys and page splits touch a much
+% smaller tree. Space of overwritten and deleted values is reclaimed by
+% bdb.vlog_gc. Only for btree and hash databases without duplicates. Bulk
+% loads, imports and asynchronous operations use the log as well, and
+% bdb.export writes the logged values in place of their pointers. A logged
+% value is flushed to disk before its pointer is stored. The log itself is not
+% part of transactions; values of aborted writes become dead space. Only one
+% handle may write to a log at a time: opening the database for writing with
+% this option fails while another handle or process has the log open for
+% writing, e.g., through the lock file test.db.vlog.lock.
+%
+% _ValueLogSegmentSize_ [67108864]
+%
+% Size in bytes at which a new value log file is started.
+%
+% _ValueCacheSize_ [0]
+%
+% Size in bytes of the in-process cache of decoded values. When non-zero,
+% bdb.get returns a copy of the cached value for recently read keys without
+% decompressing and deserializing the record. The cache is invalidated by
+% writes from this process, but not by writes from other processes. Reads
+% with options or inside a transaction bypass the cache.
+%
 % See also bdb.close bdb.put bdb.get bdb.delete bdb.stat bdb.keys
-% bdb.values bdb.env_open
+% bdb.values bdb.env_open bdb.advise bdb.append bdb.consume
   id = libbdb(mfilename, filename, varargin{:});
 end
@@ -0,0 +1,64 @@
+function id = open_sharded(pattern, num_shards, varargin)
+%OPEN_SHARDED Open a set of databases partitioned by key.
+%
+%    id = bdb.open_sharded(pattern, num_shards, ...)
+%
+% The function opens num_shards databases and returns a handle for the
+% sharded API. Records are assigned to a shard by the FNV-1a hash of the
+% encoded key. The filename pattern must contain one %d conversion, which is
+% replaced by the shard index from 0, e.g., 'data_%02d.bdb'. The shards are
+% opened free-threaded, and multi-key reads and scans run on all shards in
+% parallel threads. Use the same number of shards when reopening.
+%
+% ## Options
+%
+% _Environment_ [0]
+%
+% Environment ID in which the shards are opened. When 0, the default
+% environment is used if any.
+%
+% _Type_ ['btree']
+%
+% Type of the shard databases, either 'btree' or 'hash'.
+%
+% _AutoCommit_ [true]
+%
+% Enclose each operation in a transaction in a transactional environment.
+%
+% _Create_ [true]
+%
+% Create the shards if they do not exist.
+%
+% _Rdonly_ [false]
+%
+% Open the shards for reading only.
+%
+% _Truncate_ [false]
+%
+% Truncate the shards.
+%
+% _Mode_ [0]
+%
+% File mode of the created shards.
+%
+% _CacheSize_, _PageSize_, _HashNelem_, _HashFfactor_ [0]
+%
+% Per-shard geometry. See bdb.open.
+%
+% _ValueLog_, _ValueLogSegmentSize_ [0, 67108864]
+%
+% Per-shard value log of large values. See bdb.open.
+%
+% Example:
+%
+% >> id = bdb.open_sharded('/disk%d/data.bdb', 4);
+% >> bdb.sharded_put(id, 'foo', magic(4));
+% >> values = bdb.sharded_mget(id, {'foo', 'bar'});
+% >> keys = bdb.sharded_keys(id, 'Ordered', true);
+% >> bdb.close_sharded(id);
+%
+% See also bdb.close_sharded bdb.sharded_get bdb.sharded_put
+%          bdb.sharded_delete bdb.sharded_mget bdb.sharded_keys
+%          bdb.sharded_values bdb.open
+  id = libbdb(mfilename, pattern, num_shards, varargin{:});
+end
@@ -0,0 +1,12 @@
+function finished = poll(varargin)
+%POLL Check if asynchronous operations are finished.
+%
+%    finished = bdb.poll(handles)
+%
+% The function returns a logical array indicating whether each operation is
+% finished without blocking. Finished operations still need bdb.wait to
+% collect the results and release the handles.
+%
+% See also bdb.wait bdb.wait_any
+  finished = libbdb(mfilename, varargin{:});
+end
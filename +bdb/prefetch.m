@@ -0,0 +1,30 @@
+function prefetch(varargin)
+%PREFETCH Fetch records of keys into the buffer pool in the background.
+%
+%    bdb.prefetch(keys)
+%    bdb.prefetch(id, keys)
+%
+% The function queues the keys and returns immediately. A background thread
+% reads the records without decoding them, so that the pages are in the
+% buffer pool when the keys are retrieved later by bdb.get or bdb.exist. The
+% keys are either a cell array of keys or a single key. Missing keys are
+% ignored. When the id is omitted, the default session is used.
+%
+% The database must be opened with the _Thread_ option. In a transactional
+% environment, each read runs in its own transaction that never waits for
+% locks, and keys locked by others are skipped. In an environment with locking
+% but without transactions, a read waits for the lock of a key written by
+% the caller, e.g., within a bdb.incr, and the keys queued after it wait as
+% well; the caller itself never blocks. Queued keys not yet fetched are
+% dropped when the database is closed.
+%
+% Example:
+%
+% >> id = bdb.open('/path/to/db.bdb', 'Thread', true);
+% >> bdb.prefetch(id, {'a', 'b', 'c'});
+% >> values = cellfun(@(key)bdb.get(id, key), {'a', 'b', 'c'}, ...
+%                     'UniformOutput', false);
+%
+% See also bdb.open bdb.get bdb.warm
+  libbdb(mfilename, varargin{:});
+end
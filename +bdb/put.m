@@ -1,8 +1,10 @@
-function put(varargin)
+function varargout = put(varargin)
 %PUT Store a key-value pair.
 %
 %    bdb.put(key, value)
 %    bdb.put(id, key, value, ...)
+%    new_key = bdb.put(id, [], value, 'Append', true)
+%    bdb.put(id, key, slice, 'At', offset)
 %
 % The function stores a value for the given key in the specified database
 % session. When the id is omitted, the default session is used.
@@ -10,6 +12,10 @@ function put(varargin)
 % The key and the value must be an ordinary object. When there is an existing
 % entry for the given key, the entry will be overwritten.
 %
+% Keys of a queue or recno database are positive record numbers, and keys of
+% a heap database are record ids [pgno, indx]. With the Append option, the
+% key argument is ignored for these types and the assigned key is returned.
+%
 % ## Options
 %
 % _Transaction_ [0]
@@ -45,6 +51,21 @@ function put(varargin)
 % Ignore duplicate records when overwriting records in a database configured
 % for sorted duplicates.
 %
+% _At_ [-1]
+%
+% Overwrite elements of a value stored with the native codec from the given
+% zero-based element offset. Only the given bytes are written to the database.
+% The slice must be of the same class as the stored value and must fit within
+% it. The size of the stored value does not change. A value kept in the value
+% log is read, modified and appended to the log again whole.
+%
+% Example:
+%
+%    id = bdb.open('test.db', 'Codec', 'native');
+%    bdb.put(id, 'signal', zeros(1e6, 1));
+%    bdb.put(id, 'signal', [1; 2; 3], 'At', 1000);
+%    slice = bdb.get(id, 'signal', 'Range', [999, 5]);
+%
 % See also bdb.get bdb.delete
-  libbdb(mfilename, varargin{:});
+  [varargout{1:nargout}] = libbdb(mfilename, varargin{:});
 end
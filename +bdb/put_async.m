@@ -0,0 +1,17 @@
+function handle = put_async(varargin)
+%PUT_ASYNC Store a key-value pair in the background.
+%
+%    handle = bdb.put_async(key, value)
+%    handle = bdb.put_async(id, key, value)
+%
+% The function encodes the record, queues the write to the worker threads of
+% the database and returns a handle immediately. Use bdb.wait to make sure
+% the write is finished and to raise its error if any. The database must be
+% opened with the _Thread_ option. In a transactional environment, the write
+% is committed on its own. Queued operations run on several threads in no
+% particular order, even for the same key; wait for a put before queueing a
+% get or another put that must follow it.
+%
+% See also bdb.wait bdb.poll bdb.wait_any bdb.get_async
+  handle = libbdb(mfilename, varargin{:});
+end
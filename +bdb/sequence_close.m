@@ -0,0 +1,11 @@
+function sequence_close(sequence_id)
+%SEQUENCE_CLOSE Close a sequence.
+%
+%    bdb.sequence_close(sequence_id)
+%
+% The function closes the sequence handle. The sequence itself remains in the
+% database.
+%
+% See also bdb.sequence_open bdb.sequence_next
+  libbdb(mfilename, sequence_id);
+end
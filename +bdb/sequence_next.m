@@ -0,0 +1,12 @@
+function values = sequence_next(sequence_id, varargin)
+%SEQUENCE_NEXT Get next values of a sequence.
+%
+%    values = bdb.sequence_next(sequence_id)
+%    values = bdb.sequence_next(sequence_id, count)
+%
+% The function reserves count consecutive values of the sequence and returns
+% them in an int64 column vector. By default, count is 1.
+%
+% See also bdb.sequence_open bdb.sequence_close
+  values = libbdb(mfilename, sequence_id, varargin{:});
+end
@@ -0,0 +1,46 @@
+function sequence_id = sequence_open(varargin)
+%SEQUENCE_OPEN Open a persistent sequence of unique integers.
+%
+%    sequence_id = bdb.sequence_open(name, ...)
+%    sequence_id = bdb.sequence_open(id, name, ...)
+%
+% The function opens a sequence stored as the record of the given name in the
+% database, and returns a sequence id for bdb.sequence_next. Values are
+% generated atomically across processes sharing the database. Because the
+% sequence record is not an ordinary value, keep sequences in a database of
+% their own when using bdb.values on it. Sequences are closed with the
+% database. When the id is omitted, the default session is used.
+%
+% ## Options
+%
+% _CacheSize_ [0]
+%
+% Number of values reserved by the handle at once. With a cache, most calls
+% to bdb.sequence_next return without touching the database. Values reserved
+% but not returned are skipped when the handle is closed.
+%
+% _Initial_ [0]
+%
+% First value of a newly created sequence.
+%
+% _Create_ [true]
+%
+% Create the sequence if not existing.
+%
+% _Excl_ [false]
+%
+% Return an error if the sequence already exists.
+%
+% _Transaction_ [0]
+%
+% Transaction in which to open the sequence.
+%
+% Example:
+%
+% >> sequence_id = bdb.sequence_open(id, 'job_id', 'CacheSize', 1000);
+% >> ids = bdb.sequence_next(sequence_id, 100);
+% >> bdb.sequence_close(sequence_id);
+%
+% See also bdb.sequence_next bdb.sequence_close
+  sequence_id = libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,10 @@
+function sharded_delete(varargin)
+%SHARDED_DELETE Delete an entry from a sharded database.
+%
+%    bdb.sharded_delete(id, key)
+%
+% The function deletes an entry in the shard of the key.
+%
+% See also bdb.open_sharded bdb.sharded_put
+  libbdb(mfilename, varargin{:});
+end
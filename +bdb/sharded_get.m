@@ -0,0 +1,11 @@
+function value = sharded_get(varargin)
+%SHARDED_GET Retrieve a value from a sharded database.
+%
+%    value = bdb.sharded_get(id, key)
+%
+% The function retrieves an entry from the shard of the key. The value is []
+% when the key is not found.
+%
+% See also bdb.open_sharded bdb.sharded_mget
+  value = libbdb(mfilename, varargin{:});
+end
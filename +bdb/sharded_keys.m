@@ -0,0 +1,18 @@
+function keys = sharded_keys(varargin)
+%SHARDED_KEYS Return a list of keys in a sharded database.
+%
+%    keys = bdb.sharded_keys(id, ...)
+%
+% The function scans all shards in parallel threads and returns the keys as
+% a column cell array.
+%
+% ## Options
+%
+% _Ordered_ [false]
+%
+% Merge the shards in the order of encoded keys, the same order as bdb.keys
+% of a single btree database. Otherwise, keys are grouped by shard.
+%
+% See also bdb.open_sharded bdb.sharded_values
+  keys = libbdb(mfilename, varargin{:});
+end
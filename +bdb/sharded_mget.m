@@ -0,0 +1,12 @@
+function values = sharded_mget(varargin)
+%SHARDED_MGET Retrieve values of multiple keys from a sharded database.
+%
+%    values = bdb.sharded_mget(id, keys)
+%
+% The function groups a cell array of keys by shard and reads the shards in
+% parallel threads. The result is a cell array of the same size as keys,
+% where missing keys give [].
+%
+% See also bdb.open_sharded bdb.sharded_get
+  values = libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,10 @@
+function sharded_put(varargin)
+%SHARDED_PUT Store a key-value pair in a sharded database.
+%
+%    bdb.sharded_put(id, key, value)
+%
+% The function stores an entry in the shard of the key.
+%
+% See also bdb.open_sharded bdb.sharded_get
+  libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,18 @@
+function values = sharded_values(varargin)
+%SHARDED_VALUES Return a list of values in a sharded database.
+%
+%    values = bdb.sharded_values(id, ...)
+%
+% The function scans all shards in parallel threads and returns the values
+% as a column cell array, in the same order as bdb.sharded_keys with the
+% same options.
+%
+% ## Options
+%
+% _Ordered_ [false]
+%
+% Merge the shards in the order of encoded keys.
+%
+% See also bdb.open_sharded bdb.sharded_keys
+  values = libbdb(mfilename, varargin{:});
+end
@@ -7,7 +7,9 @@ function result = stat(varargin)
 % The function retrieves statistics of the specified database session. When
 % the id is omitted, the default session is used.
 %
-% The result is a struct array.
+% The result is a struct array. When the database is opened with a non-zero
+% _ValueCacheSize_, the result also contains value_cache_* fields reporting
+% the capacity, current size, hits, misses and evictions of the value cache.
 %
 % ## Options
 %
@@ -28,6 +30,6 @@ function result = stat(varargin)
 % Database items read during a transactional call will have degree 1 isolation,
 % including modified but not yet committed data.
 %
-% See also bdb.open bdb.close
+% See also bdb.open bdb.close bdb.env_stat
   result = libbdb(mfilename, varargin{:});
 end
@@ -0,0 +1,12 @@
+function stream_close(stream_id)
+%STREAM_CLOSE Close a stream.
+%
+%    bdb.stream_close(stream_id)
+%
+% The function closes a stream. For a stream opened for writing, the last
+% partial chunk and the manifest are stored. A write stream that is never
+% closed leaves no value for the key.
+%
+% See also bdb.stream_open bdb.stream_write bdb.stream_read
+  libbdb(mfilename, stream_id);
+end
@@ -0,0 +1,38 @@
+function stream_id = stream_open(id, key, mode, varargin)
+%STREAM_OPEN Open a chunked value for sequential writing or reading.
+%
+%    stream_id = bdb.stream_open(id, key, 'w', ...)
+%    stream_id = bdb.stream_open(id, key, 'r')
+%
+% The function opens a stream of elements stored for the key. A stream holds
+% a long sequence of elements of one numeric, logical or char class in
+% compressed chunk records of a companion database, e.g., data.bdb.stream,
+% so that writing and reading never keep more than one chunk in memory.
+%
+% Opening for writing ('w') writes chunks of a new generation and leaves the
+% existing value of the key readable. The stream replaces the value when
+% bdb.stream_close stores its manifest under the key and drops the old
+% chunks; bdb.get on the key returns the manifest struct, and bdb.put or
+% bdb.delete on the key removes the chunks in the same transaction. Opening for reading ('r') starts at the first
+% element.
+%
+% ## Options
+%
+% _ChunkSize_ [1048576]
+%
+% Bytes of elements per chunk record when writing.
+%
+% Example:
+%
+% >> stream_id = bdb.stream_open(id, 'recording', 'w');
+% >> for i = 1:100
+% >>   bdb.stream_write(stream_id, int16(randn(1e6, 1) * 1000));
+% >> end
+% >> bdb.stream_close(stream_id);
+% >> stream_id = bdb.stream_open(id, 'recording', 'r');
+% >> samples = bdb.stream_read(stream_id, 44100);
+% >> bdb.stream_close(stream_id);
+%
+% See also bdb.stream_write bdb.stream_read bdb.stream_close
+  stream_id = libbdb(mfilename, id, key, mode, varargin{:});
+end
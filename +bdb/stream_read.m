@@ -0,0 +1,14 @@
+function elements = stream_read(stream_id, varargin)
+%STREAM_READ Read elements from a stream.
+%
+%    elements = bdb.stream_read(stream_id)
+%    elements = bdb.stream_read(stream_id, count)
+%
+% The function reads up to count elements from a stream opened for reading
+% and returns them in a column vector of the class of the stream. When count
+% is omitted, all remaining elements are read. An empty array is returned at
+% the end of the stream.
+%
+% See also bdb.stream_open bdb.stream_write bdb.stream_close
+  elements = libbdb(mfilename, stream_id, varargin{:});
+end
@@ -0,0 +1,13 @@
+function stream_write(stream_id, elements)
+%STREAM_WRITE Append elements to a stream.
+%
+%    bdb.stream_write(stream_id, elements)
+%
+% The function appends the elements of a real numeric, logical or char array
+% in column-major order to a stream opened for writing. Every call must pass
+% the class of the first call. Full chunks are compressed and stored as soon
+% as they are filled.
+%
+% See also bdb.stream_open bdb.stream_read bdb.stream_close
+  libbdb(mfilename, stream_id, elements);
+end
@@ -0,0 +1,30 @@
+function stats = vlog_gc(varargin)
+%VLOG_GC Reclaim space of dead values in a value log.
+%
+%    stats = bdb.vlog_gc(...)
+%    stats = bdb.vlog_gc(id, ...)
+%
+% The function scans value log files of a database opened with the _ValueLog_
+% option, except for the file being appended. When the ratio of overwritten
+% or deleted values in a file reaches _MinGarbage_, the live values are
+% appended to the current file, their pointers are updated, and the old file
+% is deleted. When the id is omitted, the default session is used. The
+% function returns a struct with the number of deleted files in _segments_
+% and the number of freed bytes in _reclaimed_.
+%
+% ## Options
+%
+% _MinGarbage_ [0.5]
+%
+% Minimum ratio of dead bytes in a file to rewrite it. 0 rewrites every file.
+%
+% Example:
+%
+%    id = bdb.open('test.db', 'ValueLog', 4096);
+%    bdb.put(id, 'image', rand(1000));
+%    bdb.put(id, 'image', rand(1000));
+%    stats = bdb.vlog_gc(id, 'MinGarbage', 0.25);
+%
+% See also bdb.open
+  stats = libbdb(mfilename, varargin{:});
+end
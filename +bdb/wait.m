@@ -0,0 +1,13 @@
+function value = wait(varargin)
+%WAIT Wait for an asynchronous operation and collect its result.
+%
+%    value = bdb.wait(handle)
+%
+% The function blocks until the operation is finished, releases the handle
+% and returns the result: a value for bdb.get_async, a cell array of values
+% for bdb.mget_async, and [] for bdb.put_async. An error of the
+% operation is raised here.
+%
+% See also bdb.poll bdb.wait_any bdb.get_async bdb.put_async bdb.mget_async
+  value = libbdb(mfilename, varargin{:});
+end
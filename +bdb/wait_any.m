@@ -0,0 +1,27 @@
+function index = wait_any(varargin)
+%WAIT_ANY Wait for any of asynchronous operations to finish.
+%
+%    index = bdb.wait_any(handles, ...)
+%
+% The function blocks until one of the operations is finished and returns its
+% index in the handles. The result is not collected; call bdb.wait on the
+% finished handle. The function returns 0 on timeout.
+%
+% ## Options
+%
+% _Timeout_ [-1]
+%
+% Maximum seconds to wait. Negative value waits forever.
+%
+% Example:
+%
+% >> handles = cellfun(@(key)bdb.get_async(id, key), keys);
+% >> while ~isempty(handles)
+%      index = bdb.wait_any(handles);
+%      value = bdb.wait(handles(index));
+%      handles(index) = [];
+%    end
+%
+% See also bdb.wait bdb.poll
+  index = libbdb(mfilename, varargin{:});
+end
@@ -0,0 +1,35 @@
+function num_pages = warm(varargin)
+%WARM Preload database pages into the buffer pool.
+%
+%    num_pages = bdb.warm(...)
+%    num_pages = bdb.warm(id, ...)
+%
+% The function descends the btree from its root and keeps the interior pages
+% in the buffer pool with the highest priority, so that later random reads
+% only need to fetch leaf pages. Leaf pages are not read. With the _Full_
+% option, the function instead reads every page of the file in sequential
+% order. Only btree and recno databases are supported. Pages are parsed in the
+% on-disk format of Berkeley DB 4.8 to 6.2, so the function fails on other
+% library versions and on encrypted databases. When the id is omitted, the
+% default session is used. The function returns the number of pages read.
+%
+% The buffer pool must be large enough to hold the pages. See the _CacheSize_
+% option of bdb.env_open and bdb.open.
+%
+% In an environment, the kept pages are remembered and can be saved with the
+% _WarmList_ option of bdb.env_close, then loaded in sequential order with
+% the _WarmList_ option of bdb.env_open after a restart.
+%
+% ## Options
+%
+% _Full_ [false]
+%
+% Keep every page of the file instead of only the interior pages.
+%
+% _MaxPages_ [0]
+%
+% If non-zero, stop after reading the specified number of pages.
+%
+% See also bdb.env_open bdb.env_close bdb.env_stat
+  num_pages = libbdb(mfilename, varargin{:});
+end
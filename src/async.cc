@@ -0,0 +1,138 @@
+/// Asynchronous operations for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "async.h"
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+using std::string;
+using std::vector;
+
+namespace bdbmex {
+
+/// Lock of the finished flags of all operations.
+static Mutex completion_mutex;
+
+/// Signaled whenever any operation finishes.
+static Condition completion_condition;
+
+/// Current time in seconds.
+static double now() {
+  struct timeval time;
+  gettimeofday(&time, NULL);
+  return time.tv_sec + time.tv_usec * 1e-6;
+}
+
+AsyncOperation::AsyncOperation() : database_(NULL),
+                                   type_(GET),
+                                   pending_writes_(NULL),
+                                   code_(0),
+                                   done_(true) {}
+
+AsyncOperation::~AsyncOperation() {
+  wait();
+}
+
+void AsyncOperation::reset(DB* database,
+                           Type type,
+                           Counter* pending_writes) {
+  wait();
+  database_ = database;
+  type_ = type;
+  pending_writes_ = (type == PUT) ? pending_writes : NULL;
+  keys_.clear();
+  values_.clear();
+  codes_.clear();
+  code_ = 0;
+}
+
+void AsyncOperation::add(const string& key, const string& value) {
+  keys_.push_back(key);
+  values_.push_back((type_ == PUT) ? value : string());
+  codes_.push_back(0);
+}
+
+void AsyncOperation::submit() {
+  if (pending_writes_)
+    pending_writes_->increment();
+  MutexLock lock(&completion_mutex);
+  done_ = false;
+}
+
+void AsyncOperation::fail(int code) {
+  code_ = code;
+  finish();
+}
+
+void AsyncOperation::run() {
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.flags = DB_DBT_USERMEM;
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    key.data = const_cast<char*>(keys_[i].data());
+    key.size = keys_[i].size();
+    key.ulen = keys_[i].size();
+    if (type_ == PUT) {
+      value.flags = DB_DBT_USERMEM;
+      value.data = const_cast<char*>(values_[i].data());
+      value.size = values_[i].size();
+      value.ulen = values_[i].size();
+      codes_[i] = database_->put(database_, NULL, &key, &value, 0);
+    }
+    else {
+      value.flags = DB_DBT_REALLOC;
+      codes_[i] = database_->get(database_, NULL, &key, &value, 0);
+      if (codes_[i] == 0)
+        values_[i].assign(static_cast<const char*>(value.data), value.size);
+    }
+    if (codes_[i] != 0 && codes_[i] != DB_NOTFOUND && code_ == 0)
+      code_ = codes_[i];
+  }
+  if (type_ != PUT && value.data)
+    free(value.data);
+  finish();
+}
+
+bool AsyncOperation::done() {
+  MutexLock lock(&completion_mutex);
+  return done_;
+}
+
+void AsyncOperation::wait() {
+  MutexLock lock(&completion_mutex);
+  while (!done_)
+    completion_condition.wait(&completion_mutex);
+}
+
+int AsyncOperation::wait_any(const vector<AsyncOperation*>& operations,
+                             double timeout) {
+  double deadline = now() + timeout;
+  MutexLock lock(&completion_mutex);
+  while (true) {
+    for (size_t i = 0; i < operations.size(); ++i)
+      if (operations[i]->done_)
+        return i;
+    if (timeout < 0)
+      completion_condition.wait(&completion_mutex);
+    else if (deadline <= now() ||
+             !completion_condition.wait(&completion_mutex, deadline - now()))
+      break;
+  }
+  for (size_t i = 0; i < operations.size(); ++i)
+    if (operations[i]->done_)
+      return i;
+  return -1;
+}
+
+void AsyncOperation::finish() {
+  if (pending_writes_)
+    pending_writes_->decrement();
+  MutexLock lock(&completion_mutex);
+  done_ = true;
+  completion_condition.broadcast();
+}
+
+} // namespace bdbmex
@@ -0,0 +1,87 @@
+/// Asynchronous operations for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __ASYNC_H__
+#define __ASYNC_H__
+
+#include <db.h>
+#include <string>
+#include <vector>
+#include "thread.h"
+
+namespace bdbmex {
+
+/// Database operation run by a thread pool on encoded records. Results are
+/// kept as raw bytes and decoded on the matlab thread after completion.
+class AsyncOperation : public Task {
+public:
+  /// Kind of operation.
+  enum Type { GET, PUT, MGET };
+  /// Create a finished empty operation.
+  AsyncOperation();
+  /// Wait for completion.
+  virtual ~AsyncOperation();
+  /// Prepare a new operation. A put decrements pending_writes on completion.
+  void reset(DB* database, Type type, Counter* pending_writes);
+  /// Add an encoded record. The value is ignored unless the type is PUT.
+  void add(const std::string& key, const std::string& value);
+  /// Mark the operation as queued.
+  void submit();
+  /// Mark the operation as finished with the error code.
+  void fail(int code);
+  /// Run the operation in a worker thread.
+  virtual void run();
+  /// Return if the operation is finished.
+  bool done();
+  /// Block until the operation is finished.
+  void wait();
+  /// Block until any of the operations is finished, at most timeout seconds
+  /// unless negative. Return the index of a finished operation, or -1.
+  static int wait_any(const std::vector<AsyncOperation*>& operations,
+                      double timeout);
+  /// Type of the operation.
+  Type type() const { return type_; }
+  /// Database handle of the operation.
+  DB* database() const { return database_; }
+  /// Number of records.
+  size_t size() const { return keys_.size(); }
+  /// Return code of the i-th record.
+  int code(size_t i) const { return codes_[i]; }
+  /// Encoded value of the i-th record.
+  const std::string& value(size_t i) const { return values_[i]; }
+  /// Encoded key of the i-th record.
+  const std::string& key(size_t i) const { return keys_[i]; }
+  /// Return the first error code other than DB_NOTFOUND.
+  int error_code() const { return code_; }
+  /// Return the last error message.
+  const char* error_message() const { return db_strerror(code_); }
+
+private:
+  /// Copy prohibited.
+  AsyncOperation(const AsyncOperation&);
+  AsyncOperation& operator=(const AsyncOperation&);
+  /// Set the finished flag and wake up waiters.
+  void finish();
+
+  /// Database handle.
+  DB* database_;
+  /// Kind of operation.
+  Type type_;
+  /// Counter of unfinished writes of the database, or NULL.
+  Counter* pending_writes_;
+  /// Encoded keys.
+  std::vector<std::string> keys_;
+  /// Encoded values to store or retrieved values.
+  std::vector<std::string> values_;
+  /// Return codes of records.
+  std::vector<int> codes_;
+  /// First error code.
+  int code_;
+  /// Finished flag, guarded by the shared completion lock.
+  bool done_;
+};
+
+} // namespace bdbmex
+
+#endif // __ASYNC_H__
@@ -0,0 +1,213 @@
+/// Berkeley DB asynchronous operation mex interface.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "libbdbmex.h"
+#include "mex/arguments.h"
+#include "mex/function.h"
+#include "mex/mxarray.h"
+
+using bdbmex::AsyncOperation;
+using bdbmex::Database;
+using bdbmex::Record;
+using mex::CheckInputArguments;
+using mex::CheckOutputArguments;
+using mex::MxArray;
+using mex::Session;
+using mex::VariableInputArguments;
+
+namespace {
+
+/// Get a free-threaded database from the leading arguments. The id is
+/// omitted when the number of arguments equals num_args.
+Database* GetThreadedDatabase(int nrhs,
+                              const mxArray *prhs[],
+                              int num_args,
+                              const mxArray*** args) {
+  Database* database = NULL;
+  if (nrhs == num_args) {
+    database = Session<Database>::get(0);
+    *args = prhs;
+  }
+  else {
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    *args = prhs + 1;
+  }
+  if (!database)
+    ERROR("No open database found.");
+  if (!database->is_threaded())
+    ERROR("Asynchronous operations require a database opened with the "
+          "Thread option.");
+  return database;
+}
+
+/// Find the open database of an operation, or NULL if it is closed.
+Database* FindDatabase(const AsyncOperation& operation) {
+  std::vector<int> database_ids;
+  Session<Database>::ids(&database_ids);
+  for (size_t i = 0; i < database_ids.size(); ++i) {
+    Database* database = Session<Database>::get(database_ids[i]);
+    if (database && database->handle() == operation.database())
+      return database;
+  }
+  return NULL;
+}
+
+/// Decode the i-th retrieved value of a finished operation. Return NULL and
+/// set the error message on failure.
+mxArray* DecodeValue(const AsyncOperation& operation,
+                     size_t i,
+                     Database* database,
+                     string* error_message) {
+  if (operation.code(i) == DB_NOTFOUND)
+    return mxCreateDoubleMatrix(0, 0, mxREAL);
+  mxArray* value = NULL;
+  if (!Record::decode_value(operation.value(i).data(),
+                            operation.value(i).size(),
+                            (database) ? database->value_log() : NULL,
+                            &value,
+                            error_message))
+    return NULL;
+  return value;
+}
+
+MEX_FUNCTION(get_async) (int nlhs,
+                         mxArray *plhs[],
+                         int nrhs,
+                         const mxArray *prhs[]) {
+  CheckInputArguments(1, 2, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  const mxArray** args = NULL;
+  Database* database = GetThreadedDatabase(nrhs, prhs, 1, &args);
+  AsyncOperation* operation = NULL;
+  int operation_id = Session<AsyncOperation>::create(&operation);
+  if (!database->get_async(args[0], operation)) {
+    Session<AsyncOperation>::destroy(operation_id);
+    ERROR("Failed to queue a get: %s", database->error_message());
+  }
+  plhs[0] = MxArray(operation_id).getMutable();
+}
+
+MEX_FUNCTION(put_async) (int nlhs,
+                         mxArray *plhs[],
+                         int nrhs,
+                         const mxArray *prhs[]) {
+  CheckInputArguments(2, 3, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  const mxArray** args = NULL;
+  Database* database = GetThreadedDatabase(nrhs, prhs, 2, &args);
+  AsyncOperation* operation = NULL;
+  int operation_id = Session<AsyncOperation>::create(&operation);
+  if (!database->put_async(args[0], args[1], operation)) {
+    Session<AsyncOperation>::destroy(operation_id);
+    ERROR("Failed to queue a put: %s", database->error_message());
+  }
+  plhs[0] = MxArray(operation_id).getMutable();
+}
+
+MEX_FUNCTION(mget_async) (int nlhs,
+                          mxArray *plhs[],
+                          int nrhs,
+                          const mxArray *prhs[]) {
+  CheckInputArguments(1, 2, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  const mxArray** args = NULL;
+  Database* database = GetThreadedDatabase(nrhs, prhs, 1, &args);
+  AsyncOperation* operation = NULL;
+  int operation_id = Session<AsyncOperation>::create(&operation);
+  if (!database->mget_async(args[0], operation)) {
+    Session<AsyncOperation>::destroy(operation_id);
+    ERROR("Failed to queue a get: %s", database->error_message());
+  }
+  plhs[0] = MxArray(operation_id).getMutable();
+}
+
+MEX_FUNCTION(wait) (int nlhs,
+                    mxArray *plhs[],
+                    int nrhs,
+                    const mxArray *prhs[]) {
+  CheckInputArguments(1, 1, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  int operation_id = MxArray(prhs[0]).toInt();
+  AsyncOperation* operation = Session<AsyncOperation>::get(operation_id);
+  if (!operation)
+    ERROR("No asynchronous operation found.");
+  operation->wait();
+  int code = operation->error_code();
+  if (code != 0) {
+    Session<AsyncOperation>::destroy(operation_id);
+    ERROR("Asynchronous operation failed: %s", db_strerror(code));
+  }
+  // Logged values are read from the value log of the database, and the
+  // operation is destroyed before a decoding error is raised.
+  Database* database = FindDatabase(*operation);
+  string error_message;
+  mxArray* output = NULL;
+  if (operation->type() == AsyncOperation::GET) {
+    output = DecodeValue(*operation, 0, database, &error_message);
+  }
+  else if (operation->type() == AsyncOperation::MGET) {
+    output = mxCreateCellMatrix(operation->size(), 1);
+    for (size_t i = 0; output && i < operation->size(); ++i) {
+      mxArray* value = DecodeValue(*operation, i, database, &error_message);
+      if (value == NULL) {
+        mxDestroyArray(output);
+        output = NULL;
+        break;
+      }
+      mxSetCell(output, i, value);
+    }
+  }
+  else
+    output = mxCreateDoubleMatrix(0, 0, mxREAL);
+  Session<AsyncOperation>::destroy(operation_id);
+  if (output == NULL)
+    ERROR("Failed to decode a value: %s", (error_message.empty()) ?
+          "Null pointer exception." : error_message.c_str());
+  plhs[0] = output;
+}
+
+MEX_FUNCTION(poll) (int nlhs,
+                    mxArray *plhs[],
+                    int nrhs,
+                    const mxArray *prhs[]) {
+  CheckInputArguments(1, 1, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  std::vector<int> operation_ids;
+  MxArray(prhs[0]).toVector<int>(&operation_ids);
+  std::vector<bool> finished(operation_ids.size());
+  for (size_t i = 0; i < operation_ids.size(); ++i) {
+    AsyncOperation* operation = Session<AsyncOperation>::get(
+        operation_ids[i]);
+    if (!operation)
+      ERROR("No asynchronous operation found.");
+    finished[i] = operation->done();
+  }
+  plhs[0] = MxArray(finished).getMutable();
+}
+
+MEX_FUNCTION(wait_any) (int nlhs,
+                        mxArray *plhs[],
+                        int nrhs,
+                        const mxArray *prhs[]) {
+  CheckInputArguments(1, 3, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Timeout", -1.0);
+  options.update(prhs + 1, prhs + nrhs);
+  std::vector<int> operation_ids;
+  MxArray(prhs[0]).toVector<int>(&operation_ids);
+  std::vector<AsyncOperation*> operations(operation_ids.size());
+  for (size_t i = 0; i < operation_ids.size(); ++i) {
+    operations[i] = Session<AsyncOperation>::get(operation_ids[i]);
+    if (!operations[i])
+      ERROR("No asynchronous operation found.");
+  }
+  if (operations.empty())
+    ERROR("No asynchronous operation specified.");
+  int index = AsyncOperation::wait_any(operations,
+                                       options["Timeout"].toDouble());
+  plhs[0] = MxArray(index + 1).getMutable();
+}
+
+} // namespace
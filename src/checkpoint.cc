@@ -0,0 +1,53 @@
+/// Background checkpoint for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "checkpoint.h"
+
+namespace bdbmex {
+
+Checkpointer::Checkpointer(DB_ENV* environment, double interval) :
+    environment_(environment),
+    interval_(interval),
+    count_(0),
+    code_(0),
+    stopping_(false) {}
+
+Checkpointer::~Checkpointer() {
+  {
+    MutexLock lock(&mutex_);
+    stopping_ = true;
+    condition_.broadcast();
+  }
+  join();
+}
+
+int Checkpointer::count() {
+  MutexLock lock(&mutex_);
+  return count_;
+}
+
+int Checkpointer::error_code() {
+  MutexLock lock(&mutex_);
+  return code_;
+}
+
+void Checkpointer::run() {
+  while (true) {
+    {
+      MutexLock lock(&mutex_);
+      // Spurious wake-ups only shorten one interval.
+      if (!stopping_)
+        condition_.wait(&mutex_, interval_);
+      if (stopping_)
+        break;
+    }
+    int code = environment_->txn_checkpoint(environment_, 0, 0, 0);
+    MutexLock lock(&mutex_);
+    code_ = code;
+    if (code == 0)
+      ++count_;
+  }
+}
+
+} // namespace bdbmex
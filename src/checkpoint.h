@@ -0,0 +1,50 @@
+/// Background checkpoint for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <db.h>
+#include "thread.h"
+
+namespace bdbmex {
+
+/// Background thread that checkpoints a transactional environment at a fixed
+/// interval, so that recovery only replays logs written since the last
+/// checkpoint. The environment must be opened with DB_THREAD.
+class Checkpointer : public Thread {
+public:
+  /// Create a checkpointer of the environment running every given seconds.
+  Checkpointer(DB_ENV* environment, double interval);
+  /// Stop and join the thread.
+  virtual ~Checkpointer();
+  /// Number of checkpoints taken.
+  int count();
+  /// Return code of the last checkpoint.
+  int error_code();
+
+protected:
+  /// Checkpoint periodically until stopped.
+  virtual void run();
+
+private:
+  /// Environment handle.
+  DB_ENV* environment_;
+  /// Interval in seconds.
+  double interval_;
+  /// Lock of the state.
+  Mutex mutex_;
+  /// Signaled when stopped.
+  Condition condition_;
+  /// Number of checkpoints taken.
+  int count_;
+  /// Return code of the last checkpoint.
+  int code_;
+  /// Stop flag.
+  bool stopping_;
+};
+
+} // namespace bdbmex
+
+#endif // __CHECKPOINT_H__
@@ -13,6 +13,7 @@ using mex::CheckInputArguments;
 using mex::CheckOutputArguments;
 using mex::MxArray;
 using mex::Session;
+using mex::VariableInputArguments;
 
 namespace {
 
@@ -20,13 +21,23 @@ MEX_FUNCTION(cursor_open) (int nlhs,
                            mxArray *plhs[],
                            int nrhs,
                            const mxArray *prhs[]) {
-  CheckInputArguments(0, 1, nrhs);
+  CheckInputArguments(0, 1024, nrhs);
   CheckOutputArguments(0, 1, nlhs);
-  int database_id = (nrhs == 0) ? 0 : MxArray(prhs[0]).toInt();
+  VariableInputArguments options;
+  options.set("Prefetch", 0);
+  options.set("KeysOnly", false);
+  int database_id = (nrhs == 0 || !MxArray(prhs[0]).isNumeric()) ?
+      0 : MxArray(prhs[0]).toInt();
   Database* database = Session<Database>::get(database_id);
+  options.update(prhs, prhs + nrhs);
+  int prefetch = options["Prefetch"].toInt();
+  if (prefetch < 0)
+    ERROR("Prefetch must be non-negative: %d", prefetch);
+  if (prefetch > 0 && !database->is_threaded())
+    ERROR("Prefetch requires a database opened with the Thread option.");
   Cursor* cursor = NULL;
   int cursor_id = Session<Cursor>::create(&cursor);
-  if (!database->cursor(cursor)) {
+  if (!database->cursor(cursor, prefetch, options["KeysOnly"].toBool())) {
     Session<Cursor>::destroy(cursor_id);
     ERROR("Unable to open cursor for database: %d", database_id);
   }
@@ -0,0 +1,543 @@
+/// Chunked N-D array dataset for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "dataset.h"
+#include "mex/mxarray.h"
+#include "stream.h"
+#include <cerrno>
+#include <cstring>
+
+using mex::MxArray;
+
+namespace mex {
+
+template class Session<bdbmex::Dataset>;
+
+}
+
+namespace bdbmex {
+
+/// Number of worker threads of chunk coding.
+static const int kDatasetThreads = 4;
+
+/// Maximum number of chunks held in memory at once.
+static const size_t kDatasetBatch = 64;
+
+/// Copy a box of the given extent between two column-major arrays. Safe to
+/// call from a background thread.
+static void copy_box(const char* source,
+                     const vector<uint64_t>& source_size,
+                     const vector<uint64_t>& source_origin,
+                     char* target,
+                     const vector<uint64_t>& target_size,
+                     const vector<uint64_t>& target_origin,
+                     const vector<uint64_t>& extent,
+                     size_t element_size) {
+  size_t num_dimensions = extent.size();
+  for (size_t i = 0; i < num_dimensions; ++i)
+    if (extent[i] == 0)
+      return;
+  // Copy contiguous runs along the first dimension.
+  vector<uint64_t> index(num_dimensions, 0);
+  while (true) {
+    uint64_t source_offset = 0, target_offset = 0;
+    uint64_t source_stride = 1, target_stride = 1;
+    for (size_t i = 0; i < num_dimensions; ++i) {
+      source_offset += (source_origin[i] + index[i]) * source_stride;
+      target_offset += (target_origin[i] + index[i]) * target_stride;
+      source_stride *= source_size[i];
+      target_stride *= target_size[i];
+    }
+    memcpy(target + target_offset * element_size,
+           source + source_offset * element_size,
+           extent[0] * element_size);
+    size_t dimension = 1;
+    while (dimension < num_dimensions &&
+           ++index[dimension] == extent[dimension])
+      index[dimension++] = 0;
+    if (dimension >= num_dimensions)
+      break;
+  }
+}
+
+/// Intersection of a chunk and a hyperslab.
+struct ChunkRegion {
+  /// Origin of the intersection in the chunk.
+  vector<uint64_t> chunk_origin;
+  /// Origin of the intersection in the hyperslab.
+  vector<uint64_t> slab_origin;
+  /// Size of the intersection.
+  vector<uint64_t> extent;
+  /// Whether the intersection covers the whole chunk.
+  bool full;
+};
+
+/// Compute the intersection of a chunk and a hyperslab.
+static void intersect(const vector<uint64_t>& coordinates,
+                      const vector<uint64_t>& chunk,
+                      const vector<uint64_t>& start,
+                      const vector<uint64_t>& count,
+                      ChunkRegion* region) {
+  size_t num_dimensions = coordinates.size();
+  region->chunk_origin.resize(num_dimensions);
+  region->slab_origin.resize(num_dimensions);
+  region->extent.resize(num_dimensions);
+  region->full = true;
+  for (size_t i = 0; i < num_dimensions; ++i) {
+    uint64_t chunk_start = coordinates[i] * chunk[i];
+    uint64_t first = max(start[i], chunk_start);
+    uint64_t last = min(start[i] + count[i], chunk_start + chunk[i]);
+    region->chunk_origin[i] = first - chunk_start;
+    region->slab_origin[i] = first - start[i];
+    region->extent[i] = last - first;
+    region->full = region->full && (region->extent[i] == chunk[i]);
+  }
+}
+
+/// Task decoding a chunk record into the hyperslab of the output.
+class ReadChunkTask : public Task {
+public:
+  /// Create a task copying the region of a raw chunk into the output.
+  ReadChunkTask(const vector<uint64_t>& chunk,
+                size_t element_size,
+                char* output,
+                const vector<uint64_t>& output_size) :
+      chunk_(chunk),
+      element_size_(element_size),
+      output_(output),
+      output_size_(output_size),
+      found_(false),
+      failed_(false) {}
+  /// Decode and copy. A missing chunk leaves zeros in the output.
+  virtual void run() {
+    if (!found_)
+      return;
+    string data;
+    uint64_t chunk_bytes = element_size_;
+    for (size_t i = 0; i < chunk_.size(); ++i)
+      chunk_bytes *= chunk_[i];
+    if (!decode_chunk(record_, &data) || data.size() != chunk_bytes) {
+      failed_ = true;
+      return;
+    }
+    copy_box(data.data(),
+             chunk_,
+             region_.chunk_origin,
+             output_,
+             output_size_,
+             region_.slab_origin,
+             region_.extent,
+             element_size_);
+  }
+  /// Raw chunk record.
+  string* record() { return &record_; }
+  /// Region to copy.
+  ChunkRegion* region() { return &region_; }
+  /// Set if the chunk record exists.
+  void set_found(bool found) { found_ = found; }
+  /// Return if the chunk record is corrupted.
+  bool failed() const { return failed_; }
+
+private:
+  /// Size of a chunk.
+  const vector<uint64_t>& chunk_;
+  /// Bytes per element.
+  size_t element_size_;
+  /// Output data.
+  char* output_;
+  /// Size of the output.
+  const vector<uint64_t>& output_size_;
+  /// Raw chunk record.
+  string record_;
+  /// Region to copy.
+  ChunkRegion region_;
+  /// Chunk record exists.
+  bool found_;
+  /// Decoding failure.
+  bool failed_;
+};
+
+/// Task merging the hyperslab of the input into a chunk record.
+class WriteChunkTask : public Task {
+public:
+  /// Create a task copying the region of the input into a chunk.
+  WriteChunkTask(const vector<uint64_t>& chunk,
+                 size_t element_size,
+                 const char* input,
+                 const vector<uint64_t>& input_size) :
+      chunk_(chunk),
+      element_size_(element_size),
+      input_(input),
+      input_size_(input_size),
+      found_(false),
+      failed_(false) {}
+  /// Decode the existing chunk unless overwritten, copy and encode.
+  virtual void run() {
+    string data;
+    uint64_t chunk_bytes = element_size_;
+    for (size_t i = 0; i < chunk_.size(); ++i)
+      chunk_bytes *= chunk_[i];
+    if (found_ && !region_.full) {
+      if (!decode_chunk(record_, &data) || data.size() != chunk_bytes) {
+        failed_ = true;
+        return;
+      }
+    }
+    else
+      data.assign(chunk_bytes, '\0');
+    if (chunk_bytes > 0)
+      copy_box(input_,
+               input_size_,
+               region_.slab_origin,
+               &data[0],
+               chunk_,
+               region_.chunk_origin,
+               region_.extent,
+               element_size_);
+    encode_chunk(data.data(), data.size(), &record_);
+  }
+  /// Raw chunk record, existing before run and new after run.
+  string* record() { return &record_; }
+  /// Region to copy.
+  ChunkRegion* region() { return &region_; }
+  /// Set if the chunk record exists.
+  void set_found(bool found) { found_ = found; }
+  /// Return if the existing chunk record is corrupted.
+  bool failed() const { return failed_; }
+
+private:
+  /// Size of a chunk.
+  const vector<uint64_t>& chunk_;
+  /// Bytes per element.
+  size_t element_size_;
+  /// Input data.
+  const char* input_;
+  /// Size of the input.
+  const vector<uint64_t>& input_size_;
+  /// Raw chunk record.
+  string record_;
+  /// Region to copy.
+  ChunkRegion region_;
+  /// Chunk record exists.
+  bool found_;
+  /// Decoding failure.
+  bool failed_;
+};
+
+Dataset::Dataset() : code_(0),
+                     database_(NULL),
+                     store_(NULL),
+                     class_id_(mxDOUBLE_CLASS),
+                     element_size_(sizeof(double)),
+                     pool_(NULL) {}
+
+Dataset::~Dataset() {
+  if (pool_)
+    delete pool_;
+}
+
+bool Dataset::create(Database* database,
+                     const mxArray* name,
+                     const vector<uint64_t>& size,
+                     mxClassID class_id,
+                     const vector<uint64_t>& chunk) {
+  if (size.empty() || size.size() != chunk.size())
+    ERROR("Chunk must have as many dimensions as size.");
+  for (size_t i = 0; i < chunk.size(); ++i)
+    if (chunk[i] == 0)
+      ERROR("Chunk must be positive.");
+  element_size_ = Record::native_element_size(class_id);
+  if (element_size_ == 0)
+    ERROR("Class must be numeric, logical or char.");
+  database_ = database;
+  class_id_ = class_id;
+  size_ = size;
+  chunk_ = chunk;
+  prefix_ = Stream::chunk_prefix(Record(name).key_bytes());
+  store_ = database->stream_store(true);
+  if (store_ == NULL) {
+    code_ = database->error_code();
+    return false;
+  }
+  if (!database->del(name, 0, NULL) &&
+      database->error_code() != DB_NOTFOUND) {
+    code_ = database->error_code();
+    return false;
+  }
+  code_ = Stream::remove_chunks(store_, NULL, prefix_);
+  if (!ok()) return false;
+  const char* kFields[] = {"dataset", "class", "size", "chunk"};
+  MxArray metadata = MxArray::Struct(4, kFields);
+  metadata.set(kFields[0], true);
+  metadata.set(kFields[1], string(class_name_of(class_id_)));
+  metadata.set(kFields[2], vector<double>(size_.begin(), size_.end()));
+  metadata.set(kFields[3], vector<double>(chunk_.begin(), chunk_.end()));
+  bool success = database->put(name, metadata.get(), 0, NULL);
+  metadata.destroy();
+  if (!success)
+    code_ = database->error_code();
+  return success;
+}
+
+bool Dataset::open(Database* database, const mxArray* name) {
+  database_ = database;
+  prefix_ = Stream::chunk_prefix(Record(name).key_bytes());
+  mxArray* metadata = NULL;
+  if (!database->get(name, 0, &metadata, NULL)) {
+    code_ = database->error_code();
+    return false;
+  }
+  MxArray metadata_array(metadata);
+  bool valid = metadata_array.isStruct() &&
+               metadata_array.isField("dataset") &&
+               metadata_array.isField("class") &&
+               metadata_array.isField("size") &&
+               metadata_array.isField("chunk");
+  if (valid) {
+    class_id_ = class_id_of(metadata_array.at("class").toString());
+    vector<double> size, chunk;
+    metadata_array.at("size").toVector(&size);
+    metadata_array.at("chunk").toVector(&chunk);
+    size_.assign(size.begin(), size.end());
+    chunk_.assign(chunk.begin(), chunk.end());
+  }
+  mxDestroyArray(metadata);
+  element_size_ = Record::native_element_size(class_id_);
+  if (!valid || element_size_ == 0 || size_.empty() ||
+      size_.size() != chunk_.size()) {
+    code_ = EINVAL;
+    return false;
+  }
+  // Chunks are created on the first write.
+  store_ = database->stream_store(false);
+  return true;
+}
+
+bool Dataset::write(const mxArray* subscripts, const mxArray* data) {
+  if (database_ == NULL) {
+    code_ = EINVAL;
+    return false;
+  }
+  if (mxGetClassID(data) != class_id_ || mxIsSparse(data) ||
+      mxIsComplex(data))
+    ERROR("Data must be a real %s array.", class_name_of(class_id_));
+  vector<uint64_t> start, count;
+  parse_subscripts(subscripts, &start, &count);
+  uint64_t num_elements = 1;
+  for (size_t i = 0; i < count.size(); ++i)
+    num_elements *= count[i];
+  if (num_elements != mxGetNumberOfElements(data))
+    ERROR("Data must have %g elements.", static_cast<double>(num_elements));
+  if (num_elements == 0)
+    return true;
+  if (store_ == NULL) {
+    store_ = database_->stream_store(true);
+    if (store_ == NULL) {
+      code_ = database_->error_code();
+      return false;
+    }
+  }
+  vector<vector<uint64_t> > chunks;
+  find_chunks(start, count, &chunks);
+  const char* input = static_cast<const char*>(mxGetData(data));
+  for (size_t offset = 0; ok() && offset < chunks.size();
+       offset += kDatasetBatch) {
+    size_t end = min(offset + kDatasetBatch, chunks.size());
+    vector<WriteChunkTask*> tasks;
+    for (size_t i = offset; ok() && i < end; ++i) {
+      WriteChunkTask* task = new WriteChunkTask(chunk_,
+                                                element_size_,
+                                                input,
+                                                count);
+      tasks.push_back(task);
+      intersect(chunks[i], chunk_, start, count, task->region());
+      bool found = false;
+      if (!task->region()->full && !load(chunks[i], task->record(), &found))
+        break;
+      task->set_found(found);
+      if (!pool()->push(task))
+        task->run();
+    }
+    pool()->wait();
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      if (ok() && tasks[i]->failed())
+        code_ = EINVAL;
+      if (ok())
+        store(chunks[offset + i], *tasks[i]->record());
+      delete tasks[i];
+    }
+  }
+  return ok();
+}
+
+bool Dataset::read(const mxArray* subscripts, mxArray** data) {
+  if (database_ == NULL) {
+    code_ = EINVAL;
+    return false;
+  }
+  vector<uint64_t> start, count;
+  parse_subscripts(subscripts, &start, &count);
+  vector<mwSize> dimensions(count.begin(), count.end());
+  if (dimensions.size() < 2)
+    dimensions.push_back(1);
+  if (class_id_ == mxLOGICAL_CLASS)
+    *data = mxCreateLogicalArray(dimensions.size(), &dimensions[0]);
+  else if (class_id_ == mxCHAR_CLASS)
+    *data = mxCreateCharArray(dimensions.size(), &dimensions[0]);
+  else
+    *data = mxCreateNumericArray(dimensions.size(),
+                                 &dimensions[0],
+                                 class_id_,
+                                 mxREAL);
+  if (*data == NULL)
+    ERROR("Null pointer exception.");
+  // Nothing is stored before the first write.
+  if (store_ == NULL)
+    store_ = database_->stream_store(false);
+  if (store_ == NULL || mxGetNumberOfElements(*data) == 0)
+    return true;
+  vector<vector<uint64_t> > chunks;
+  find_chunks(start, count, &chunks);
+  char* output = static_cast<char*>(mxGetData(*data));
+  for (size_t offset = 0; ok() && offset < chunks.size();
+       offset += kDatasetBatch) {
+    size_t end = min(offset + kDatasetBatch, chunks.size());
+    vector<ReadChunkTask*> tasks;
+    for (size_t i = offset; ok() && i < end; ++i) {
+      ReadChunkTask* task = new ReadChunkTask(chunk_,
+                                              element_size_,
+                                              output,
+                                              count);
+      tasks.push_back(task);
+      intersect(chunks[i], chunk_, start, count, task->region());
+      bool found = false;
+      if (!load(chunks[i], task->record(), &found))
+        break;
+      task->set_found(found);
+      if (!pool()->push(task))
+        task->run();
+    }
+    pool()->wait();
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      if (ok() && tasks[i]->failed())
+        code_ = EINVAL;
+      delete tasks[i];
+    }
+  }
+  if (!ok()) {
+    mxDestroyArray(*data);
+    *data = NULL;
+  }
+  return ok();
+}
+
+void Dataset::parse_subscripts(const mxArray* subscripts,
+                               vector<uint64_t>* start,
+                               vector<uint64_t>* count) const {
+  start->assign(size_.size(), 0);
+  count->assign(size_.begin(), size_.end());
+  if (subscripts == NULL)
+    return;
+  MxArray subscripts_array(subscripts);
+  if (!subscripts_array.isCell() ||
+      subscripts_array.numel() != size_.size())
+    ERROR("Subscripts must be a cell array of %d index vectors.",
+          static_cast<int>(size_.size()));
+  for (size_t i = 0; i < size_.size(); ++i) {
+    MxArray subscript(mxGetCell(subscripts, i));
+    if (subscript.isChar() && subscript.toString() == ":")
+      continue;
+    vector<double> indices;
+    if (!subscript.isEmpty())
+      subscript.toVector(&indices);
+    for (size_t j = 0; j < indices.size(); ++j)
+      if (indices[j] != ((j == 0) ? indices[0] : indices[j - 1] + 1) ||
+          indices[j] < 1 || indices[j] > size_[i] ||
+          indices[j] != static_cast<uint64_t>(indices[j]))
+        ERROR("Subscript %d must be a contiguous range of indices.",
+              static_cast<int>(i + 1));
+    (*start)[i] = (indices.empty()) ?
+        0 : static_cast<uint64_t>(indices[0]) - 1;
+    (*count)[i] = indices.size();
+  }
+}
+
+void Dataset::find_chunks(const vector<uint64_t>& start,
+                          const vector<uint64_t>& count,
+                          vector<vector<uint64_t> >* chunks) const {
+  chunks->clear();
+  size_t num_dimensions = size_.size();
+  vector<uint64_t> first(num_dimensions), last(num_dimensions);
+  for (size_t i = 0; i < num_dimensions; ++i) {
+    if (count[i] == 0)
+      return;
+    first[i] = start[i] / chunk_[i];
+    last[i] = (start[i] + count[i] - 1) / chunk_[i];
+  }
+  // Enumerate the last dimension slowest, which follows the key order.
+  vector<uint64_t> coordinates = first;
+  while (true) {
+    chunks->push_back(coordinates);
+    size_t dimension = num_dimensions;
+    while (dimension > 0) {
+      --dimension;
+      if (++coordinates[dimension] <= last[dimension])
+        break;
+      coordinates[dimension] = first[dimension];
+      if (dimension == 0)
+        return;
+    }
+  }
+}
+
+string Dataset::chunk_key(const vector<uint64_t>& coordinates) const {
+  string key = prefix_;
+  for (size_t i = 0; i < coordinates.size(); ++i)
+    for (int j = 7; j >= 0; --j)
+      key.push_back(static_cast<char>((coordinates[i] >> (8 * j)) & 0xFF));
+  return key;
+}
+
+bool Dataset::load(const vector<uint64_t>& coordinates,
+                   string* chunk,
+                   bool* found) {
+  string key_bytes = chunk_key(coordinates);
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.data = const_cast<char*>(key_bytes.data());
+  key.size = key_bytes.size();
+  value.flags = DB_DBT_MALLOC;
+  code_ = store_->get(store_, NULL, &key, &value, 0);
+  *found = (code_ == 0);
+  if (code_ == DB_NOTFOUND)
+    code_ = 0;
+  if (*found) {
+    chunk->assign(static_cast<const char*>(value.data), value.size);
+    free(value.data);
+  }
+  return ok();
+}
+
+bool Dataset::store(const vector<uint64_t>& coordinates,
+                    const string& chunk) {
+  string key_bytes = chunk_key(coordinates);
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.data = const_cast<char*>(key_bytes.data());
+  key.size = key_bytes.size();
+  value.data = const_cast<char*>(chunk.data());
+  value.size = chunk.size();
+  code_ = store_->put(store_, NULL, &key, &value, 0);
+  return ok();
+}
+
+ThreadPool* Dataset::pool() {
+  if (pool_ == NULL)
+    pool_ = new ThreadPool(kDatasetThreads);
+  return pool_;
+}
+
+} // namespace bdbmex
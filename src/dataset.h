@@ -0,0 +1,104 @@
+/// Chunked N-D array dataset for Berkeley DB matlab driver.
+///
+/// A dataset splits an N-D numeric, logical or char array into fixed-size
+/// chunks stored as compressed chunk records in the companion database of the
+/// primary, the same store as streams. Chunk keys are the length-prefixed
+/// encoded name followed by the big-endian chunk coordinates, so that the
+/// chunks of a dataset are adjacent and ordered in the btree. Every chunk is
+/// stored in the full chunk size, and a missing chunk reads as zeros. The
+/// primary database keeps a metadata struct for the name.
+///
+/// Reads and writes address a hyperslab, a contiguous range of indices in
+/// each dimension, and touch only the intersecting chunks. Records are read
+/// and written in the matlab thread, while chunks are decoded, copied and
+/// encoded in a thread pool.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __DATASET_H__
+#define __DATASET_H__
+
+#include "libbdbmex.h"
+#include "thread.h"
+
+namespace bdbmex {
+
+/// Chunked N-D array stored in a database.
+class Dataset {
+public:
+  /// Create a closed dataset.
+  Dataset();
+  /// Destructor.
+  virtual ~Dataset();
+  /// Create a dataset of the name, removing the existing value.
+  bool create(Database* database,
+              const mxArray* name,
+              const vector<uint64_t>& size,
+              mxClassID class_id,
+              const vector<uint64_t>& chunk);
+  /// Open an existing dataset of the name.
+  bool open(Database* database, const mxArray* name);
+  /// Write an array to the hyperslab. The array must have the class of the
+  /// dataset and as many elements as the hyperslab.
+  bool write(const mxArray* subscripts, const mxArray* data);
+  /// Read the hyperslab into an array. NULL subscripts read everything.
+  bool read(const mxArray* subscripts, mxArray** data);
+  /// Return if the status is okay.
+  bool ok() const { return code_ == 0; }
+  /// Return the last error message.
+  const char* error_message() const { return db_strerror(code_); }
+  /// Database of the dataset.
+  Database* database() { return database_; }
+
+private:
+  /// Copy prohibited.
+  Dataset(const Dataset&);
+  Dataset& operator=(const Dataset&);
+  /// Parse a cell array of contiguous index vectors or ':' into zero-based
+  /// start and count of each dimension.
+  void parse_subscripts(const mxArray* subscripts,
+                        vector<uint64_t>* start,
+                        vector<uint64_t>* count) const;
+  /// Collect coordinates of chunks intersecting the hyperslab.
+  void find_chunks(const vector<uint64_t>& start,
+                   const vector<uint64_t>& count,
+                   vector<vector<uint64_t> >* chunks) const;
+  /// Key of a chunk record.
+  string chunk_key(const vector<uint64_t>& coordinates) const;
+  /// Read a raw chunk record. Return false on error other than not found.
+  bool load(const vector<uint64_t>& coordinates, string* chunk, bool* found);
+  /// Store a raw chunk record.
+  bool store(const vector<uint64_t>& coordinates, const string& chunk);
+  /// Thread pool created on demand.
+  ThreadPool* pool();
+
+  /// Last return code.
+  int code_;
+  /// Primary database of the metadata.
+  Database* database_;
+  /// Companion database of chunk records.
+  DB* store_;
+  /// Length-prefixed encoded name.
+  string prefix_;
+  /// Class of the elements.
+  mxClassID class_id_;
+  /// Bytes per element.
+  size_t element_size_;
+  /// Dimensions of the array.
+  vector<uint64_t> size_;
+  /// Dimensions of a chunk.
+  vector<uint64_t> chunk_;
+  /// Worker threads of chunk coding.
+  ThreadPool* pool_;
+};
+
+} // namespace bdbmex
+
+namespace mex {
+
+// Template instanciations.
+extern template class Session<bdbmex::Dataset>;
+
+}
+
+#endif // __DATASET_H__
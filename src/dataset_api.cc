@@ -0,0 +1,122 @@
+/// Berkeley DB dataset mex interface.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "dataset.h"
+#include "mex/arguments.h"
+#include "mex/function.h"
+#include "mex/mxarray.h"
+#include "stream.h"
+
+using bdbmex::Database;
+using bdbmex::Dataset;
+using mex::CheckInputArguments;
+using mex::CheckOutputArguments;
+using mex::MxArray;
+using mex::Session;
+
+namespace {
+
+/// Get a dataset from the id argument.
+Dataset* GetDataset(const mxArray* id) {
+  Dataset* dataset = Session<Dataset>::get(MxArray(id).toInt());
+  if (!dataset)
+    ERROR("No open dataset found.");
+  return dataset;
+}
+
+/// Get a database from the id argument.
+Database* GetDatabase(const mxArray* id) {
+  Database* database = Session<Database>::get(MxArray(id).toInt());
+  if (!database)
+    ERROR("No open database found.");
+  return database;
+}
+
+/// Convert a vector of positive integers.
+void GetDimensions(const mxArray* array, vector<uint64_t>* dimensions) {
+  vector<double> values;
+  MxArray(array).toVector(&values);
+  dimensions->clear();
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (values[i] < 0 || values[i] != static_cast<uint64_t>(values[i]))
+      ERROR("Dimensions must be non-negative integers.");
+    dimensions->push_back(static_cast<uint64_t>(values[i]));
+  }
+}
+
+MEX_FUNCTION(dataset_create) (int nlhs,
+                              mxArray *plhs[],
+                              int nrhs,
+                              const mxArray *prhs[]) {
+  CheckInputArguments(5, 5, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  Database* database = GetDatabase(prhs[0]);
+  vector<uint64_t> size, chunk;
+  GetDimensions(prhs[2], &size);
+  GetDimensions(prhs[4], &chunk);
+  string class_name = MxArray(prhs[3]).toString();
+  mxClassID class_id = bdbmex::class_id_of(class_name);
+  if (class_id == mxUNKNOWN_CLASS)
+    ERROR("Invalid class: %s", class_name.c_str());
+  Dataset* dataset = NULL;
+  int dataset_id = Session<Dataset>::create(&dataset);
+  if (!dataset->create(database, prhs[1], size, class_id, chunk)) {
+    const char* error_message = dataset->error_message();
+    Session<Dataset>::destroy(dataset_id);
+    ERROR("Failed to create a dataset: %s", error_message);
+  }
+  plhs[0] = MxArray(dataset_id).getMutable();
+}
+
+MEX_FUNCTION(dataset_open) (int nlhs,
+                            mxArray *plhs[],
+                            int nrhs,
+                            const mxArray *prhs[]) {
+  CheckInputArguments(2, 2, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  Database* database = GetDatabase(prhs[0]);
+  Dataset* dataset = NULL;
+  int dataset_id = Session<Dataset>::create(&dataset);
+  if (!dataset->open(database, prhs[1])) {
+    const char* error_message = dataset->error_message();
+    Session<Dataset>::destroy(dataset_id);
+    ERROR("Failed to open a dataset: %s", error_message);
+  }
+  plhs[0] = MxArray(dataset_id).getMutable();
+}
+
+MEX_FUNCTION(dataset_write) (int nlhs,
+                             mxArray *plhs[],
+                             int nrhs,
+                             const mxArray *prhs[]) {
+  CheckInputArguments(3, 3, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  Dataset* dataset = GetDataset(prhs[0]);
+  if (!dataset->write(prhs[1], prhs[2]))
+    ERROR("Failed to write a dataset: %s", dataset->error_message());
+}
+
+MEX_FUNCTION(dataset_read) (int nlhs,
+                            mxArray *plhs[],
+                            int nrhs,
+                            const mxArray *prhs[]) {
+  CheckInputArguments(1, 2, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  Dataset* dataset = GetDataset(prhs[0]);
+  if (!dataset->read((nrhs > 1) ? prhs[1] : NULL, &plhs[0]))
+    ERROR("Failed to read a dataset: %s", dataset->error_message());
+}
+
+MEX_FUNCTION(dataset_close) (int nlhs,
+                             mxArray *plhs[],
+                             int nrhs,
+                             const mxArray *prhs[]) {
+  CheckInputArguments(1, 1, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  int dataset_id = MxArray(prhs[0]).toInt();
+  GetDataset(prhs[0]);
+  Session<Dataset>::destroy(dataset_id);
+}
+
+} // namespace
@@ -4,12 +4,19 @@
 
 #include <cstring>
 #include "libbdbmex.h"
+#include "dataset.h"
+#include "sequence.h"
+#include "stream.h"
 #include "mex/arguments.h"
 #include "mex/function.h"
 #include "mex/mxarray.h"
 
 using bdbmex::Database;
+using bdbmex::DatabaseConfig;
+using bdbmex::Dataset;
 using bdbmex::Environment;
+using bdbmex::Sequence;
+using bdbmex::Stream;
 using bdbmex::Transaction;
 using mex::CheckInputArguments;
 using mex::CheckOutputArguments;
@@ -24,7 +31,9 @@ DBTYPE get_dbtype(const string& name) {
   map<string, DBTYPE> db_types;
   db_types["btree"] = DB_BTREE;
   db_types["hash"] = DB_HASH;
-  // db_types["heap"] = DB_HEAP;
+#ifdef HAVE_DB_HEAP
+  db_types["heap"] = DB_HEAP;
+#endif
   db_types["queue"] = DB_QUEUE;
   db_types["recno"] = DB_RECNO;
   db_types["unknown"] = DB_UNKNOWN;
@@ -34,6 +43,18 @@ DBTYPE get_dbtype(const string& name) {
   return it->second;
 }
 
+/// Get duplicate flag from name.
+uint32_t get_duplicates(const string& name) {
+  map<string, uint32_t> duplicates;
+  duplicates["none"] = 0;
+  duplicates["unsorted"] = DB_DUP;
+  duplicates["sorted"] = DB_DUPSORT;
+  map<string, uint32_t>::const_iterator it = duplicates.find(name);
+  if (it == duplicates.end())
+    ERROR("Invalid duplicates: %s", name.c_str());
+  return it->second;
+}
+
 MEX_FUNCTION(open) (int nlhs,
                     mxArray *plhs[],
                     int nrhs,
@@ -56,6 +77,19 @@ MEX_FUNCTION(open) (int nlhs,
   options.set("Thread",           false);
   options.set("Truncate",         false);
   options.set("Mode",             0);
+  options.set("ValueCacheSize",   0);
+  options.set("CacheSize",        0);
+  options.set("PageSize",         0);
+  options.set("HashNelem",        0);
+  options.set("HashFfactor",      0);
+  options.set("RecordLength",     0);
+  options.set("RecordPad",        -1);
+  options.set("ExtentSize",       0);
+  options.set("HeapSize",         0);
+  options.set("Duplicates",       string("none"));
+  options.set("Codec",            string("mxarray"));
+  options.set("ValueLog",         0);
+  options.set("ValueLogSegmentSize", 64 * 1024 * 1024);
   options.update(prhs + 1, prhs + nrhs);
   Environment* environment = Session<Environment>::get(
       options["Environment"].toInt());
@@ -63,6 +97,9 @@ MEX_FUNCTION(open) (int nlhs,
       options["Transaction"].toInt());
   DBTYPE type = get_dbtype(options["Type"].toString());
   string name = options["Name"].toString();
+  string codec = options["Codec"].toString();
+  if (codec != "mxarray" && codec != "native")
+    ERROR("Invalid codec: %s", codec.c_str());
   uint32_t flags =
       ((options["AutoCommit"].toBool() && environment) ? DB_AUTO_COMMIT : 0) |
       (options["Create"].toBool()          ? DB_CREATE : 0) |
@@ -74,6 +111,16 @@ MEX_FUNCTION(open) (int nlhs,
       (options["Thread"].toBool()          ? DB_THREAD : 0) |
       (options["Truncate"].toBool()        ? DB_TRUNCATE : 0);
   int mode = options["Mode"].toInt();
+  DatabaseConfig config;
+  config.cache_size = static_cast<uint64_t>(options["CacheSize"].toDouble());
+  config.page_size = options["PageSize"].toInt();
+  config.hash_nelem = options["HashNelem"].toInt();
+  config.hash_ffactor = options["HashFfactor"].toInt();
+  config.record_length = options["RecordLength"].toInt();
+  config.record_pad = options["RecordPad"].toInt();
+  config.extent_size = options["ExtentSize"].toInt();
+  config.heap_size = static_cast<uint64_t>(options["HeapSize"].toDouble());
+  config.duplicates = get_duplicates(options["Duplicates"].toString());
   Database* database = NULL;
   int database_id = Session<Database>::create(&database);
   if (!database->open(filename,
@@ -82,13 +129,28 @@ MEX_FUNCTION(open) (int nlhs,
                       flags,
                       mode,
                       environment,
-                      transaction)) {
+                      transaction,
+                      config)) {
     const char* error_message = database->error_message();
     Session<Database>::destroy(database_id);
     ERROR("Failed to open a database at %s: %s",
           filename.c_str(),
           error_message);
   }
+  database->set_value_cache_size(
+      static_cast<size_t>(options["ValueCacheSize"].toDouble()));
+  database->set_native_values(codec == "native");
+  if (!database->set_value_log(
+          static_cast<size_t>(options["ValueLog"].toDouble()),
+          static_cast<uint64_t>(
+              options["ValueLogSegmentSize"].toDouble()))) {
+    // The message may be owned by the database.
+    string error_message(database->error_message());
+    Session<Database>::destroy(database_id);
+    ERROR("Failed to open a value log of %s: %s",
+          filename.c_str(),
+          error_message.c_str());
+  }
   plhs[0] = MxArray(database_id).getMutable();
 }
 
@@ -108,6 +170,35 @@ MEX_FUNCTION(close) (int nlhs,
   Database* database = Session<Database>::get(database_id);
   if (!database)
     ERROR("No open database found.");
+  // Streams, datasets, sequences and secondary indices must be closed before
+  // the primary. Unclosed write streams are discarded.
+  std::vector<int> session_ids;
+  Session<Dataset>::ids(&session_ids);
+  for (size_t i = 0; i < session_ids.size(); ++i) {
+    if (Session<Dataset>::get(session_ids[i])->database() == database)
+      Session<Dataset>::destroy(session_ids[i]);
+  }
+  Session<Stream>::ids(&session_ids);
+  for (size_t i = 0; i < session_ids.size(); ++i) {
+    if (Session<Stream>::get(session_ids[i])->database() == database)
+      Session<Stream>::destroy(session_ids[i]);
+  }
+  Session<Sequence>::ids(&session_ids);
+  for (size_t i = 0; i < session_ids.size(); ++i) {
+    Sequence* sequence = Session<Sequence>::get(session_ids[i]);
+    if (sequence->database() == database) {
+      sequence->close();
+      Session<Sequence>::destroy(session_ids[i]);
+    }
+  }
+  Session<Database>::ids(&session_ids);
+  for (size_t i = 0; i < session_ids.size(); ++i) {
+    Database* index = Session<Database>::get(session_ids[i]);
+    if (index->primary() == database) {
+      index->close(flags);
+      Session<Database>::destroy(session_ids[i]);
+    }
+  }
   database->close(flags);
   Session<Database>::destroy(database_id);
 }
@@ -129,6 +220,7 @@ MEX_FUNCTION(get) (int nlhs,
   options.set("ReadCommitted",   false);
   options.set("ReadUncommitted", false);
   options.set("RMW",             false);
+  options.set("Range",           vector<double>());
   Database* database = NULL;
   MxArray key;
   if (nrhs == 1) {
@@ -144,6 +236,19 @@ MEX_FUNCTION(get) (int nlhs,
     ERROR("No open database found.");
   Transaction* transaction = Session<Transaction>::get(
       options["Transaction"].toInt());
+  vector<double> range;
+  options["Range"].toVector(&range);
+  if (!range.empty()) {
+    if (range.size() != 2 || range[0] < 0 || range[1] < 0)
+      ERROR("Range must be [offset, count].");
+    if (!database->get_range(key.get(),
+                             static_cast<uint64_t>(range[0]),
+                             static_cast<uint64_t>(range[1]),
+                             transaction,
+                             &plhs[0]))
+      ERROR("Failed to get a range: %s", database->error_message());
+    return;
+  }
   uint32_t flags =
       (options["Consume"].toBool()         ? DB_CONSUME : 0) |
       (options["ConsumeWait"].toBool()     ? DB_CONSUME_WAIT : 0) |
@@ -159,12 +264,68 @@ MEX_FUNCTION(get) (int nlhs,
     ERROR("Failed to get an entry: %s", database->error_message());
 }
 
+MEX_FUNCTION(get_all) (int nlhs,
+                       mxArray *plhs[],
+                       int nrhs,
+                       const mxArray *prhs[]) {
+  CheckInputArguments(1, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Transaction", 0);
+  Database* database = NULL;
+  MxArray key;
+  if (nrhs == 1) {
+    database = Session<Database>::get(0);
+    key.reset(prhs[0]);
+  }
+  else {
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    key.reset(prhs[1]);
+    options.update(prhs + 2, prhs + nrhs);
+  }
+  if (!database)
+    ERROR("No open database found.");
+  Transaction* transaction = Session<Transaction>::get(
+      options["Transaction"].toInt());
+  if (!database->get_all(key.get(), transaction, &plhs[0]))
+    ERROR("Failed to get entries: %s", database->error_message());
+}
+
+MEX_FUNCTION(count) (int nlhs,
+                     mxArray *plhs[],
+                     int nrhs,
+                     const mxArray *prhs[]) {
+  CheckInputArguments(1, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Transaction", 0);
+  Database* database = NULL;
+  MxArray key;
+  if (nrhs == 1) {
+    database = Session<Database>::get(0);
+    key.reset(prhs[0]);
+  }
+  else {
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    key.reset(prhs[1]);
+    options.update(prhs + 2, prhs + nrhs);
+  }
+  if (!database)
+    ERROR("No open database found.");
+  Transaction* transaction = Session<Transaction>::get(
+      options["Transaction"].toInt());
+  int count = 0;
+  if (!database->count(key.get(), transaction, &count))
+    ERROR("Failed to count entries: %s", database->error_message());
+  plhs[0] = MxArray(count).getMutable();
+}
+
 MEX_FUNCTION(put) (int nlhs,
                    mxArray *plhs[],
                    int nrhs,
                    const mxArray *prhs[]) {
   CheckInputArguments(2, 1024, nrhs);
-  CheckOutputArguments(0, 0, nlhs);
+  CheckOutputArguments(0, 1, nlhs);
   VariableInputArguments options;
   options.set("Transaction",  0);
   options.set("Append",       false);
@@ -173,6 +334,7 @@ MEX_FUNCTION(put) (int nlhs,
   options.set("Multiple",     false);
   options.set("MultipleKey",  false);
   options.set("OverwriteDup", false);
+  options.set("At",           -1);
   Database* database = NULL;
   MxArray key, value;
   if (nrhs == 2) {
@@ -197,8 +359,91 @@ MEX_FUNCTION(put) (int nlhs,
       (options["Multiple"].toBool()     ? DB_MULTIPLE : 0) |
       (options["MultipleKey"].toBool()  ? DB_MULTIPLE_KEY : 0) |
       (options["OverwriteDup"].toBool() ? DB_OVERWRITE_DUP : 0);
-  if (!database->put(key.get(), value.get(), flags, transaction))
+  double offset = options["At"].toDouble();
+  if (offset >= 0) {
+    if (!database->put_at(key.get(),
+                          value.get(),
+                          static_cast<uint64_t>(offset),
+                          transaction))
+      ERROR("Failed to put at an offset: %s", database->error_message());
+    if (nlhs > 0)
+      plhs[0] = mxCreateDoubleMatrix(0, 0, mxREAL);
+    return;
+  }
+  mxArray* new_key = NULL;
+  if (!database->put(key.get(),
+                     value.get(),
+                     flags,
+                     transaction,
+                     (nlhs > 0) ? &new_key : NULL))
     ERROR("Failed to put an entry: %s", database->error_message());
+  if (nlhs > 0)
+    plhs[0] = (new_key) ? new_key : mxCreateDoubleMatrix(0, 0, mxREAL);
+}
+
+MEX_FUNCTION(incr) (int nlhs,
+                    mxArray *plhs[],
+                    int nrhs,
+                    const mxArray *prhs[]) {
+  CheckInputArguments(1, 3, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  Database* database = NULL;
+  MxArray key;
+  double delta = 1.0;
+  if (nrhs == 1) {
+    database = Session<Database>::get(0);
+    key.reset(prhs[0]);
+  }
+  else {
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    key.reset(prhs[1]);
+    if (nrhs > 2)
+      delta = MxArray(prhs[2]).toDouble();
+  }
+  if (!database)
+    ERROR("No open database found.");
+  mxArray* value = NULL;
+  if (!database->incr(key.get(), delta, &value))
+    ERROR("Failed to increment an entry: %s", database->error_message());
+  if (nlhs > 0)
+    plhs[0] = value;
+  else
+    mxDestroyArray(value);
+}
+
+MEX_FUNCTION(append_to) (int nlhs,
+                         mxArray *plhs[],
+                         int nrhs,
+                         const mxArray *prhs[]) {
+  CheckInputArguments(2, 3, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  Database* database = (nrhs == 2) ? Session<Database>::get(0) :
+      Session<Database>::get(MxArray(prhs[0]).toInt());
+  if (!database)
+    ERROR("No open database found.");
+  const mxArray** arguments = prhs + (nrhs - 2);
+  int length = 0;
+  if (!database->append_to(arguments[0], arguments[1], &length))
+    ERROR("Failed to append to an entry: %s", database->error_message());
+  if (nlhs > 0)
+    plhs[0] = MxArray(length).getMutable();
+}
+
+MEX_FUNCTION(cas) (int nlhs,
+                   mxArray *plhs[],
+                   int nrhs,
+                   const mxArray *prhs[]) {
+  CheckInputArguments(3, 4, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  Database* database = (nrhs == 3) ? Session<Database>::get(0) :
+      Session<Database>::get(MxArray(prhs[0]).toInt());
+  if (!database)
+    ERROR("No open database found.");
+  const mxArray** arguments = prhs + (nrhs - 3);
+  bool swapped = false;
+  if (!database->cas(arguments[0], arguments[1], arguments[2], &swapped))
+    ERROR("Failed to swap an entry: %s", database->error_message());
+  plhs[0] = mxCreateLogicalScalar(swapped);
 }
 
 MEX_FUNCTION(delete) (int nlhs,
@@ -383,19 +628,357 @@ MEX_FUNCTION(compact) (int nlhs,
   }
 }
 
+MEX_FUNCTION(advise) (int nlhs,
+                      mxArray *plhs[],
+                      int nrhs,
+                      const mxArray *prhs[]) {
+  CheckInputArguments(0, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Samples",    10000);
+  options.set("WorkingSet", 1.0);
+  Database* database = Session<Database>::get(
+      (nrhs == 0 || !MxArray(prhs[0]).isNumeric()) ?
+          0 : MxArray(prhs[0]).toInt());
+  options.update(prhs, prhs + nrhs);
+  if (!database)
+    ERROR("No open database found.");
+  if (!database->advise(options["Samples"].toInt(),
+                        options["WorkingSet"].toDouble(),
+                        &plhs[0]))
+    ERROR("Failed to sample records: %s", database->error_message());
+}
+
+MEX_FUNCTION(warm) (int nlhs,
+                    mxArray *plhs[],
+                    int nrhs,
+                    const mxArray *prhs[]) {
+  CheckInputArguments(0, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Full",     false);
+  options.set("MaxPages", 0);
+  Database* database = Session<Database>::get(
+      (nrhs == 0 || !MxArray(prhs[0]).isNumeric()) ?
+          0 : MxArray(prhs[0]).toInt());
+  options.update(prhs, prhs + nrhs);
+  if (!database)
+    ERROR("No open database found.");
+  int num_pages = 0;
+  if (!database->warm(options["Full"].toBool(),
+                      options["MaxPages"].toInt(),
+                      &num_pages))
+    ERROR("Failed to warm the cache: %s", database->error_message());
+  if (nlhs > 0)
+    plhs[0] = MxArray(num_pages).getMutable();
+}
+
+MEX_FUNCTION(vlog_gc) (int nlhs,
+                       mxArray *plhs[],
+                       int nrhs,
+                       const mxArray *prhs[]) {
+  CheckInputArguments(0, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("MinGarbage", 0.5);
+  Database* database = Session<Database>::get(
+      (nrhs == 0 || !MxArray(prhs[0]).isNumeric()) ?
+          0 : MxArray(prhs[0]).toInt());
+  options.update(prhs, prhs + nrhs);
+  if (!database)
+    ERROR("No open database found.");
+  int num_segments = 0;
+  uint64_t reclaimed = 0;
+  if (!database->collect_value_log(options["MinGarbage"].toDouble(),
+                                   &num_segments,
+                                   &reclaimed))
+    ERROR("Failed to collect a value log: %s", database->error_message());
+  if (nlhs > 0) {
+    const char* kFields[] = {"segments", "reclaimed"};
+    MxArray stats = MxArray::Struct(2, kFields);
+    stats.set(kFields[0], num_segments);
+    stats.set(kFields[1], static_cast<double>(reclaimed));
+    plhs[0] = stats.getMutable();
+  }
+}
+
+MEX_FUNCTION(bulk_load) (int nlhs,
+                         mxArray *plhs[],
+                         int nrhs,
+                         const mxArray *prhs[]) {
+  CheckInputArguments(2, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("MemoryLimit", 64 * 1024 * 1024);
+  Database* database = NULL;
+  MxArray keys, values;
+  if (nrhs == 2 || !MxArray(prhs[0]).isNumeric()) {
+    database = Session<Database>::get(0);
+    keys.reset(prhs[0]);
+    values.reset(prhs[1]);
+    options.update(prhs + 2, prhs + nrhs);
+  }
+  else {
+    if (nrhs < 3)
+      ERROR("Missing values.");
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    keys.reset(prhs[1]);
+    values.reset(prhs[2]);
+    options.update(prhs + 3, prhs + nrhs);
+  }
+  if (!database)
+    ERROR("No open database found.");
+  int num_records = 0;
+  if (!database->bulk_load(keys.get(),
+                           values.get(),
+                           static_cast<size_t>(
+                               options["MemoryLimit"].toDouble()),
+                           &num_records))
+    ERROR("Failed to load records: %s", database->error_message());
+  if (nlhs > 0)
+    plhs[0] = MxArray(num_records).getMutable();
+}
+
+MEX_FUNCTION(export) (int nlhs,
+                      mxArray *plhs[],
+                      int nrhs,
+                      const mxArray *prhs[]) {
+  CheckInputArguments(1, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Compress", false);
+  Database* database = NULL;
+  string filename;
+  if (MxArray(prhs[0]).isNumeric()) {
+    if (nrhs < 2)
+      ERROR("Missing filename.");
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    filename = MxArray(prhs[1]).toString();
+    options.update(prhs + 2, prhs + nrhs);
+  }
+  else {
+    database = Session<Database>::get(0);
+    filename = MxArray(prhs[0]).toString();
+    options.update(prhs + 1, prhs + nrhs);
+  }
+  if (!database)
+    ERROR("No open database found.");
+  int num_records = 0;
+  if (!database->export_dump(filename,
+                             options["Compress"].toBool(),
+                             &num_records))
+    ERROR("Failed to export: %s", database->error_message());
+  if (nlhs > 0)
+    plhs[0] = MxArray(num_records).getMutable();
+}
+
+MEX_FUNCTION(import) (int nlhs,
+                      mxArray *plhs[],
+                      int nrhs,
+                      const mxArray *prhs[]) {
+  CheckInputArguments(1, 2, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  Database* database = NULL;
+  string filename;
+  if (nrhs == 1) {
+    database = Session<Database>::get(0);
+    filename = MxArray(prhs[0]).toString();
+  }
+  else {
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    filename = MxArray(prhs[1]).toString();
+  }
+  if (!database)
+    ERROR("No open database found.");
+  int num_records = 0;
+  if (!database->import_dump(filename, &num_records))
+    ERROR("Failed to import: %s", database->error_message());
+  if (nlhs > 0)
+    plhs[0] = MxArray(num_records).getMutable();
+}
+
+MEX_FUNCTION(append) (int nlhs,
+                      mxArray *plhs[],
+                      int nrhs,
+                      const mxArray *prhs[]) {
+  CheckInputArguments(1, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Transaction", 0);
+  Database* database = NULL;
+  MxArray values;
+  if (MxArray(prhs[0]).isCell()) {
+    database = Session<Database>::get(0);
+    values.reset(prhs[0]);
+    options.update(prhs + 1, prhs + nrhs);
+  }
+  else {
+    if (nrhs < 2)
+      ERROR("Missing values.");
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    values.reset(prhs[1]);
+    options.update(prhs + 2, prhs + nrhs);
+  }
+  if (!database)
+    ERROR("No open database found.");
+  Transaction* transaction = Session<Transaction>::get(
+      options["Transaction"].toInt());
+  mxArray* recnos = NULL;
+  if (!database->append(values.get(), transaction, &recnos))
+    ERROR("Failed to append records: %s", database->error_message());
+  if (nlhs > 0)
+    plhs[0] = recnos;
+  else
+    mxDestroyArray(recnos);
+}
+
+MEX_FUNCTION(consume) (int nlhs,
+                       mxArray *plhs[],
+                       int nrhs,
+                       const mxArray *prhs[]) {
+  CheckInputArguments(1, 1024, nrhs);
+  CheckOutputArguments(0, 2, nlhs);
+  VariableInputArguments options;
+  options.set("Transaction", 0);
+  options.set("Wait",        false);
+  Database* database = NULL;
+  int count = 0;
+  if (nrhs > 1 && MxArray(prhs[1]).isNumeric()) {
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    count = MxArray(prhs[1]).toInt();
+    options.update(prhs + 2, prhs + nrhs);
+  }
+  else {
+    database = Session<Database>::get(0);
+    count = MxArray(prhs[0]).toInt();
+    options.update(prhs + 1, prhs + nrhs);
+  }
+  if (!database)
+    ERROR("No open database found.");
+  Transaction* transaction = Session<Transaction>::get(
+      options["Transaction"].toInt());
+  if (!database->consume(count,
+                         options["Wait"].toBool(),
+                         transaction,
+                         &plhs[0],
+                         (nlhs > 1) ? &plhs[1] : NULL))
+    ERROR("Failed to consume records: %s", database->error_message());
+}
+
+MEX_FUNCTION(create_index) (int nlhs,
+                            mxArray *plhs[],
+                            int nrhs,
+                            const mxArray *prhs[]) {
+  CheckInputArguments(0, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("FieldName", string(""));
+  options.set("Filename",  string(""));
+  int database_id = (nrhs == 0 || !MxArray(prhs[0]).isNumeric()) ?
+      0 : MxArray(prhs[0]).toInt();
+  Database* database = Session<Database>::get(database_id);
+  options.update(prhs, prhs + nrhs);
+  if (!database)
+    ERROR("No open database found.");
+  string field = options["FieldName"].toString();
+  if (field.empty())
+    ERROR("Missing FieldName.");
+  // The index does not replace the default database.
+  Database* index = NULL;
+  int index_id = Session<Database>::create(&index, true);
+  if (!database->create_index(field, options["Filename"].toString(), index)) {
+    const char* error_message = database->error_message();
+    Session<Database>::destroy(index_id);
+    ERROR("Failed to create an index on %s: %s",
+          field.c_str(),
+          error_message);
+  }
+  plhs[0] = MxArray(index_id).getMutable();
+}
+
+MEX_FUNCTION(get_by) (int nlhs,
+                      mxArray *plhs[],
+                      int nrhs,
+                      const mxArray *prhs[]) {
+  CheckInputArguments(2, 4, nrhs);
+  CheckOutputArguments(0, 2, nlhs);
+  VariableInputArguments options;
+  options.set("Upper", std::vector<double>());
+  options.update(prhs + 2, prhs + nrhs);
+  Database* index = Session<Database>::get(MxArray(prhs[0]).toInt());
+  if (!index)
+    ERROR("No open index found.");
+  const mxArray* upper = (options["Upper"].isEmpty()) ?
+      NULL : options["Upper"].get();
+  if (!index->get_by(prhs[1],
+                     upper,
+                     &plhs[0],
+                     (nlhs > 1) ? &plhs[1] : NULL))
+    ERROR("Failed to query the index: %s", index->error_message());
+}
+
+MEX_FUNCTION(join) (int nlhs,
+                    mxArray *plhs[],
+                    int nrhs,
+                    const mxArray *prhs[]) {
+  CheckInputArguments(2, 4, nrhs);
+  CheckOutputArguments(0, 2, nlhs);
+  VariableInputArguments options;
+  options.set("NoSort", false);
+  options.update(prhs + 2, prhs + nrhs);
+  Database* database = Session<Database>::get(MxArray(prhs[0]).toInt());
+  if (!database)
+    ERROR("No open database found.");
+  const mxArray* conditions = prhs[1];
+  if (!mxIsCell(conditions) || mxGetN(conditions) != 2)
+    ERROR("Conditions must be an N-by-2 cell array of index ids and values.");
+  std::vector<Database*> indexes;
+  std::vector<const mxArray*> index_values;
+  for (mwIndex i = 0; i < mxGetM(conditions); ++i) {
+    indexes.push_back(Session<Database>::get(
+        MxArray(mxGetCell(conditions, i)).toInt()));
+    index_values.push_back(mxGetCell(conditions, i + mxGetM(conditions)));
+  }
+  if (!database->join(indexes,
+                      index_values,
+                      (options["NoSort"].toBool() ? DB_JOIN_NOSORT : 0),
+                      &plhs[0],
+                      (nlhs > 1) ? &plhs[1] : NULL))
+    ERROR("Failed to join: %s", database->error_message());
+}
+
+MEX_FUNCTION(prefetch) (int nlhs,
+                        mxArray *plhs[],
+                        int nrhs,
+                        const mxArray *prhs[]) {
+  CheckInputArguments(1, 2, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  Database* database = NULL;
+  MxArray keys;
+  if (nrhs == 1) {
+    database = Session<Database>::get(0);
+    keys.reset(prhs[0]);
+  }
+  else {
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    keys.reset(prhs[1]);
+  }
+  if (!database)
+    ERROR("No open database found.");
+  if (!database->is_threaded())
+    ERROR("Prefetch requires a database opened with the Thread option.");
+  if (!database->prefetch(keys.get()))
+    ERROR("Failed to start prefetch: %s", database->error_message());
+}
+
 MEX_FUNCTION(sessions) (int nlhs,
                         mxArray *plhs[],
                         int nrhs,
                         const mxArray *prhs[]) {
   CheckInputArguments(0, 0, nrhs);
   CheckOutputArguments(0, 1, nlhs);
-  const map<int, Database>& instances =
-      Session<Database>::get_const_instances();
   vector<int> session_ids;
-  session_ids.reserve(instances.size());
-  for (map<int, Database>::const_iterator it = instances.begin();
-       it != instances.end(); ++it)
-    session_ids.push_back(it->first);
+  Session<Database>::ids(&session_ids);
   plhs[0] = MxArray(session_ids).getMutable();
 }
 
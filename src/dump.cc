@@ -0,0 +1,246 @@
+/// Binary dump format for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "dump.h"
+#include <cerrno>
+#include <cstring>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+using std::string;
+
+namespace bdbmex {
+
+/// Magic bytes at the beginning of a dump file.
+static const char kDumpMagic[8] = {'B', 'D', 'B', 'M', 'E', 'X', 'D', 'P'};
+
+/// Version of the format.
+static const uint32_t kDumpVersion = 1;
+
+/// Flag of a compressed block.
+static const uint32_t kBlockCompressed = 1;
+
+/// Raw size at which a block is written.
+static const size_t kBlockSize = 1 << 20;
+
+/// Stream buffer size of a dump file.
+static const size_t kStreamBufferSize = 4 << 20;
+
+/// Append a little-endian 32-bit word.
+static void put_uint32(uint32_t value, string* output) {
+  for (int i = 0; i < 4; ++i)
+    output->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+/// Decode a little-endian 32-bit word.
+static uint32_t get_uint32(const char* input) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(input);
+  return static_cast<uint32_t>(bytes[0]) |
+         (static_cast<uint32_t>(bytes[1]) << 8) |
+         (static_cast<uint32_t>(bytes[2]) << 16) |
+         (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+uint32_t crc32_checksum(const void* data, size_t size) {
+  static uint32_t table[256];
+  static bool initialized = false;
+  if (!initialized) {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t value = i;
+      for (int j = 0; j < 8; ++j)
+        value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+      table[i] = value;
+    }
+    initialized = true;
+  }
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  return crc ^ 0xFFFFFFFF;
+}
+
+DumpWriter::DumpWriter() : file_(NULL), compress_(false) {}
+
+DumpWriter::~DumpWriter() {
+  if (file_)
+    fclose(file_);
+}
+
+bool DumpWriter::open(const string& path, bool compress) {
+#ifndef ENABLE_ZLIB
+  if (compress) {
+    error_ = "Compression requires the driver built with zlib.";
+    return false;
+  }
+#endif
+  compress_ = compress;
+  file_ = fopen(path.c_str(), "wb");
+  if (file_ == NULL) {
+    error_ = "Failed to open " + path + ": " + strerror(errno);
+    return false;
+  }
+  setvbuf(file_, NULL, _IOFBF, kStreamBufferSize);
+  string header(kDumpMagic, sizeof(kDumpMagic));
+  put_uint32(kDumpVersion, &header);
+  if (fwrite(header.data(), header.size(), 1, file_) != 1) {
+    error_ = "Failed to write a header.";
+    return false;
+  }
+  block_.reserve(kBlockSize + (kBlockSize >> 2));
+  return true;
+}
+
+bool DumpWriter::add(const void* key, size_t key_size,
+                     const void* value, size_t value_size) {
+  put_uint32(key_size, &block_);
+  block_.append(static_cast<const char*>(key), key_size);
+  put_uint32(value_size, &block_);
+  block_.append(static_cast<const char*>(value), value_size);
+  return (block_.size() >= kBlockSize) ? flush_block() : true;
+}
+
+bool DumpWriter::close() {
+  if (file_ == NULL)
+    return false;
+  bool success = (block_.empty() || flush_block()) && flush_block();
+  if (fclose(file_) != 0 && success) {
+    error_ = "Failed to close the file.";
+    success = false;
+  }
+  file_ = NULL;
+  return success;
+}
+
+bool DumpWriter::flush_block() {
+  string stored;
+  uint32_t flags = 0;
+#ifdef ENABLE_ZLIB
+  if (compress_ && !block_.empty()) {
+    uLongf stored_size = compressBound(block_.size());
+    stored.resize(stored_size);
+    if (compress2(reinterpret_cast<Bytef*>(&stored[0]),
+                  &stored_size,
+                  reinterpret_cast<const Bytef*>(block_.data()),
+                  block_.size(),
+                  Z_BEST_SPEED) != Z_OK) {
+      error_ = "Failed to compress a block.";
+      return false;
+    }
+    stored.resize(stored_size);
+    flags |= kBlockCompressed;
+  }
+#endif
+  const string& data = (flags & kBlockCompressed) ? stored : block_;
+  string header;
+  put_uint32(block_.size(), &header);
+  put_uint32(data.size(), &header);
+  put_uint32(crc32_checksum(data.data(), data.size()), &header);
+  put_uint32(flags, &header);
+  if (fwrite(header.data(), header.size(), 1, file_) != 1 ||
+      (!data.empty() && fwrite(data.data(), data.size(), 1, file_) != 1)) {
+    error_ = "Failed to write a block.";
+    return false;
+  }
+  block_.clear();
+  return true;
+}
+
+DumpReader::DumpReader() : file_(NULL), position_(0), finished_(false) {}
+
+DumpReader::~DumpReader() {
+  if (file_)
+    fclose(file_);
+}
+
+bool DumpReader::open(const string& path) {
+  file_ = fopen(path.c_str(), "rb");
+  if (file_ == NULL) {
+    error_ = "Failed to open " + path + ": " + strerror(errno);
+    return false;
+  }
+  setvbuf(file_, NULL, _IOFBF, kStreamBufferSize);
+  char header[sizeof(kDumpMagic) + 4];
+  if (fread(header, sizeof(header), 1, file_) != 1 ||
+      memcmp(header, kDumpMagic, sizeof(kDumpMagic)) != 0) {
+    error_ = "Not a dump file.";
+    return false;
+  }
+  if (get_uint32(header + sizeof(kDumpMagic)) != kDumpVersion) {
+    error_ = "Unsupported dump version.";
+    return false;
+  }
+  return true;
+}
+
+bool DumpReader::next(string* key, string* value) {
+  if (position_ >= block_.size() && !read_block())
+    return false;
+  string* fields[] = {key, value};
+  for (int i = 0; i < 2; ++i) {
+    if (block_.size() - position_ < 4) {
+      error_ = "Corrupted block.";
+      return false;
+    }
+    uint32_t size = get_uint32(&block_[position_]);
+    position_ += 4;
+    if (block_.size() - position_ < size) {
+      error_ = "Corrupted block.";
+      return false;
+    }
+    fields[i]->assign(block_, position_, size);
+    position_ += size;
+  }
+  return true;
+}
+
+bool DumpReader::read_block() {
+  if (finished_ || failed())
+    return false;
+  char header[16];
+  if (fread(header, sizeof(header), 1, file_) != 1) {
+    error_ = "Unexpected end of file.";
+    return false;
+  }
+  uint32_t raw_size = get_uint32(header);
+  uint32_t stored_size = get_uint32(header + 4);
+  uint32_t checksum = get_uint32(header + 8);
+  uint32_t flags = get_uint32(header + 12);
+  if (raw_size == 0) {
+    finished_ = true;
+    return false;
+  }
+  string stored(stored_size, '\0');
+  if (fread(&stored[0], stored_size, 1, file_) != 1) {
+    error_ = "Unexpected end of file.";
+    return false;
+  }
+  if (crc32_checksum(stored.data(), stored.size()) != checksum) {
+    error_ = "Checksum mismatch.";
+    return false;
+  }
+  if (flags & kBlockCompressed) {
+#ifdef ENABLE_ZLIB
+    block_.resize(raw_size);
+    uLongf actual_size = raw_size;
+    if (uncompress(reinterpret_cast<Bytef*>(&block_[0]),
+                   &actual_size,
+                   reinterpret_cast<const Bytef*>(stored.data()),
+                   stored.size()) != Z_OK || actual_size != raw_size) {
+      error_ = "Failed to uncompress a block.";
+      return false;
+    }
+#else
+    error_ = "Decompression requires the driver built with zlib.";
+    return false;
+#endif
+  }
+  else
+    block_.swap(stored);
+  position_ = 0;
+  return true;
+}
+
+} // namespace bdbmex
@@ -0,0 +1,95 @@
+/// Binary dump format for Berkeley DB matlab driver.
+///
+/// A dump file starts with an 8-byte magic and a format version, followed by
+/// blocks of records. Each block has a header of four little-endian 32-bit
+/// words: raw size, stored size, CRC-32 of the stored bytes, and flags. The
+/// stored bytes are the raw bytes, optionally zlib-compressed. Raw bytes are
+/// a sequence of records, each a length-prefixed encoded key followed by a
+/// length-prefixed encoded value. A block of zero raw size ends the file.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __DUMP_H__
+#define __DUMP_H__
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+
+namespace bdbmex {
+
+/// Writer of a dump file.
+class DumpWriter {
+public:
+  /// Create a closed writer.
+  DumpWriter();
+  /// Close the file without the end marker if still open.
+  virtual ~DumpWriter();
+  /// Create a dump file. Return false on error.
+  bool open(const std::string& path, bool compress);
+  /// Append an encoded record. Return false on error.
+  bool add(const void* key, size_t key_size,
+           const void* value, size_t value_size);
+  /// Write the remaining records and the end marker. Return false on error.
+  bool close();
+  /// Return the last error message.
+  const char* error_message() const { return error_.c_str(); }
+
+private:
+  /// Copy prohibited.
+  DumpWriter(const DumpWriter&);
+  DumpWriter& operator=(const DumpWriter&);
+  /// Write the buffered records as a block.
+  bool flush_block();
+
+  /// Output stream.
+  FILE* file_;
+  /// Compression flag.
+  bool compress_;
+  /// Raw bytes of the current block.
+  std::string block_;
+  /// Last error message.
+  std::string error_;
+};
+
+/// Reader of a dump file.
+class DumpReader {
+public:
+  /// Create a closed reader.
+  DumpReader();
+  /// Close the file.
+  virtual ~DumpReader();
+  /// Open a dump file and check the header. Return false on error.
+  bool open(const std::string& path);
+  /// Read the next encoded record. Return false at the end or on error.
+  bool next(std::string* key, std::string* value);
+  /// Return if the reader stopped on an error.
+  bool failed() const { return !error_.empty(); }
+  /// Return the last error message.
+  const char* error_message() const { return error_.c_str(); }
+
+private:
+  /// Copy prohibited.
+  DumpReader(const DumpReader&);
+  DumpReader& operator=(const DumpReader&);
+  /// Read and verify the next block. Return false at the end or on error.
+  bool read_block();
+
+  /// Input stream.
+  FILE* file_;
+  /// Raw bytes of the current block.
+  std::string block_;
+  /// Read position in the current block.
+  size_t position_;
+  /// Set after the end marker.
+  bool finished_;
+  /// Last error message.
+  std::string error_;
+};
+
+/// CRC-32 (IEEE 802.3) of a byte sequence.
+uint32_t crc32_checksum(const void* data, size_t size);
+
+} // namespace bdbmex
+
+#endif // __DUMP_H__
@@ -7,7 +7,9 @@
 #include "mex/function.h"
 #include "mex/mxarray.h"
 
+using bdbmex::Database;
 using bdbmex::Environment;
+using bdbmex::EnvironmentConfig;
 using bdbmex::Transaction;
 using mex::CheckInputArguments;
 using mex::CheckOutputArguments;
@@ -42,6 +44,13 @@ MEX_FUNCTION(env_open) (int nlhs,
   options.set("SystemMem",      false);
   options.set("Thread",         false);
   options.set("Mode",           0);
+  options.set("CacheSize",      0);
+  options.set("CacheRegions",   0);
+  options.set("MmapSize",       0);
+  options.set("LogBufferSize",  0);
+  options.set("WarmList",       string(""));
+  options.set("LogAutoRemove",  false);
+  options.set("CheckpointEvery", 0);
 
   string home = MxArray(prhs[0]).toString();
   options.update(prhs + 1, prhs + nrhs);
@@ -64,14 +73,29 @@ MEX_FUNCTION(env_open) (int nlhs,
       (options["SystemMem"].toBool()      ? DB_SYSTEM_MEM : 0) |
       (options["Thread"].toBool()         ? DB_THREAD : 0);
   int mode = options["Mode"].toInt();
+  EnvironmentConfig config;
+  config.cache_size = static_cast<uint64_t>(options["CacheSize"].toDouble());
+  config.cache_regions = options["CacheRegions"].toInt();
+  config.mmap_size = static_cast<size_t>(options["MmapSize"].toDouble());
+  config.log_buffer_size = options["LogBufferSize"].toInt();
+  config.log_auto_remove = options["LogAutoRemove"].toBool();
+  config.checkpoint_interval = options["CheckpointEvery"].toDouble();
+  // The checkpoint thread shares the environment handle.
+  if (config.checkpoint_interval > 0)
+    flags |= DB_THREAD;
 
   Environment* environment = NULL;
   int environment_id = Session<Environment>::create(&environment);
-  if (!environment->open(home, flags, mode)) {
+  if (!environment->open(home, flags, mode, config)) {
     const char* error_message = environment->error_message();
     Session<Environment>::destroy(environment_id);
     ERROR("Failed to open an environment: %s", error_message);
   }
+  int num_pages = 0;
+  string warm_list = options["WarmList"].toString();
+  if (!warm_list.empty() &&
+      !environment->load_warm_list(warm_list, &num_pages))
+    ERROR("Failed to load a warm list: %s", environment->error_message());
   plhs[0] = MxArray(environment_id).getMutable();
 }
 
@@ -83,6 +107,7 @@ MEX_FUNCTION(env_close) (int nlhs,
   CheckOutputArguments(0, 0, nlhs);
   VariableInputArguments options;
   options.set("Forcesync", false);
+  options.set("WarmList",  string(""));
 
   int environment_id = (nrhs == 0 || !MxArray(prhs[0]).isNumeric()) ?
       0 : MxArray(prhs[0]).toInt();
@@ -92,8 +117,131 @@ MEX_FUNCTION(env_close) (int nlhs,
   Environment* environment = Session<Environment>::get(environment_id);
   if (!environment)
     ERROR("No open environment found.");
-  environment->close(flags);
+  string warm_list = options["WarmList"].toString();
+  if (!warm_list.empty() && !environment->save_warm_list(warm_list))
+    ERROR("Failed to save a warm list: %s", environment->error_message());
+  bool closed = environment->close(flags);
+  const char* error_message = environment->error_message();
   Session<Environment>::destroy(environment_id);
+  if (!closed)
+    ERROR("Failed to close an environment: %s", error_message);
+}
+
+MEX_FUNCTION(checkpoint) (int nlhs,
+                          mxArray *plhs[],
+                          int nrhs,
+                          const mxArray *prhs[]) {
+  CheckInputArguments(0, 1024, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  VariableInputArguments options;
+  options.set("KBytes",  0);
+  options.set("Minutes", 0);
+  options.set("Force",   false);
+  int environment_id = (nrhs == 0 || !MxArray(prhs[0]).isNumeric()) ?
+      0 : MxArray(prhs[0]).toInt();
+  options.update(prhs, prhs + nrhs);
+  Environment* environment = Session<Environment>::get(environment_id);
+  if (!environment)
+    ERROR("No open environment found.");
+  if (!environment->checkpoint(options["KBytes"].toInt(),
+                               options["Minutes"].toInt(),
+                               (options["Force"].toBool() ? DB_FORCE : 0)))
+    ERROR("Failed to checkpoint: %s", environment->error_message());
+}
+
+MEX_FUNCTION(log_archive) (int nlhs,
+                           mxArray *plhs[],
+                           int nrhs,
+                           const mxArray *prhs[]) {
+  CheckInputArguments(0, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Abs",    false);
+  options.set("Data",   false);
+  options.set("Log",    false);
+  options.set("Remove", false);
+  int environment_id = (nrhs == 0 || !MxArray(prhs[0]).isNumeric()) ?
+      0 : MxArray(prhs[0]).toInt();
+  options.update(prhs, prhs + nrhs);
+  uint32_t flags =
+      (options["Abs"].toBool()    ? DB_ARCH_ABS : 0) |
+      (options["Data"].toBool()   ? DB_ARCH_DATA : 0) |
+      (options["Log"].toBool()    ? DB_ARCH_LOG : 0) |
+      (options["Remove"].toBool() ? DB_ARCH_REMOVE : 0);
+  Environment* environment = Session<Environment>::get(environment_id);
+  if (!environment)
+    ERROR("No open environment found.");
+  vector<string> files;
+  if (!environment->log_archive(flags, &files))
+    ERROR("Failed to archive logs: %s", environment->error_message());
+  plhs[0] = MxArray(files).getMutable();
+}
+
+MEX_FUNCTION(backup) (int nlhs,
+                      mxArray *plhs[],
+                      int nrhs,
+                      const mxArray *prhs[]) {
+  CheckInputArguments(1, 1024, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  VariableInputArguments options;
+  options.set("Incremental", false);
+  options.set("Clean",       false);
+  options.set("SingleDir",   false);
+  options.set("Rate",        0);
+  int environment_id = 0;
+  string target;
+  if (MxArray(prhs[0]).isNumeric()) {
+    if (nrhs < 2)
+      ERROR("Missing target directory.");
+    environment_id = MxArray(prhs[0]).toInt();
+    target = MxArray(prhs[1]).toString();
+    options.update(prhs + 2, prhs + nrhs);
+  }
+  else {
+    target = MxArray(prhs[0]).toString();
+    options.update(prhs + 1, prhs + nrhs);
+  }
+  uint32_t flags = DB_CREATE |
+      (options["Incremental"].toBool() ? DB_BACKUP_UPDATE : 0) |
+      (options["Clean"].toBool()       ? DB_BACKUP_CLEAN : 0) |
+      (options["SingleDir"].toBool()   ? DB_BACKUP_SINGLE_DIR : 0);
+  Environment* environment = Session<Environment>::get(environment_id);
+  if (!environment)
+    ERROR("No open environment found.");
+  if (!environment->backup(target, flags, options["Rate"].toDouble()))
+    ERROR("Failed to back up: %s", environment->error_message());
+}
+
+MEX_FUNCTION(env_stat) (int nlhs,
+                        mxArray *plhs[],
+                        int nrhs,
+                        const mxArray *prhs[]) {
+  CheckInputArguments(0, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Database", 0);
+  options.set("Clear",    false);
+  options.update(prhs, prhs + nrhs);
+  uint32_t flags = (options["Clear"].toBool() ? DB_STAT_CLEAR : 0);
+  if (options["Database"].toInt() != 0) {
+    Database* database = Session<Database>::get(options["Database"].toInt());
+    if (!database->env_stat(flags, &plhs[0]))
+      ERROR("Failed to query stat: %s", database->error_message());
+    return;
+  }
+  Environment* environment = Session<Environment>::get(
+      (nrhs == 0 || !MxArray(prhs[0]).isNumeric()) ?
+      0 : MxArray(prhs[0]).toInt());
+  if (environment) {
+    if (!environment->stat(flags, &plhs[0]))
+      ERROR("Failed to query stat: %s", environment->error_message());
+    return;
+  }
+  Database* database = Session<Database>::get(0);
+  if (!database)
+    ERROR("No open environment found.");
+  if (!database->env_stat(flags, &plhs[0]))
+    ERROR("Failed to query stat: %s", database->error_message());
 }
 
 MEX_FUNCTION(begin) (int nlhs,
@@ -4,7 +4,14 @@
 
 #include "libbdbmex.h"
 #include "mex/mxarray.h"
+#include "stream.h"
+#include "value_log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
+#include <limits>
 #ifdef ENABLE_ZLIB
 #include <zlib.h>
 #endif
@@ -35,6 +42,7 @@ EXTERN_C mxArray* mxDeserialize(const void *, size_t);
 
 namespace mex {
 
+template class Session<bdbmex::AsyncOperation>;
 template class Session<bdbmex::Cursor>;
 template class Session<bdbmex::Database>;
 template class Session<bdbmex::Environment>;
@@ -44,6 +52,81 @@ template class Session<bdbmex::Transaction>;
 
 namespace bdbmex {
 
+/// Bytes in a gigabyte, the unit of cache size in Berkeley DB.
+static const uint64_t kGigaBytes = 1024 * 1024 * 1024;
+
+/// Approximate size of the page header.
+static const uint32_t kPageOverhead = 26;
+
+/// Approximate per-item overhead in a leaf page.
+static const uint32_t kItemOverhead = 8;
+
+/// Largest item stored on a leaf page before it is moved to overflow pages,
+/// assuming the default minimum of two keys per page.
+static uint32_t overflow_size(uint32_t page_size) {
+  return (page_size - kPageOverhead) / 4 - kItemOverhead;
+}
+
+/// Number of worker threads of asynchronous operations per database.
+static const int kAsyncThreads = 4;
+
+/// Initial buffer size of bulk retrieval.
+static const uint32_t kBulkBufferSize = 4 << 20;
+
+/// Number of records stored in a transaction on import.
+static const int kImportBatchSize = 10000;
+
+/// Type tags of index keys, ordering numbers before strings.
+enum IndexKeyTag {
+  kIndexNumber = 1,
+  kIndexChar = 2,
+  kIndexOther = 3
+};
+
+/// The page offsets below follow the on-disk format of Berkeley DB 4.8 to
+/// 6.2, with an optional checksum and without encryption.
+#if (DB_VERSION_MAJOR == 4 && DB_VERSION_MINOR >= 8) || \
+    DB_VERSION_MAJOR == 5 || (DB_VERSION_MAJOR == 6 && DB_VERSION_MINOR <= 2)
+#define HAVE_PAGE_LAYOUT
+#endif
+
+/// Offset of the entry count in the page header.
+static const int kPageEntriesOffset = 20;
+
+/// Offset of the tree level in the page header.
+static const int kPageLevelOffset = 24;
+
+/// Offset of the page type in the page header.
+static const int kPageTypeOffset = 25;
+
+/// Size of the page header, followed by the item offsets.
+static const size_t kPageHeaderSize = 26;
+
+/// Size of the page checksum following the header of a checksummed file.
+static const size_t kPageChecksumSize = 20;
+
+/// Offset of the magic number in a meta page.
+static const int kMetaMagicOffset = 12;
+
+/// Magic number of the btree and recno meta page.
+static const uint32_t kBtreeMagic = 0x053162;
+
+/// Offset of the root page number in the btree meta page.
+static const int kMetaRootOffset = 88;
+
+/// Page types of the btree and recno access methods.
+enum PageType {
+  kInternalBtreePage = 3,
+  kInternalRecnoPage = 4,
+  kBtreeMetaPage = 9
+};
+
+/// Tree level of leaf pages. Interior pages have larger levels.
+static const uint8_t kLeafLevel = 1;
+
+/// Maximum number of attempts of a read-modify-write on deadlock.
+static const int kUpdateRetries = 10;
+
 Record::Record() {
   reset(DB_DBT_REALLOC, DB_DBT_REALLOC);
 }
@@ -53,16 +136,16 @@ Record::Record(const mxArray* key) {
   set_key(key);
 }
 
-Record::Record(const mxArray* key, const mxArray* value) {
+Record::Record(const mxArray* key, const mxArray* value, bool native) {
   reset(DB_DBT_USERMEM, DB_DBT_USERMEM);
   set_key(key);
-  set_value(value);
+  set_value(value, native);
 }
 
 Record::~Record() {
-  if (key_.flags == DB_DBT_REALLOC && key_.data)
+  if ((key_.flags & DB_DBT_REALLOC) && key_.data)
     free(key_.data);
-  if (value_.flags == DB_DBT_REALLOC && value_.data)
+  if ((value_.flags & DB_DBT_REALLOC) && value_.data)
     free(value_.data);
 }
 
@@ -71,6 +154,8 @@ void Record::reset(u_int32_t key_flags, u_int32_t value_flags) {
   memset(&value_, 0, sizeof(DBT));
   key_.flags = key_flags;
   value_.flags = value_flags;
+  key_type_ = DB_UNKNOWN;
+  value_log_ = NULL;
 }
 
 void Record::set_key(const mxArray* key) {
@@ -79,22 +164,268 @@ void Record::set_key(const mxArray* key) {
   key_.size = key_buffer_.size();
 }
 
-void Record::set_value(const mxArray* value) {
-  compress_mxarray(value, &value_buffer_);
+void Record::set_value(const mxArray* value, bool native) {
+  string bytes;
+  if (native && encode_native(value, &bytes))
+    value_buffer_.assign(bytes.begin(), bytes.end());
+  else
+    compress_mxarray(value, &value_buffer_);
   value_.data = &value_buffer_[0];
   value_.size = value_buffer_.size();
 }
 
 void Record::get_key(mxArray** key) {
+  if ((key_type_ == DB_RECNO || key_type_ == DB_QUEUE) &&
+      key_.size == sizeof(db_recno_t)) {
+    db_recno_t recno;
+    memcpy(&recno, key_.data, sizeof(db_recno_t));
+    *key = mxCreateDoubleScalar(recno);
+    return;
+  }
+#ifdef HAVE_DB_HEAP
+  if (key_type_ == DB_HEAP && key_.size == sizeof(DB_HEAP_RID)) {
+    DB_HEAP_RID rid;
+    memcpy(&rid, key_.data, sizeof(DB_HEAP_RID));
+    *key = mxCreateDoubleMatrix(1, 2, mxREAL);
+    mxGetPr(*key)[0] = rid.pgno;
+    mxGetPr(*key)[1] = rid.indx;
+    return;
+  }
+#endif
   const uint8_t* key_data = static_cast<const uint8_t*>(key_.data);
   key_buffer_.assign(key_data, key_data + key_.size);
-  deserialize_mxarray(key_buffer_, key);
+  const char* error_message = deserialize_mxarray(key_buffer_, key);
+  if (error_message)
+    ERROR("%s", error_message);
 }
 
 void Record::get_value(mxArray** value) {
-  const uint8_t* value_data = static_cast<const uint8_t*>(value_.data);
-  value_buffer_.assign(value_data, value_data + value_.size);
-  decompress_mxarray(value_buffer_, value);
+  if (value_.flags & DB_DBT_PARTIAL)
+    ERROR("Values are not read by a keys-only cursor.");
+  string error_message;
+  if (!decode_value(value_.data, value_.size, value_log_, value, &error_message))
+    ERROR("%s", error_message.c_str());
+}
+
+void Record::set_keys_only() {
+  if (value_.flags != DB_DBT_REALLOC)
+    ERROR("Record is not for cursor operation.");
+  value_.flags |= DB_DBT_PARTIAL;
+  value_.dlen = 0;
+  value_.doff = 0;
+}
+
+void Record::set_value_bytes(const string& bytes) {
+  if (value_.flags != DB_DBT_USERMEM)
+    ERROR("Record is not for store.");
+  value_buffer_.assign(bytes.begin(), bytes.end());
+  value_.data = &value_buffer_[0];
+  value_.size = value_buffer_.size();
+}
+
+bool Record::decode_value(const void* data,
+                          size_t size,
+                          ValueLog* value_log,
+                          mxArray** value,
+                          string* error_message) {
+  *value = NULL;
+  ValuePointer pointer;
+  string bytes;
+  if (ValueLog::read_pointer(data, size, &pointer)) {
+    if (value_log == NULL) {
+      *error_message = "Value is stored in a value log.";
+      return false;
+    }
+    if (!value_log->read(pointer, &bytes)) {
+      *error_message = string("Failed to read a value log: ") +
+                       value_log->error_message();
+      return false;
+    }
+    data = bytes.data();
+    size = bytes.size();
+  }
+  NativeHeader header;
+  if (read_native_header(data, size, &header)) {
+    if (header.rows * header.columns * native_element_size(
+            static_cast<mxClassID>(header.class_id)) !=
+        size - sizeof(NativeHeader)) {
+      *error_message = "Corrupted native value.";
+      return false;
+    }
+    *value = create_native_array(header);
+    if (size > sizeof(NativeHeader))
+      memcpy(mxGetData(*value),
+             static_cast<const uint8_t*>(data) + sizeof(NativeHeader),
+             size - sizeof(NativeHeader));
+    return true;
+  }
+  const uint8_t* value_data = static_cast<const uint8_t*>(data);
+  const char* message = decompress_mxarray(
+      vector<uint8_t>(value_data, value_data + size), value);
+  if (message) {
+    *error_message = message;
+    return false;
+  }
+  return true;
+}
+
+void Record::assign(const string& key, const string& value) {
+  if (!(key_.flags & DB_DBT_REALLOC) || !(value_.flags & DB_DBT_REALLOC))
+    ERROR("Record is not for cursor operation.");
+  key_.data = realloc(key_.data, (key.empty()) ? 1 : key.size());
+  value_.data = realloc(value_.data, (value.empty()) ? 1 : value.size());
+  if (key_.data == NULL || value_.data == NULL)
+    ERROR("Failed to allocate memory.");
+  memcpy(key_.data, key.data(), key.size());
+  memcpy(value_.data, value.data(), value.size());
+  key_.size = key.size();
+  value_.size = value.size();
+}
+
+void Record::encode_value(const mxArray* value, string* bytes) {
+  Record record;
+  vector<uint8_t> binary;
+  record.compress_mxarray(value, &binary);
+  bytes->assign(binary.begin(), binary.end());
+}
+
+bool Record::encode_native(const mxArray* value, string* bytes) {
+  if (value == NULL || mxIsSparse(value) || mxIsComplex(value) ||
+      mxGetNumberOfDimensions(value) != 2 ||
+      native_element_size(mxGetClassID(value)) == 0)
+    return false;
+  NativeHeader header;
+  make_native_header(mxGetClassID(value),
+                     mxGetM(value),
+                     mxGetN(value),
+                     &header);
+  size_t data_size = mxGetNumberOfElements(value) * mxGetElementSize(value);
+  bytes->resize(sizeof(NativeHeader) + data_size);
+  memcpy(&(*bytes)[0], &header, sizeof(NativeHeader));
+  if (data_size)
+    memcpy(&(*bytes)[sizeof(NativeHeader)], mxGetData(value), data_size);
+  return true;
+}
+
+void Record::make_native_header(mxClassID class_id,
+                                uint64_t rows,
+                                uint64_t columns,
+                                NativeHeader* header) {
+  memset(header, 0, sizeof(NativeHeader));
+  header->magic[0] = 0xFF;
+  header->magic[1] = 'N';
+  header->magic[2] = 'A';
+  header->magic[3] = 'T';
+  header->class_id = static_cast<uint8_t>(class_id);
+  header->sentinel = 0xFF;
+  header->rows = rows;
+  header->columns = columns;
+}
+
+bool Record::is_native(const void* data, size_t size) {
+  NativeHeader header;
+  return read_native_header(data, size, &header);
+}
+
+bool Record::read_native_header(const void* data,
+                                size_t size,
+                                NativeHeader* header) {
+  if (data == NULL || size < sizeof(NativeHeader))
+    return false;
+  memcpy(header, data, sizeof(NativeHeader));
+  return header->magic[0] == 0xFF && header->magic[1] == 'N' &&
+         header->magic[2] == 'A' && header->magic[3] == 'T' &&
+         header->sentinel == 0xFF &&
+         native_element_size(static_cast<mxClassID>(header->class_id)) > 0;
+}
+
+size_t Record::native_element_size(mxClassID class_id) {
+  switch (class_id) {
+    case mxLOGICAL_CLASS: return sizeof(mxLogical);
+    case mxCHAR_CLASS:    return sizeof(mxChar);
+    case mxDOUBLE_CLASS:  return sizeof(double);
+    case mxSINGLE_CLASS:  return sizeof(float);
+    case mxINT8_CLASS:
+    case mxUINT8_CLASS:   return 1;
+    case mxINT16_CLASS:
+    case mxUINT16_CLASS:  return 2;
+    case mxINT32_CLASS:
+    case mxUINT32_CLASS:  return 4;
+    case mxINT64_CLASS:
+    case mxUINT64_CLASS:  return 8;
+    default:              return 0;
+  }
+}
+
+mxArray* Record::create_native_array(const NativeHeader& header) {
+  mwSize rows = static_cast<mwSize>(header.rows);
+  mwSize columns = static_cast<mwSize>(header.columns);
+  mxClassID class_id = static_cast<mxClassID>(header.class_id);
+  mxArray* array = NULL;
+  if (class_id == mxLOGICAL_CLASS)
+    array = mxCreateLogicalMatrix(rows, columns);
+  else if (class_id == mxCHAR_CLASS) {
+    mwSize dimensions[] = {rows, columns};
+    array = mxCreateCharArray(2, dimensions);
+  }
+  else
+    array = mxCreateNumericMatrix(rows, columns, class_id, mxREAL);
+  if (array == NULL)
+    ERROR("Null pointer exception.");
+  return array;
+}
+
+void Record::set_native_key(const mxArray* key, DBTYPE type) {
+  key_type_ = type;
+  if (type == DB_RECNO || type == DB_QUEUE) {
+    MxArray recno(key);
+    if (!recno.isNumeric() || recno.numel() != 1 || recno.toDouble() < 1)
+      ERROR("Key must be a positive record number.");
+    db_recno_t value = static_cast<db_recno_t>(recno.toDouble());
+    key_buffer_.resize(sizeof(db_recno_t));
+    memcpy(&key_buffer_[0], &value, sizeof(db_recno_t));
+  }
+#ifdef HAVE_DB_HEAP
+  else if (type == DB_HEAP) {
+    MxArray rid_array(key);
+    if (!rid_array.isNumeric() || rid_array.numel() != 2)
+      ERROR("Key must be a record id [pgno, indx].");
+    DB_HEAP_RID rid;
+    memset(&rid, 0, sizeof(DB_HEAP_RID));
+    rid.pgno = static_cast<db_pgno_t>(rid_array.at<double>(0));
+    rid.indx = static_cast<db_indx_t>(rid_array.at<double>(1));
+    key_buffer_.resize(sizeof(DB_HEAP_RID));
+    memcpy(&key_buffer_[0], &rid, sizeof(DB_HEAP_RID));
+  }
+#endif
+  else {
+    return;
+  }
+  key_.data = &key_buffer_[0];
+  key_.size = key_buffer_.size();
+  key_.ulen = key_buffer_.size();
+}
+
+void Record::set_append_key(DBTYPE type) {
+  key_type_ = type;
+#ifdef HAVE_DB_HEAP
+  key_buffer_.assign((type == DB_HEAP) ? sizeof(DB_HEAP_RID) :
+                                         sizeof(db_recno_t), 0);
+#else
+  key_buffer_.assign(sizeof(db_recno_t), 0);
+#endif
+  key_.data = &key_buffer_[0];
+  key_.size = 0;
+  key_.ulen = key_buffer_.size();
+  key_.flags = DB_DBT_USERMEM;
+}
+
+bool Record::has_native_keys(DBTYPE type) {
+#ifdef HAVE_DB_HEAP
+  if (type == DB_HEAP)
+    return true;
+#endif
+  return type == DB_RECNO || type == DB_QUEUE;
 }
 
 void Record::serialize_mxarray(const mxArray* value, vector<uint8_t>* binary) {
@@ -106,11 +437,11 @@ void Record::serialize_mxarray(const mxArray* value, vector<uint8_t>* binary) {
   mxDestroyArray(serialized_array);
 }
 
-void Record::deserialize_mxarray(const vector<uint8_t>& binary,
-                                 mxArray** value) {
-  *value = static_cast<mxArray*>(mxDeserialize(&binary[0], binary.size()));
-  if (*value == NULL)
-    ERROR("Failed to deserialize mxArray.");
+const char* Record::deserialize_mxarray(const vector<uint8_t>& binary,
+                                        mxArray** value) {
+  *value = (binary.empty()) ? NULL :
+      static_cast<mxArray*>(mxDeserialize(&binary[0], binary.size()));
+  return (*value == NULL) ? "Failed to deserialize mxArray." : NULL;
 }
 
 #ifdef ENABLE_ZLIB
@@ -136,10 +467,11 @@ void Record::compress_mxarray(const mxArray* value, vector<uint8_t>* binary) {
     ERROR("Fatal error in compress_mxarray");
 }
 
-void Record::decompress_mxarray(const vector<uint8_t>& binary,
-                                mxArray** value) {
-  if (binary.size() <= sizeof(uint32_t))
-    ERROR("Fatal error in decompress_mxarray: invalid binary.");
+const char* Record::decompress_mxarray(const vector<uint8_t>& binary,
+                                       mxArray** value) {
+  *value = NULL;
+  if (binary.size() <= sizeof(uLongf))
+    return "Fatal error in decompress_mxarray: invalid binary.";
   uLongf array_size = 0;
   memcpy(&array_size, &binary[0], sizeof(uLongf));
   vector<uint8_t> buffer(array_size);
@@ -148,11 +480,9 @@ void Record::decompress_mxarray(const vector<uint8_t>& binary,
                          &actual_size,
                          &binary[0] + sizeof(uLongf),
                          binary.size() - sizeof(uLongf));
-  *value = static_cast<mxArray*>(mxDeserialize(&buffer[0], buffer.size()));
-  if (*value == NULL)
-    ERROR("Failed to deserialize mxArray.");
   if (code_ != Z_OK)
-    ERROR("Fatal error in decompress_mxarray: code = %d.", code_);
+    return "Fatal error in decompress_mxarray: corrupted binary.";
+  return deserialize_mxarray(buffer, value);
 }
 
 #else
@@ -161,54 +491,138 @@ void Record::compress_mxarray(const mxArray* value, vector<uint8_t>* binary) {
   serialize_mxarray(value, binary);
 }
 
-void Record::decompress_mxarray(const vector<uint8_t>& binary,
-                                mxArray** value) {
-  deserialize_mxarray(binary, value);
+const char* Record::decompress_mxarray(const vector<uint8_t>& binary,
+                                       mxArray** value) {
+  return deserialize_mxarray(binary, value);
 }
 
 #endif // ENABLE_ZLIB
 
 Cursor::~Cursor() {
+  delete reader_;
   if (cursor_)
     cursor_->close(cursor_);
 }
 
-int Cursor::open(DB* database_) {
+int Cursor::open(DB* database_, int prefetch, bool keys_only) {
+  DBTYPE type;
+  code_ = database_->get_type(database_, &type);
+  if (code_ != 0)
+    return code_;
+  record_.set_key_type(type);
+  if (keys_only)
+    record_.set_keys_only();
   code_ = database_->cursor(database_, NULL, &cursor_, 0);
+  if (code_ == 0 && prefetch > 0) {
+    reader_ = new CursorReader(cursor_, prefetch, keys_only);
+    if (!reader_->start())
+      code_ = EAGAIN;
+  }
   return code_;
 }
 
 int Cursor::next() {
+  if (reader_) {
+    string key, value;
+    code_ = reader_->pop(&key, &value);
+    if (code_ == 0)
+      record_.assign(key, value);
+    return code_;
+  }
   code_ = cursor_->get(cursor_, record_.key(), record_.value(), DB_NEXT);
   return code_;
 }
 
 int Cursor::prev() {
+  if (reader_) {
+    code_ = EINVAL;
+    return code_;
+  }
   code_ = cursor_->get(cursor_, record_.key(), record_.value(), DB_PREV);
   return code_;
 }
 
-Environment::Environment() : environment_(NULL) {}
+int Cursor::next_nodup() {
+  if (reader_) {
+    code_ = EINVAL;
+    return code_;
+  }
+  code_ = cursor_->get(cursor_, record_.key(), record_.value(), DB_NEXT_NODUP);
+  return code_;
+}
+
+Environment::Environment() : code_(0),
+                             environment_(NULL),
+                             checkpointer_(NULL) {}
 
 Environment::~Environment() {
   close(0);
 }
 
-bool Environment::open(const string& home, uint32_t flags, int mode) {
+bool Environment::open(const string& home,
+                       uint32_t flags,
+                       int mode,
+                       const EnvironmentConfig& config) {
   code_ = db_env_create(&environment_, 0);
   if (!ok()) return false;
+  if (config.cache_size) {
+    code_ = environment_->set_cachesize(
+        environment_,
+        static_cast<u_int32_t>(config.cache_size / kGigaBytes),
+        static_cast<u_int32_t>(config.cache_size % kGigaBytes),
+        config.cache_regions);
+    if (!ok()) return false;
+  }
+  if (config.mmap_size) {
+    code_ = environment_->set_mp_mmapsize(environment_, config.mmap_size);
+    if (!ok()) return false;
+  }
+  if (config.log_buffer_size) {
+    code_ = environment_->set_lg_bsize(environment_, config.log_buffer_size);
+    if (!ok()) return false;
+  }
   code_ = environment_->open(environment_,
                              home.c_str(),
                              flags,
                              mode);
+  if (!ok()) return false;
+  if (config.log_auto_remove) {
+    code_ = environment_->log_set_config(environment_,
+                                         DB_LOG_AUTO_REMOVE,
+                                         1);
+    if (!ok()) return false;
+  }
+  if (config.checkpoint_interval > 0) {
+    if (!(flags & DB_INIT_TXN) || !(flags & DB_THREAD)) {
+      code_ = EINVAL;
+      return false;
+    }
+    checkpointer_ = new Checkpointer(environment_,
+                                     config.checkpoint_interval);
+    if (!checkpointer_->start()) {
+      code_ = EAGAIN;
+      return false;
+    }
+  }
   return ok();
 }
 
 bool Environment::close(uint32_t flags) {
+  int checkpoint_code = 0;
+  if (checkpointer_) {
+    checkpoint_code = checkpointer_->error_code();
+    delete checkpointer_;
+    checkpointer_ = NULL;
+    // Leave little to replay on the next open.
+    if (!checkpoint(0, 0, 0))
+      checkpoint_code = code_;
+  }
   if (environment_) {
     code_ = environment_->close(environment_, flags);
     environment_ = NULL;
   }
+  if (ok())
+    code_ = checkpoint_code;
   return ok();
 }
 
@@ -224,6 +638,391 @@ bool Environment::txn_begin(uint32_t flags,
   return ok();
 }
 
+bool Environment::checkpoint(uint32_t kbytes,
+                             uint32_t minutes,
+                             uint32_t flags) {
+  code_ = environment_->txn_checkpoint(environment_, kbytes, minutes, flags);
+  return ok();
+}
+
+bool Environment::log_archive(uint32_t flags, vector<string>* files) {
+  char** list = NULL;
+  code_ = environment_->log_archive(environment_, &list, flags);
+  if (!ok()) return false;
+  files->clear();
+  for (char** file = list; file != NULL && *file != NULL; ++file)
+    files->push_back(*file);
+  if (list)
+    free(list);
+  return ok();
+}
+
+bool Environment::backup(const string& target, uint32_t flags, double rate) {
+#if DB_VERSION_MAJOR > 5 || (DB_VERSION_MAJOR == 5 && DB_VERSION_MINOR >= 3)
+  // Throttle by sleeping after each chunk of about a megabyte of pages.
+  uint32_t read_count = 0;
+  uint32_t read_sleep = 0;
+  if (rate > 0) {
+    uint32_t page_size = 0;
+    DB_MPOOL_STAT* pool_stats = NULL;
+    DB_MPOOL_FSTAT** file_stats = NULL;
+    code_ = environment_->memp_stat(environment_,
+                                    &pool_stats,
+                                    &file_stats,
+                                    0);
+    if (!ok()) return false;
+    for (DB_MPOOL_FSTAT** file = file_stats; file && *file; ++file)
+      page_size = max(page_size, (*file)->st_pagesize);
+    free(pool_stats);
+    if (file_stats)
+      free(file_stats);
+    if (page_size == 0)
+      page_size = 4096;
+    read_count = max<uint32_t>(1, (1024 * 1024) / page_size);
+    read_sleep = static_cast<uint32_t>(
+        1e6 * read_count * page_size / (rate * 1024 * 1024));
+  }
+  code_ = environment_->set_backup_config(environment_,
+                                          DB_BACKUP_READ_COUNT,
+                                          read_count);
+  if (!ok()) return false;
+  code_ = environment_->set_backup_config(environment_,
+                                          DB_BACKUP_READ_SLEEP,
+                                          read_sleep);
+  if (!ok()) return false;
+  code_ = environment_->backup(environment_, target.c_str(), flags);
+#else
+  code_ = DB_OPNOTSUP;
+#endif
+  return ok();
+}
+
+bool Environment::stat(uint32_t flags, mxArray** output) {
+  code_ = stat(environment_, flags, output);
+  if (!ok() || checkpointer_ == NULL)
+    return ok();
+  const char* kCheckpointFields[] = {"count", "error"};
+  MxArray checkpoint = MxArray::Struct(2, kCheckpointFields);
+  int code = checkpointer_->error_code();
+  checkpoint.set(kCheckpointFields[0],
+                 static_cast<double>(checkpointer_->count()));
+  checkpoint.set(kCheckpointFields[1],
+                 string((code) ? db_strerror(code) : ""));
+  mxSetField(*output, 0, "checkpoint", checkpoint.getMutable());
+  return true;
+}
+
+int Environment::stat(DB_ENV* environment, uint32_t flags, mxArray** output) {
+  uint32_t open_flags = 0;
+  int code = environment->get_open_flags(environment, &open_flags);
+  if (code) return code;
+  const char* kFields[] = {"mpool", "files", "lock", "log", "txn",
+                           "checkpoint"};
+  MxArray output_data = MxArray::Struct(6, kFields);
+  if (open_flags & DB_INIT_MPOOL) {
+    DB_MPOOL_STAT* stats;
+    DB_MPOOL_FSTAT** file_stats;
+    code = environment->memp_stat(environment, &stats, &file_stats, flags);
+    if (code) {
+      output_data.destroy();
+      return code;
+    }
+    const char* kMPoolFields[] = {
+        "gbytes", "bytes", "ncache", "regsize", "mmapsize", "maxopenfd",
+        "maxwrite", "pages", "map", "cache_hit", "cache_miss", "hit_ratio",
+        "page_create", "page_in", "page_out", "ro_evict", "rw_evict",
+        "page_trickle", "page_clean", "page_dirty", "hash_buckets",
+        "hash_searches", "hash_longest", "hash_examined", "hash_nowait",
+        "hash_wait", "region_nowait", "region_wait", "alloc",
+        "sync_interrupted"
+        };
+    MxArray mpool = MxArray::Struct(30, kMPoolFields);
+    double requests = double(stats->st_cache_hit) + stats->st_cache_miss;
+    mpool.set(kMPoolFields[0], double(stats->st_gbytes));
+    mpool.set(kMPoolFields[1], double(stats->st_bytes));
+    mpool.set(kMPoolFields[2], double(stats->st_ncache));
+    mpool.set(kMPoolFields[3], double(stats->st_regsize));
+    mpool.set(kMPoolFields[4], double(stats->st_mmapsize));
+    mpool.set(kMPoolFields[5], double(stats->st_maxopenfd));
+    mpool.set(kMPoolFields[6], double(stats->st_maxwrite));
+    mpool.set(kMPoolFields[7], double(stats->st_pages));
+    mpool.set(kMPoolFields[8], double(stats->st_map));
+    mpool.set(kMPoolFields[9], double(stats->st_cache_hit));
+    mpool.set(kMPoolFields[10], double(stats->st_cache_miss));
+    mpool.set(kMPoolFields[11], (requests > 0) ?
+        stats->st_cache_hit / requests : MxArray::NaN());
+    mpool.set(kMPoolFields[12], double(stats->st_page_create));
+    mpool.set(kMPoolFields[13], double(stats->st_page_in));
+    mpool.set(kMPoolFields[14], double(stats->st_page_out));
+    mpool.set(kMPoolFields[15], double(stats->st_ro_evict));
+    mpool.set(kMPoolFields[16], double(stats->st_rw_evict));
+    mpool.set(kMPoolFields[17], double(stats->st_page_trickle));
+    mpool.set(kMPoolFields[18], double(stats->st_page_clean));
+    mpool.set(kMPoolFields[19], double(stats->st_page_dirty));
+    mpool.set(kMPoolFields[20], double(stats->st_hash_buckets));
+    mpool.set(kMPoolFields[21], double(stats->st_hash_searches));
+    mpool.set(kMPoolFields[22], double(stats->st_hash_longest));
+    mpool.set(kMPoolFields[23], double(stats->st_hash_examined));
+    mpool.set(kMPoolFields[24], double(stats->st_hash_nowait));
+    mpool.set(kMPoolFields[25], double(stats->st_hash_wait));
+    mpool.set(kMPoolFields[26], double(stats->st_region_nowait));
+    mpool.set(kMPoolFields[27], double(stats->st_region_wait));
+    mpool.set(kMPoolFields[28], double(stats->st_alloc));
+    mpool.set(kMPoolFields[29], double(stats->st_sync_interrupted));
+    output_data.set(kFields[0], mpool.getMutable());
+    free(stats);
+    int num_files = 0;
+    while (file_stats != NULL && file_stats[num_files] != NULL)
+      ++num_files;
+    const char* kFileFields[] = {
+        "file_name", "pagesize", "map", "cache_hit", "cache_miss",
+        "hit_ratio", "page_create", "page_in", "page_out"
+        };
+    MxArray files = MxArray::Struct(9, kFileFields, num_files, 1);
+    for (int i = 0; i < num_files; ++i) {
+      const DB_MPOOL_FSTAT* file = file_stats[i];
+      double file_requests = double(file->st_cache_hit) + file->st_cache_miss;
+      files.set(kFileFields[0], string(file->file_name), i);
+      files.set(kFileFields[1], double(file->st_pagesize), i);
+      files.set(kFileFields[2], double(file->st_map), i);
+      files.set(kFileFields[3], double(file->st_cache_hit), i);
+      files.set(kFileFields[4], double(file->st_cache_miss), i);
+      files.set(kFileFields[5], (file_requests > 0) ?
+          file->st_cache_hit / file_requests : MxArray::NaN(), i);
+      files.set(kFileFields[6], double(file->st_page_create), i);
+      files.set(kFileFields[7], double(file->st_page_in), i);
+      files.set(kFileFields[8], double(file->st_page_out), i);
+    }
+    output_data.set(kFields[1], files.getMutable());
+    free(file_stats);
+  }
+  if (open_flags & DB_INIT_LOCK) {
+    DB_LOCK_STAT* stats;
+    code = environment->lock_stat(environment, &stats, flags);
+    if (code) {
+      output_data.destroy();
+      return code;
+    }
+    const char* kLockFields[] = {
+        "id", "cur_maxid", "maxlocks", "maxlockers", "maxobjects", "nmodes",
+        "nlockers", "maxnlockers", "nlocks", "maxnlocks", "nobjects",
+        "maxnobjects", "nrequests", "nreleases", "nupgrade", "ndowngrade",
+        "lock_wait", "lock_nowait", "ndeadlocks", "locktimeout",
+        "nlocktimeouts", "txntimeout", "ntxntimeouts", "region_wait",
+        "region_nowait", "regsize"
+        };
+    MxArray lock = MxArray::Struct(26, kLockFields);
+    lock.set(kLockFields[0], double(stats->st_id));
+    lock.set(kLockFields[1], double(stats->st_cur_maxid));
+    lock.set(kLockFields[2], double(stats->st_maxlocks));
+    lock.set(kLockFields[3], double(stats->st_maxlockers));
+    lock.set(kLockFields[4], double(stats->st_maxobjects));
+    lock.set(kLockFields[5], double(stats->st_nmodes));
+    lock.set(kLockFields[6], double(stats->st_nlockers));
+    lock.set(kLockFields[7], double(stats->st_maxnlockers));
+    lock.set(kLockFields[8], double(stats->st_nlocks));
+    lock.set(kLockFields[9], double(stats->st_maxnlocks));
+    lock.set(kLockFields[10], double(stats->st_nobjects));
+    lock.set(kLockFields[11], double(stats->st_maxnobjects));
+    lock.set(kLockFields[12], double(stats->st_nrequests));
+    lock.set(kLockFields[13], double(stats->st_nreleases));
+    lock.set(kLockFields[14], double(stats->st_nupgrade));
+    lock.set(kLockFields[15], double(stats->st_ndowngrade));
+    lock.set(kLockFields[16], double(stats->st_lock_wait));
+    lock.set(kLockFields[17], double(stats->st_lock_nowait));
+    lock.set(kLockFields[18], double(stats->st_ndeadlocks));
+    lock.set(kLockFields[19], double(stats->st_locktimeout));
+    lock.set(kLockFields[20], double(stats->st_nlocktimeouts));
+    lock.set(kLockFields[21], double(stats->st_txntimeout));
+    lock.set(kLockFields[22], double(stats->st_ntxntimeouts));
+    lock.set(kLockFields[23], double(stats->st_region_wait));
+    lock.set(kLockFields[24], double(stats->st_region_nowait));
+    lock.set(kLockFields[25], double(stats->st_regsize));
+    output_data.set(kFields[2], lock.getMutable());
+    free(stats);
+  }
+  if (open_flags & DB_INIT_LOG) {
+    DB_LOG_STAT* stats;
+    code = environment->log_stat(environment, &stats, flags);
+    if (code) {
+      output_data.destroy();
+      return code;
+    }
+    const char* kLogFields[] = {
+        "magic", "version", "mode", "lg_bsize", "lg_size", "record",
+        "w_bytes", "wc_bytes", "wcount", "wcount_fill", "rcount", "scount",
+        "cur_file", "cur_offset", "disk_file", "disk_offset",
+        "maxcommitperflush", "mincommitperflush", "region_wait",
+        "region_nowait", "regsize"
+        };
+    MxArray log = MxArray::Struct(21, kLogFields);
+    log.set(kLogFields[0], double(stats->st_magic));
+    log.set(kLogFields[1], double(stats->st_version));
+    log.set(kLogFields[2], double(stats->st_mode));
+    log.set(kLogFields[3], double(stats->st_lg_bsize));
+    log.set(kLogFields[4], double(stats->st_lg_size));
+    log.set(kLogFields[5], double(stats->st_record));
+    log.set(kLogFields[6], 1048576.0 * stats->st_w_mbytes + stats->st_w_bytes);
+    log.set(kLogFields[7],
+            1048576.0 * stats->st_wc_mbytes + stats->st_wc_bytes);
+    log.set(kLogFields[8], double(stats->st_wcount));
+    log.set(kLogFields[9], double(stats->st_wcount_fill));
+    log.set(kLogFields[10], double(stats->st_rcount));
+    log.set(kLogFields[11], double(stats->st_scount));
+    log.set(kLogFields[12], double(stats->st_cur_file));
+    log.set(kLogFields[13], double(stats->st_cur_offset));
+    log.set(kLogFields[14], double(stats->st_disk_file));
+    log.set(kLogFields[15], double(stats->st_disk_offset));
+    log.set(kLogFields[16], double(stats->st_maxcommitperflush));
+    log.set(kLogFields[17], double(stats->st_mincommitperflush));
+    log.set(kLogFields[18], double(stats->st_region_wait));
+    log.set(kLogFields[19], double(stats->st_region_nowait));
+    log.set(kLogFields[20], double(stats->st_regsize));
+    output_data.set(kFields[3], log.getMutable());
+    free(stats);
+  }
+  if (open_flags & DB_INIT_TXN) {
+    DB_TXN_STAT* stats;
+    code = environment->txn_stat(environment, &stats, flags);
+    if (code) {
+      output_data.destroy();
+      return code;
+    }
+    const char* kTxnFields[] = {
+        "last_ckp_file", "last_ckp_offset", "time_ckp", "last_txnid",
+        "maxtxns", "naborts", "nbegins", "ncommits", "nactive", "nsnapshot",
+        "maxnactive", "maxnsnapshot", "nrestores", "region_wait",
+        "region_nowait", "regsize"
+        };
+    MxArray txn = MxArray::Struct(16, kTxnFields);
+    txn.set(kTxnFields[0], double(stats->st_last_ckp.file));
+    txn.set(kTxnFields[1], double(stats->st_last_ckp.offset));
+    txn.set(kTxnFields[2], double(stats->st_time_ckp));
+    txn.set(kTxnFields[3], double(stats->st_last_txnid));
+    txn.set(kTxnFields[4], double(stats->st_maxtxns));
+    txn.set(kTxnFields[5], double(stats->st_naborts));
+    txn.set(kTxnFields[6], double(stats->st_nbegins));
+    txn.set(kTxnFields[7], double(stats->st_ncommits));
+    txn.set(kTxnFields[8], double(stats->st_nactive));
+    txn.set(kTxnFields[9], double(stats->st_nsnapshot));
+    txn.set(kTxnFields[10], double(stats->st_maxnactive));
+    txn.set(kTxnFields[11], double(stats->st_maxnsnapshot));
+    txn.set(kTxnFields[12], double(stats->st_nrestores));
+    txn.set(kTxnFields[13], double(stats->st_region_wait));
+    txn.set(kTxnFields[14], double(stats->st_region_nowait));
+    txn.set(kTxnFields[15], double(stats->st_regsize));
+    output_data.set(kFields[4], txn.getMutable());
+    free(stats);
+  }
+  *output = output_data.getMutable();
+  return 0;
+}
+
+void Environment::add_warm_pages(const string& filename,
+                                 const string& file_id,
+                                 uint32_t page_size,
+                                 db_pgno_t first,
+                                 db_pgno_t last) {
+  WarmFile& warm_file = warm_files_[filename];
+  if (warm_file.file_id != file_id || warm_file.page_size != page_size)
+    warm_file.pages.clear();
+  warm_file.file_id = file_id;
+  warm_file.page_size = page_size;
+  warm_file.pages.push_back(make_pair(first, last));
+}
+
+bool Environment::save_warm_list(const string& path) {
+  FILE* fp = fopen(path.c_str(), "w");
+  if (fp == NULL) {
+    code_ = errno;
+    return false;
+  }
+  for (map<string, WarmFile>::iterator it = warm_files_.begin();
+       it != warm_files_.end(); ++it) {
+    merge_pages(&it->second.pages);
+    for (size_t i = 0; i < it->second.pages.size(); ++i) {
+      for (size_t j = 0; j < it->second.file_id.size(); ++j)
+        fprintf(fp, "%02x", static_cast<uint8_t>(it->second.file_id[j]));
+      fprintf(fp, " %u %u %u %s\n",
+              it->second.page_size,
+              it->second.pages[i].first,
+              it->second.pages[i].second,
+              it->first.c_str());
+    }
+  }
+  code_ = (fclose(fp) == 0) ? 0 : errno;
+  return ok();
+}
+
+bool Environment::load_warm_list(const string& path, int* num_pages) {
+  *num_pages = 0;
+  FILE* fp = fopen(path.c_str(), "r");
+  if (fp == NULL)
+    return true;
+  char file_id_hex[2 * DB_FILE_ID_LEN + 1];
+  char filename[4096];
+  unsigned int page_size, first, last;
+  while (fscanf(fp, "%40s %u %u %u %4095[^\n]",
+                file_id_hex, &page_size, &first, &last, filename) == 5) {
+    string file_id(DB_FILE_ID_LEN, '\0');
+    for (int i = 0; i < DB_FILE_ID_LEN; ++i) {
+      unsigned int byte = 0;
+      sscanf(file_id_hex + 2 * i, "%2x", &byte);
+      file_id[i] = static_cast<char>(byte);
+    }
+    add_warm_pages(filename, file_id, page_size, first, last);
+  }
+  fclose(fp);
+  // Pages are read through a buffer pool file with the unique id of the
+  // database file, so that a database handle opened later shares them.
+  for (map<string, WarmFile>::iterator it = warm_files_.begin();
+       it != warm_files_.end(); ++it) {
+    WarmFile& warm_file = it->second;
+    merge_pages(&warm_file.pages);
+    DB_MPOOLFILE* mpf = NULL;
+    code_ = environment_->memp_fcreate(environment_, &mpf, 0);
+    if (!ok()) return false;
+    vector<uint8_t> file_id(warm_file.file_id.begin(),
+                            warm_file.file_id.end());
+    mpf->set_fileid(mpf, &file_id[0]);
+    mpf->set_lsn_offset(mpf, 0);
+    if (mpf->open(mpf, it->first.c_str(), DB_RDONLY, 0,
+                  warm_file.page_size) != 0) {
+      mpf->close(mpf, 0);
+      continue;
+    }
+    for (size_t i = 0; i < warm_file.pages.size(); ++i) {
+      for (db_pgno_t pgno = warm_file.pages[i].first;
+           pgno <= warm_file.pages[i].second; ++pgno) {
+        db_pgno_t page_number = pgno;
+        void* page = NULL;
+        if (mpf->get(mpf, &page_number, NULL, 0, &page) != 0)
+          break;
+        mpf->put(mpf, page, DB_PRIORITY_DEFAULT, 0);
+        ++(*num_pages);
+      }
+    }
+    mpf->close(mpf, 0);
+  }
+  code_ = 0;
+  return true;
+}
+
+void Environment::merge_pages(vector<pair<db_pgno_t, db_pgno_t> >* pages) {
+  if (pages->empty())
+    return;
+  std::sort(pages->begin(), pages->end());
+  vector<pair<db_pgno_t, db_pgno_t> > merged(1, pages->front());
+  for (size_t i = 1; i < pages->size(); ++i) {
+    if ((*pages)[i].first <= merged.back().second + 1)
+      merged.back().second = std::max(merged.back().second,
+                                      (*pages)[i].second);
+    else
+      merged.push_back((*pages)[i]);
+  }
+  pages->swap(merged);
+}
+
 bool Transaction::abort() {
   code_ = transaction_->abort(transaction_);
   return ok();
@@ -234,7 +1033,19 @@ bool Transaction::commit(uint32_t flags) {
   return ok();
 }
 
-Database::Database() : code_(0), database_(NULL) {}
+Database::Database() : code_(0),
+                       database_(NULL),
+                       type_(DB_UNKNOWN),
+                       environment_(NULL),
+                       prefetcher_(NULL),
+                       pool_(NULL),
+                       primary_(NULL),
+                       num_indexes_(0),
+                       native_values_(false),
+                       streams_(NULL),
+                       streams_checked_(false),
+                       value_log_(NULL),
+                       value_log_threshold_(0) {}
 
 Database::~Database() {
   close(0);
@@ -246,11 +1057,63 @@ bool Database::open(const string& filename,
                     uint32_t flags,
                     int mode,
                     Environment* environment,
-                    Transaction* transaction) {
+                    Transaction* transaction,
+                    const DatabaseConfig& config) {
+  error_detail_.clear();
+  environment_ = environment;
   code_ = db_create(&database_,
                     (environment == NULL) ? NULL : environment->get(),
                     0);
   if (!ok()) return false;
+  if (config.cache_size) {
+    code_ = database_->set_cachesize(
+        database_,
+        static_cast<u_int32_t>(config.cache_size / kGigaBytes),
+        static_cast<u_int32_t>(config.cache_size % kGigaBytes),
+        0);
+    if (!ok()) return false;
+  }
+  if (config.page_size) {
+    code_ = database_->set_pagesize(database_, config.page_size);
+    if (!ok()) return false;
+  }
+  if (config.hash_nelem) {
+    code_ = database_->set_h_nelem(database_, config.hash_nelem);
+    if (!ok()) return false;
+  }
+  if (config.hash_ffactor) {
+    code_ = database_->set_h_ffactor(database_, config.hash_ffactor);
+    if (!ok()) return false;
+  }
+  if (config.duplicates) {
+    code_ = database_->set_flags(database_, config.duplicates);
+    if (!ok()) return false;
+  }
+  if (config.record_length) {
+    code_ = database_->set_re_len(database_, config.record_length);
+    if (!ok()) return false;
+  }
+  if (config.record_pad >= 0) {
+    code_ = database_->set_re_pad(database_, config.record_pad);
+    if (!ok()) return false;
+  }
+  if (config.extent_size) {
+    code_ = database_->set_q_extentsize(database_, config.extent_size);
+    if (!ok()) return false;
+  }
+  if (config.heap_size) {
+#ifdef HAVE_DB_HEAP
+    code_ = database_->set_heapsize(
+        database_,
+        static_cast<u_int32_t>(config.heap_size / kGigaBytes),
+        static_cast<u_int32_t>(config.heap_size % kGigaBytes),
+        0);
+    if (!ok()) return false;
+#else
+    code_ = DB_OPNOTSUP;
+    return false;
+#endif
+  }
   code_ = database_->open(database_,
                           (transaction == NULL) ? NULL : transaction->get(),
                           (filename.empty()) ? NULL : filename.c_str(),
@@ -258,10 +1121,33 @@ bool Database::open(const string& filename,
                           type,
                           flags,
                           mode);
+  if (!ok()) return false;
+  code_ = database_->get_type(database_, &type_);
   return ok();
 }
 
 bool Database::close(uint32_t flags) {
+  error_detail_.clear();
+  if (streams_) {
+    streams_->close(flags);
+    delete streams_;
+    streams_ = NULL;
+  }
+  streams_checked_ = false;
+  if (value_log_) {
+    value_log_->sync();
+    delete value_log_;
+    value_log_ = NULL;
+  }
+  delete pool_;
+  pool_ = NULL;
+  delete prefetcher_;
+  prefetcher_ = NULL;
+  cache_.clear();
+  if (primary_) {
+    --primary_->num_indexes_;
+    primary_ = NULL;
+  }
   if (database_) {
     code_ = database_->close(database_, flags);
     database_ = NULL;
@@ -274,55 +1160,553 @@ int Database::error_code() const {
 }
 
 const char* Database::error_message() const {
-  return db_strerror(code_);
+  return (code_ == EINVAL && !error_detail_.empty()) ?
+      error_detail_.c_str() : db_strerror(code_);
 }
 
 bool Database::get(const mxArray* key,
                    uint32_t flags,
                    mxArray** value,
                    Transaction* transaction) {
+  error_detail_.clear();
   Record record = (*value != NULL) ? Record(key, *value) : Record(key);
+  if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
+  // Only plain reads outside of a transaction see committed values, and
+  // a pending asynchronous write may still change them.
+  bool use_cache = cache_.enabled() && *value == NULL && flags == 0 &&
+                   transaction == NULL && pending_writes_.value() == 0;
+  if (use_cache) {
+    *value = cache_.find(record.key_bytes());
+    if (*value != NULL) {
+      code_ = 0;
+      return true;
+    }
+  }
   code_ = database_->get(database_,
                          (transaction == NULL) ? NULL : transaction->get(),
                          record.key(),
                          record.value(),
                          flags);
-  if (code_ == 0)
+  if (code_ == 0) {
+    record.set_value_log(value_log_);
     record.get_value(value);
+    if (use_cache)
+      cache_.insert(record.key_bytes(), *value);
+  }
   else if (code_ == DB_NOTFOUND)
     *value = mxCreateDoubleMatrix(0, 0, mxREAL);
+  if (flags & (DB_CONSUME | DB_CONSUME_WAIT))
+    cache_.clear();
   return ok() || (code_ == DB_NOTFOUND);
 }
 
 bool Database::put(const mxArray* key,
                    const mxArray* value,
                    uint32_t flags,
-                   Transaction* transaction) {
-  Record record(key, value);
+                   Transaction* transaction,
+                   mxArray** new_key) {
+  error_detail_.clear();
+  return put_record(key, value, flags, transaction, new_key, string());
+}
+
+bool Database::put_manifest(const mxArray* key,
+                            const mxArray* value,
+                            const string& keep) {
+  error_detail_.clear();
+  return put_record(key, value, 0, NULL, NULL, keep);
+}
+
+bool Database::put_record(const mxArray* key,
+                          const mxArray* value,
+                          uint32_t flags,
+                          Transaction* transaction,
+                          mxArray** new_key,
+                          const string& keep) {
+  Record record(key, value, native_values_);
+  bool append = (flags & DB_APPEND) && Record::has_native_keys(type_);
+  if (append)
+    record.set_append_key(type_);
+  else if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
+  if (value_log_ && record.value()->size > value_log_threshold_) {
+    string bytes(static_cast<const char*>(record.value()->data),
+                 record.value()->size);
+    if (!log_value(record.key_bytes(), &bytes))
+      return false;
+    record.set_value_bytes(bytes);
+  }
+  invalidate(&record, flags);
   code_ = database_->put(database_,
                          (transaction == NULL) ? NULL : transaction->get(),
                          record.key(),
                          record.value(),
                          flags);
+  if (ok() && append && new_key)
+    record.get_key(new_key);
+  // Chunk records of a stream the value replaces are garbage now.
+  if (ok() && !Record::has_native_keys(type_)) {
+    DB* store = stream_store(false);
+    if (store)
+      code_ = Stream::remove_chunks(
+          store,
+          (transaction == NULL) ? NULL : transaction->get(),
+          Stream::chunk_prefix(record.key_bytes()),
+          keep);
+  }
   return ok();
 }
 
 bool Database::del(const mxArray* key,
                    uint32_t flags,
                    Transaction* transaction) {
+  error_detail_.clear();
   Record record(key);
+  if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
+  invalidate(&record, flags);
   code_ = database_->del(database_,
                          (transaction == NULL) ? NULL : transaction->get(),
                          record.key(),
                          flags);
+  if (ok() && !Record::has_native_keys(type_)) {
+    DB* store = stream_store(false);
+    if (store)
+      code_ = Stream::remove_chunks(
+          store,
+          (transaction == NULL) ? NULL : transaction->get(),
+          Stream::chunk_prefix(record.key_bytes()));
+  }
   return ok();
 }
 
+/// Read the native header of a stored value with a partial get.
+static int get_native_header(DB* database,
+                             DB_TXN* transaction,
+                             DBT* key,
+                             uint32_t flags,
+                             NativeHeader* header) {
+  char buffer[sizeof(NativeHeader)];
+  DBT value;
+  memset(&value, 0, sizeof(DBT));
+  value.data = buffer;
+  value.ulen = sizeof(buffer);
+  value.dlen = sizeof(buffer);
+  value.doff = 0;
+  value.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+  int code = database->get(database, transaction, key, &value, flags);
+  if (code != 0)
+    return code;
+  if (!Record::read_native_header(buffer, value.size, header))
+    return EINVAL;
+  return 0;
+}
+
+bool Database::read_logged_native(DB_TXN* transaction,
+                                  DBT* key,
+                                  uint32_t flags,
+                                  string* bytes,
+                                  NativeHeader* header) {
+  DBT value;
+  memset(&value, 0, sizeof(DBT));
+  value.flags = DB_DBT_REALLOC;
+  code_ = database_->get(database_, transaction, key, &value, flags);
+  if (ok())
+    bytes->assign(static_cast<const char*>(value.data), value.size);
+  if (value.data)
+    free(value.data);
+  if (!ok()) return false;
+  ValuePointer pointer;
+  bool logged = ValueLog::read_pointer(bytes->data(), bytes->size(), &pointer);
+  if (logged && !resolve_value(bytes))
+    return false;
+  if (!logged || !Record::read_native_header(bytes->data(),
+                                             bytes->size(),
+                                             header) ||
+      bytes->size() != sizeof(NativeHeader) + header->rows * header->columns *
+          Record::native_element_size(
+              static_cast<mxClassID>(header->class_id))) {
+    code_ = EINVAL;
+    return false;
+  }
+  return true;
+}
+
+bool Database::get_range(const mxArray* key,
+                         uint64_t offset,
+                         uint64_t count,
+                         Transaction* transaction,
+                         mxArray** value) {
+  error_detail_.clear();
+  Record record(key);
+  if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
+  DB_TXN* txn = (transaction == NULL) ? NULL : transaction->get();
+  NativeHeader header;
+  // A logged value is read whole, as only the pointer is in the database.
+  string logged;
+  code_ = get_native_header(database_, txn, record.key(), 0, &header);
+  if (code_ == EINVAL && value_log_)
+    read_logged_native(txn, record.key(), 0, &logged, &header);
+  if (!ok()) return false;
+  uint64_t num_elements = header.rows * header.columns;
+  offset = min(offset, num_elements);
+  count = min(count, num_elements - offset);
+  size_t element_size = Record::native_element_size(
+      static_cast<mxClassID>(header.class_id));
+  NativeHeader output_header = header;
+  output_header.rows = count;
+  output_header.columns = 1;
+  *value = Record::create_native_array(output_header);
+  if (count == 0)
+    return true;
+  if (!logged.empty()) {
+    memcpy(mxGetData(*value),
+           &logged[sizeof(NativeHeader) + offset * element_size],
+           count * element_size);
+    return true;
+  }
+  DBT data;
+  memset(&data, 0, sizeof(DBT));
+  data.data = mxGetData(*value);
+  data.ulen = count * element_size;
+  data.dlen = count * element_size;
+  data.doff = sizeof(NativeHeader) + offset * element_size;
+  data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+  code_ = database_->get(database_, txn, record.key(), &data, 0);
+  if (ok() && data.size != count * element_size)
+    code_ = EINVAL;
+  if (!ok()) {
+    mxDestroyArray(*value);
+    *value = NULL;
+    return false;
+  }
+  return true;
+}
+
+bool Database::put_at(const mxArray* key,
+                      const mxArray* elements,
+                      uint64_t offset,
+                      Transaction* transaction) {
+  error_detail_.clear();
+  string encoded;
+  if (!Record::encode_native(elements, &encoded))
+    ERROR("Elements must be a real numeric, logical or char array.");
+  NativeHeader elements_header;
+  Record::read_native_header(encoded.data(), encoded.size(), &elements_header);
+  uint64_t num_elements = elements_header.rows * elements_header.columns;
+  Record record(key);
+  if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
+  invalidate(&record, 0);
+  DB_TXN* parent = (transaction == NULL) ? NULL : transaction->get();
+  DB_TXN* batch = NULL;
+  if (parent == NULL && database_->get_transactional(database_)) {
+    DB_ENV* environment = database_->get_env(database_);
+    code_ = environment->txn_begin(environment, NULL, &batch, 0);
+    if (!ok()) return false;
+  }
+  DB_TXN* txn = (batch) ? batch : parent;
+  NativeHeader header;
+  // A logged value is rewritten whole through the log.
+  string logged;
+  code_ = get_native_header(database_,
+                            txn,
+                            record.key(),
+                            (txn) ? DB_RMW : 0,
+                            &header);
+  if (code_ == EINVAL && value_log_)
+    read_logged_native(txn, record.key(), (txn) ? DB_RMW : 0, &logged,
+                       &header);
+  if (ok() && (header.class_id != elements_header.class_id ||
+               offset + num_elements > header.rows * header.columns))
+    code_ = EINVAL;
+  size_t element_size = (ok()) ? Record::native_element_size(
+      static_cast<mxClassID>(header.class_id)) : 0;
+  if (ok() && num_elements > 0 && !logged.empty()) {
+    memcpy(&logged[sizeof(NativeHeader) + offset * element_size],
+           &encoded[sizeof(NativeHeader)],
+           num_elements * element_size);
+    if (log_value(record.key_bytes(), &logged)) {
+      DBT data;
+      memset(&data, 0, sizeof(DBT));
+      data.data = const_cast<char*>(logged.data());
+      data.size = logged.size();
+      code_ = database_->put(database_, txn, record.key(), &data, 0);
+    }
+  }
+  else if (ok() && num_elements > 0) {
+    DBT data;
+    memset(&data, 0, sizeof(DBT));
+    data.data = &encoded[sizeof(NativeHeader)];
+    data.size = num_elements * element_size;
+    data.dlen = num_elements * element_size;
+    data.doff = sizeof(NativeHeader) + offset * element_size;
+    data.flags = DB_DBT_PARTIAL;
+    code_ = database_->put(database_, txn, record.key(), &data, 0);
+  }
+  if (batch) {
+    if (ok())
+      code_ = batch->commit(batch, 0);
+    else
+      batch->abort(batch);
+  }
+  return ok();
+}
+
+DB* Database::stream_store(bool create) {
+  if (streams_)
+    return streams_->handle();
+  if (!create && streams_checked_)
+    return NULL;
+  streams_checked_ = true;
+  uint32_t open_flags = 0;
+  code_ = database_->get_open_flags(database_, &open_flags);
+  if (!ok()) return NULL;
+  const char* filename = NULL;
+  const char* name = NULL;
+  code_ = database_->get_dbname(database_, &filename, &name);
+  if (!ok()) return NULL;
+  string store_filename;
+  if (filename)
+    store_filename = string(filename) + "." +
+        ((name) ? string(name) + "." : string("")) + "stream";
+  else if (!create)
+    return NULL;
+  bool transactional = database_->get_transactional(database_);
+  uint32_t flags =
+      (open_flags & (DB_THREAD | DB_RDONLY | DB_MULTIVERSION |
+                     DB_READ_UNCOMMITTED)) |
+      ((create && !(open_flags & DB_RDONLY)) ? DB_CREATE : 0) |
+      (transactional ? DB_AUTO_COMMIT : 0);
+  Database* streams = new Database();
+  if (!streams->open(store_filename,
+                     "",
+                     DB_BTREE,
+                     flags,
+                     0,
+                     environment_,
+                     NULL,
+                     DatabaseConfig())) {
+    code_ = (streams->error_code() == ENOENT && !create) ?
+        0 : streams->error_code();
+    delete streams;
+    return NULL;
+  }
+  streams_ = streams;
+  return streams_->handle();
+}
+
+bool Database::set_value_log(size_t threshold, uint64_t segment_size) {
+  error_detail_.clear();
+  if (threshold == 0)
+    return true;
+  uint32_t flags = 0;
+  code_ = database_->get_flags(database_, &flags);
+  if (!ok()) return false;
+  if ((type_ != DB_BTREE && type_ != DB_HASH) ||
+      (flags & (DB_DUP | DB_DUPSORT))) {
+    code_ = EINVAL;
+    return false;
+  }
+  uint32_t open_flags = 0;
+  code_ = database_->get_open_flags(database_, &open_flags);
+  if (!ok()) return false;
+  const char* filename = NULL;
+  const char* name = NULL;
+  code_ = database_->get_dbname(database_, &filename, &name);
+  if (!ok()) return false;
+  if (filename == NULL) {
+    code_ = EINVAL;
+    return false;
+  }
+  // Database files of an environment are relative to its home.
+  string path(filename);
+  DB_ENV* environment = database_->get_env(database_);
+  const char* home = NULL;
+  if (environment_ && path[0] != '/' &&
+      environment->get_home(environment, &home) == 0 && home)
+    path = string(home) + "/" + path;
+  path += "." + ((name) ? string(name) + "." : string("")) + "vlog";
+  ValueLog* value_log = new ValueLog();
+  if (!value_log->open(path, segment_size, (open_flags & DB_RDONLY) != 0)) {
+    code_ = value_log->error_code();
+    if (code_ == EAGAIN) {
+      code_ = EINVAL;
+      error_detail_ = value_log->error_message();
+    }
+    delete value_log;
+    return false;
+  }
+  value_log_ = value_log;
+  value_log_threshold_ = threshold;
+  return true;
+}
+
+/// Check that the stored value of the key is the pointer. Any other value,
+/// including a larger one, gives DB_NOTFOUND.
+static int check_pointer(DB* database,
+                         DB_TXN* transaction,
+                         const string& key_bytes,
+                         uint32_t flags,
+                         const ValuePointer& pointer) {
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.data = const_cast<char*>(key_bytes.data());
+  key.size = key_bytes.size();
+  ValuePointer stored;
+  value.data = &stored;
+  value.ulen = sizeof(ValuePointer);
+  value.flags = DB_DBT_USERMEM;
+  int code = database->get(database, transaction, &key, &value, flags);
+  if (code == DB_BUFFER_SMALL)
+    return DB_NOTFOUND;
+  if (code != 0)
+    return code;
+  ValuePointer current;
+  if (!ValueLog::read_pointer(&stored, value.size, &current) ||
+      current.segment != pointer.segment ||
+      current.offset != pointer.offset)
+    return DB_NOTFOUND;
+  return 0;
+}
+
+bool Database::collect_value_log(double min_garbage,
+                                 int* num_segments,
+                                 uint64_t* reclaimed) {
+  error_detail_.clear();
+  *num_segments = 0;
+  *reclaimed = 0;
+  if (value_log_ == NULL) {
+    code_ = EINVAL;
+    return false;
+  }
+  DB_ENV* environment = database_->get_env(database_);
+  bool transactional = database_->get_transactional(database_);
+  vector<uint32_t> segments;
+  value_log_->segments(&segments);
+  uint32_t head = value_log_->head();
+  for (size_t i = 0; i < segments.size(); ++i) {
+    if (segments[i] == head)
+      continue;
+    vector<ValueLog::Entry> entries;
+    if (!value_log_->scan(segments[i], &entries)) {
+      code_ = value_log_->error_code();
+      return false;
+    }
+    uint64_t size = value_log_->segment_size(segments[i]);
+    vector<size_t> live;
+    uint64_t live_bytes = 0;
+    for (size_t j = 0; j < entries.size(); ++j) {
+      code_ = check_pointer(database_,
+                            NULL,
+                            entries[j].key,
+                            0,
+                            entries[j].pointer);
+      if (code_ == DB_NOTFOUND)
+        continue;
+      if (!ok()) return false;
+      live.push_back(j);
+      live_bytes += entries[j].key.size() + entries[j].pointer.length;
+    }
+    if (size > live_bytes &&
+        static_cast<double>(size - live_bytes) < min_garbage * size)
+      continue;
+    // Move live values to the head, unless overwritten in the meantime.
+    for (size_t j = 0; j < live.size(); ++j) {
+      const ValueLog::Entry& entry = entries[live[j]];
+      DB_TXN* transaction = NULL;
+      if (transactional) {
+        code_ = environment->txn_begin(environment, NULL, &transaction, 0);
+        if (!ok()) return false;
+      }
+      code_ = check_pointer(database_,
+                            transaction,
+                            entry.key,
+                            (transaction) ? DB_RMW : 0,
+                            entry.pointer);
+      string bytes;
+      ValuePointer pointer;
+      if (ok() && !value_log_->read(entry.pointer, &bytes))
+        code_ = value_log_->error_code();
+      if (ok() && !value_log_->append(entry.key,
+                                      bytes.data(),
+                                      bytes.size(),
+                                      &pointer))
+        code_ = value_log_->error_code();
+      if (ok()) {
+        string pointer_bytes = ValueLog::encode_pointer(pointer);
+        DBT key, value;
+        memset(&key, 0, sizeof(DBT));
+        memset(&value, 0, sizeof(DBT));
+        key.data = const_cast<char*>(entry.key.data());
+        key.size = entry.key.size();
+        value.data = const_cast<char*>(pointer_bytes.data());
+        value.size = pointer_bytes.size();
+        code_ = database_->put(database_, transaction, &key, &value, 0);
+      }
+      if (transaction) {
+        if (ok())
+          code_ = transaction->commit(transaction, 0);
+        else
+          transaction->abort(transaction);
+      }
+      if (code_ == DB_NOTFOUND)
+        code_ = 0;
+      if (!ok()) return false;
+    }
+    // Moved values must be durable before the old copies are gone.
+    if (!value_log_->sync() || !value_log_->remove(segments[i])) {
+      code_ = value_log_->error_code();
+      return false;
+    }
+    ++*num_segments;
+    *reclaimed += size - min(size, live_bytes);
+  }
+  return true;
+}
+
+bool Database::log_value(const string& key_bytes,
+                         string* bytes,
+                         bool sync) {
+  if (value_log_ == NULL || bytes->size() <= value_log_threshold_)
+    return true;
+  ValuePointer pointer;
+  if (!value_log_->append(key_bytes, bytes->data(), bytes->size(), &pointer) ||
+      (sync && !value_log_->sync())) {
+    code_ = value_log_->error_code();
+    return false;
+  }
+  *bytes = ValueLog::encode_pointer(pointer);
+  return true;
+}
+
+bool Database::resolve_value(string* bytes) {
+  ValuePointer pointer;
+  if (!ValueLog::read_pointer(bytes->data(), bytes->size(), &pointer))
+    return true;
+  string value;
+  if (value_log_ == NULL) {
+    code_ = EINVAL;
+    return false;
+  }
+  if (!value_log_->read(pointer, &value)) {
+    code_ = value_log_->error_code();
+    return false;
+  }
+  bytes->swap(value);
+  return true;
+}
+
 bool Database::exists(const mxArray* key,
                       uint32_t flags,
                       mxArray** value,
                       Transaction* transaction) {
+  error_detail_.clear();
   Record record(key);
+  if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
   code_ = database_->exists(database_,
                             (transaction == NULL) ? NULL : transaction->get(),
                             record.key(),
@@ -331,9 +1715,103 @@ bool Database::exists(const mxArray* key,
   return ok() || code_ == DB_NOTFOUND;
 }
 
+bool Database::get_all(const mxArray* key,
+                       Transaction* transaction,
+                       mxArray** values) {
+  error_detail_.clear();
+  Record record(key);
+  if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
+  // The same key is returned while moving over duplicates.
+  record.key()->ulen = record.key()->size;
+  DBC* cursor = NULL;
+  code_ = database_->cursor(database_,
+                            (transaction == NULL) ? NULL : transaction->get(),
+                            &cursor,
+                            0);
+  if (!ok()) return false;
+  vector<string> encoded;
+  vector<uint8_t> buffer(kBulkBufferSize);
+  DBT value;
+  memset(&value, 0, sizeof(DBT));
+  value.flags = DB_DBT_USERMEM;
+  // Only btree and hash have duplicates. A bulk read elsewhere would return
+  // the records following the key.
+  bool bulk = (type_ == DB_BTREE || type_ == DB_HASH);
+  uint32_t flags = DB_SET | ((bulk) ? DB_MULTIPLE : 0);
+  while (true) {
+    value.data = &buffer[0];
+    value.ulen = buffer.size();
+    code_ = cursor->get(cursor, record.key(), &value, flags);
+    if (code_ == DB_BUFFER_SMALL && value.size > value.ulen) {
+      buffer.resize(max<size_t>(buffer.size() * 2, value.size));
+      continue;
+    }
+    if (!ok()) break;
+    if (!bulk) {
+      encoded.push_back(string(reinterpret_cast<const char*>(&buffer[0]),
+                               value.size));
+      break;
+    }
+    void* pointer = NULL;
+    DB_MULTIPLE_INIT(pointer, &value);
+    while (true) {
+      void* value_data = NULL;
+      uint32_t value_size = 0;
+      DB_MULTIPLE_NEXT(pointer, &value, value_data, value_size);
+      if (pointer == NULL)
+        break;
+      encoded.push_back(string(static_cast<const char*>(value_data),
+                               value_size));
+    }
+    flags = DB_NEXT_DUP | DB_MULTIPLE;
+  }
+  cursor->close(cursor);
+  if (!ok() && code_ != DB_NOTFOUND)
+    return false;
+  code_ = 0;
+  *values = mxCreateCellMatrix(encoded.size(), 1);
+  for (size_t i = 0; i < encoded.size(); ++i) {
+    Record element_record;
+    element_record.assign(string(), encoded[i]);
+    element_record.set_value_log(value_log_);
+    mxArray* element = NULL;
+    element_record.get_value(&element);
+    mxSetCell(*values, i, element);
+  }
+  return true;
+}
+
+bool Database::count(const mxArray* key,
+                     Transaction* transaction,
+                     int* count) {
+  error_detail_.clear();
+  Record record(key);
+  if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
+  DBC* cursor = NULL;
+  code_ = database_->cursor(database_,
+                            (transaction == NULL) ? NULL : transaction->get(),
+                            &cursor,
+                            0);
+  if (!ok()) return false;
+  // Position on the key without reading the value.
+  DBT value;
+  memset(&value, 0, sizeof(DBT));
+  value.flags = DB_DBT_PARTIAL | DB_DBT_USERMEM;
+  db_recno_t num_values = 0;
+  code_ = cursor->get(cursor, record.key(), &value, DB_SET);
+  if (ok())
+    code_ = cursor->count(cursor, &num_values, 0);
+  cursor->close(cursor);
+  *count = (ok()) ? static_cast<int>(num_values) : 0;
+  return ok() || code_ == DB_NOTFOUND;
+}
+
 bool Database::stat(uint32_t flags,
                     mxArray** output,
                     Transaction* transaction) {
+  error_detail_.clear();
   DBTYPE type;
   code_ = database_->get_type(database_, &type);
   if (!ok()) return false;
@@ -376,30 +1854,33 @@ bool Database::stat(uint32_t flags,
       free(stats);
       break;
     }
-    // case DB_HEAP: {
-    //   DB_HEAP_STAT* stats;
-    //   code_ = database_->stat(database_,
-    //                           (transaction == NULL) ? NULL : transaction->get(),
-    //                           &stats,
-    //                           flags);
-    //   if (output != NULL) {
-    //     const char* kFields[] = {
-    //         "magic", "version", "nrecs", "pagecnt", "pagesize", "nregions",
-    //         "regionsize"
-    //         };
-    //     MxArray output_data = MxArray::Struct(7, kFields);
-    //     output_data.set(kFields[0], double(stats->heap_magic));
-    //     output_data.set(kFields[1], double(stats->heap_version));
-    //     output_data.set(kFields[2], double(stats->heap_nrecs));
-    //     output_data.set(kFields[3], double(stats->heap_pagecnt));
-    //     output_data.set(kFields[4], double(stats->heap_pagesize));
-    //     output_data.set(kFields[5], double(stats->heap_nregions));
-    //     output_data.set(kFields[6], double(stats->heap_regionsize));
-    //     *output = output_data.getMutable();
-    //   }
-    //   free(stats);
-    //   break;
-    // }
+#ifdef HAVE_DB_HEAP
+    case DB_HEAP: {
+      DB_HEAP_STAT* stats;
+      code_ = database_->stat(database_,
+                              (transaction == NULL) ? NULL : transaction->get(),
+                              &stats,
+                              flags);
+      if (!ok()) return false;
+      if (output != NULL) {
+        const char* kFields[] = {
+            "magic", "version", "nrecs", "pagecnt", "pagesize", "nregions",
+            "regionsize"
+            };
+        MxArray output_data = MxArray::Struct(7, kFields);
+        output_data.set(kFields[0], double(stats->heap_magic));
+        output_data.set(kFields[1], double(stats->heap_version));
+        output_data.set(kFields[2], double(stats->heap_nrecs));
+        output_data.set(kFields[3], double(stats->heap_pagecnt));
+        output_data.set(kFields[4], double(stats->heap_pagesize));
+        output_data.set(kFields[5], double(stats->heap_nregions));
+        output_data.set(kFields[6], double(stats->heap_regionsize));
+        *output = output_data.getMutable();
+      }
+      free(stats);
+      break;
+    }
+#endif
     case DB_BTREE:
     case DB_RECNO: {
       DB_BTREE_STAT* stats;
@@ -480,64 +1961,65 @@ bool Database::stat(uint32_t flags,
       ERROR("Fatal error. Unknown db_type.");
     }
   }
+  if (output != NULL && ok() && cache_.enabled()) {
+    MxArray output_data(*output);
+    output_data.set("value_cache_capacity", double(cache_.capacity()));
+    output_data.set("value_cache_bytes", double(cache_.size()));
+    output_data.set("value_cache_hits", double(cache_.hits()));
+    output_data.set("value_cache_misses", double(cache_.misses()));
+    output_data.set("value_cache_evictions", double(cache_.evictions()));
+  }
   return ok();
 }
 
 bool Database::keys(mxArray** output) {
-  // Count the number of keys.
-  DB_BTREE_STAT* stats = NULL;
-  stats = static_cast<DB_BTREE_STAT*>(malloc(sizeof(DB_BTREE_STAT)));
-  if (stats == NULL)
-    return false;
-  code_ = database_->stat(database_, NULL, &stats, 0);
-  uint32_t num_keys = stats->bt_nkeys;
-  free(stats);
+  error_detail_.clear();
+  // Statistics differ between access methods, so collect until the end.
+  // Values, including overflow pages, are never read.
+  Cursor cursor;
+  code_ = cursor.open(database_, 0, true);
   if (code_)
     return false;
-  // Retrieve records.
-  Cursor cursor;
-  code_ = cursor.open(database_);
+  uint32_t flags = 0;
+  code_ = database_->get_flags(database_, &flags);
   if (code_)
     return false;
-  *output = mxCreateCellMatrix(num_keys, 1);
-  int index = 0;
-  while (index < num_keys && 0 == (code_ = cursor.next())) {
+  bool duplicates = (flags & (DB_DUP | DB_DUPSORT)) != 0;
+  vector<mxArray*> keys;
+  while (0 == (code_ = (duplicates) ? cursor.next_nodup() : cursor.next())) {
     mxArray* key_array;
     cursor.get()->get_key(&key_array);
-    mxSetCell(*output, index++, key_array);
+    keys.push_back(key_array);
   }
+  *output = mxCreateCellMatrix(keys.size(), 1);
+  for (size_t i = 0; i < keys.size(); ++i)
+    mxSetCell(*output, i, keys[i]);
   return ok() || (code_ == DB_NOTFOUND);
 }
 
 bool Database::values(mxArray** output) {
-  // Count the number of values.
-  DB_BTREE_STAT* stats = NULL;
-  stats = static_cast<DB_BTREE_STAT*>(malloc(sizeof(DB_BTREE_STAT)));
-  if (stats == NULL)
-    return false;
-  code_ = database_->stat(database_, NULL, &stats, 0);
-  uint32_t num_values = stats->bt_ndata;
-  free(stats);
-  if (code_)
-    return false;
-  // Retrieve records.
+  error_detail_.clear();
   Cursor cursor;
   code_ = cursor.open(database_);
   if (code_)
     return false;
-  *output = mxCreateCellMatrix(num_values, 1);
-  int index = 0;
-  while (index < num_values && 0 == (code_ = cursor.next())) {
+  cursor.get()->set_value_log(value_log_);
+  vector<mxArray*> values;
+  while (0 == (code_ = cursor.next())) {
     mxArray* value_array;
     cursor.get()->get_value(&value_array);
-    mxSetCell(*output, index++, value_array);
+    values.push_back(value_array);
   }
+  *output = mxCreateCellMatrix(values.size(), 1);
+  for (size_t i = 0; i < values.size(); ++i)
+    mxSetCell(*output, i, values[i]);
   return ok() || (code_ == DB_NOTFOUND);
 }
 
 bool Database::compact(uint32_t flags,
                        DB_COMPACT* compact_data,
                        Transaction* transaction) {
+  error_detail_.clear();
   code_ = database_->compact(database_,
                              (transaction == NULL) ? NULL : transaction->get(),
                              NULL,
@@ -548,12 +2030,1489 @@ bool Database::compact(uint32_t flags,
   return ok();
 }
 
-bool Database::cursor(Cursor* cursor) {
+bool Database::cursor(Cursor* cursor, int prefetch, bool keys_only) {
+  error_detail_.clear();
   if (cursor == NULL)
     ERROR("Null pointer exception.");
-  code_ = cursor->open(database_);
+  code_ = cursor->open(database_, prefetch, keys_only);
+  cursor->get()->set_value_log(value_log_);
+  return ok();
+}
+
+bool Database::env_stat(uint32_t flags, mxArray** output) {
+  error_detail_.clear();
+  code_ = Environment::stat(database_->get_env(database_), flags, output);
+  return ok();
+}
+
+bool Database::advise(int samples, double working_set, mxArray** output) {
+  error_detail_.clear();
+  DBTYPE type;
+  code_ = database_->get_type(database_, &type);
+  if (!ok()) return false;
+  uint32_t page_size = 0;
+  code_ = database_->get_pagesize(database_, &page_size);
+  if (!ok()) return false;
+  // Fast statistics give the key count and the page count without traversal.
+  double num_keys = 0, num_pages = 0;
+  if (type == DB_HASH) {
+    DB_HASH_STAT* stats;
+    code_ = database_->stat(database_, NULL, &stats, DB_FAST_STAT);
+    if (!ok()) return false;
+    num_keys = stats->hash_ndata;
+    num_pages = stats->hash_pagecnt;
+    free(stats);
+  }
+  else if (type == DB_QUEUE) {
+    DB_QUEUE_STAT* stats;
+    code_ = database_->stat(database_, NULL, &stats, DB_FAST_STAT);
+    if (!ok()) return false;
+    num_keys = stats->qs_ndata;
+    free(stats);
+  }
+#ifdef HAVE_DB_HEAP
+  else if (type == DB_HEAP) {
+    DB_HEAP_STAT* stats;
+    code_ = database_->stat(database_, NULL, &stats, DB_FAST_STAT);
+    if (!ok()) return false;
+    num_keys = stats->heap_nrecs;
+    num_pages = stats->heap_pagecnt;
+    free(stats);
+  }
+#endif
+  else if (type == DB_BTREE || type == DB_RECNO) {
+    DB_BTREE_STAT* stats;
+    code_ = database_->stat(database_, NULL, &stats, DB_FAST_STAT);
+    if (!ok()) return false;
+    num_keys = stats->bt_ndata;
+    num_pages = stats->bt_pagecnt;
+    free(stats);
+  }
+  else {
+    code_ = EINVAL;
+    return false;
+  }
+  // Sample record sizes from the head of the database. The cursor moves
+  // without reading values, then an empty user buffer on the current record
+  // reports the value size without copying the value or its overflow pages.
+  DBC* cursor = NULL;
+  code_ = database_->cursor(database_, NULL, &cursor, 0);
+  if (!ok()) return false;
+  DBT key, value, current_key;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  memset(&current_key, 0, sizeof(DBT));
+  key.flags = DB_DBT_REALLOC;
+  current_key.flags = DB_DBT_PARTIAL | DB_DBT_USERMEM;
+  vector<double> item_sizes;
+  double key_bytes = 0, value_bytes = 0, value_max = 0;
+  while (static_cast<int>(item_sizes.size()) < samples) {
+    value.flags = DB_DBT_PARTIAL | DB_DBT_USERMEM;
+    value.dlen = 0;
+    value.ulen = 0;
+    code_ = cursor->get(cursor, &key, &value, DB_NEXT);
+    if (!ok()) break;
+    value.flags = DB_DBT_USERMEM;
+    value.ulen = 0;
+    code_ = cursor->get(cursor, &current_key, &value, DB_CURRENT);
+    if (code_ != 0 && code_ != DB_BUFFER_SMALL) break;
+    code_ = 0;
+    double key_size = key.size;
+    double value_size = value.size;
+    key_bytes += key_size;
+    value_bytes += value_size;
+    value_max = std::max(value_max, value_size);
+    item_sizes.push_back(std::max(key_size, value_size));
+  }
+  cursor->close(cursor);
+  if (key.data)
+    free(key.data);
+  if (code_ != 0 && code_ != DB_NOTFOUND)
+    return false;
+  bool exhausted = (code_ == DB_NOTFOUND);
+  code_ = 0;
+  int num_samples = item_sizes.size();
+  double key_mean = (num_samples) ? key_bytes / num_samples : 0;
+  double value_mean = (num_samples) ? value_bytes / num_samples : 0;
+  double record_bytes = key_mean + value_mean + 2 * kItemOverhead;
+  if (exhausted)
+    num_keys = num_samples;
+  else if (num_keys < num_samples && record_bytes > 0)
+    num_keys = num_pages * page_size * 0.7 / record_bytes;
+  std::sort(item_sizes.begin(), item_sizes.end());
+  double item_p95 = (num_samples) ?
+      item_sizes[static_cast<int>(0.95 * (num_samples - 1))] : 0;
+  // Fraction of sampled items that spill to overflow pages.
+  int overflows = item_sizes.end() - std::upper_bound(
+      item_sizes.begin(), item_sizes.end(), double(overflow_size(page_size)));
+  // Smallest page size that keeps 95% of the items on leaf pages.
+  uint32_t recommended_page_size = 4096;
+  while (recommended_page_size < 65536 &&
+         item_p95 > overflow_size(recommended_page_size))
+    recommended_page_size *= 2;
+  int recommended_overflows = item_sizes.end() - std::upper_bound(
+      item_sizes.begin(),
+      item_sizes.end(),
+      double(overflow_size(recommended_page_size)));
+  // Leaf pages are about 70% full after random inserts, and interior pages
+  // add roughly one entry per leaf page.
+  double leaf_bytes = num_keys * record_bytes / 0.7;
+  double interior_bytes = leaf_bytes / recommended_page_size *
+      (key_mean + 2 * kItemOverhead) / 0.7;
+  double cache_bytes = 1.25 * (interior_bytes + working_set * leaf_bytes);
+  double ffactor = std::floor((recommended_page_size - kPageOverhead) /
+                              std::max(record_bytes, 1.0));
+  const char* kFields[] = {
+      "pagesize", "samples", "nkeys", "key_mean", "value_mean", "value_max",
+      "item_p95", "overflow_fraction", "recommended_pagesize",
+      "recommended_overflow_fraction", "estimated_bytes",
+      "recommended_cachesize", "recommended_h_ffactor",
+      "recommended_h_nelem"
+      };
+  MxArray output_data = MxArray::Struct(14, kFields);
+  output_data.set(kFields[0], double(page_size));
+  output_data.set(kFields[1], double(num_samples));
+  output_data.set(kFields[2], std::floor(num_keys));
+  output_data.set(kFields[3], key_mean);
+  output_data.set(kFields[4], value_mean);
+  output_data.set(kFields[5], value_max);
+  output_data.set(kFields[6], item_p95);
+  output_data.set(kFields[7], (num_samples) ?
+      double(overflows) / num_samples : 0.0);
+  output_data.set(kFields[8], double(recommended_page_size));
+  output_data.set(kFields[9], (num_samples) ?
+      double(recommended_overflows) / num_samples : 0.0);
+  output_data.set(kFields[10], std::ceil(leaf_bytes + interior_bytes));
+  output_data.set(kFields[11], std::ceil(std::max(cache_bytes, 262144.0)));
+  output_data.set(kFields[12], std::max(ffactor, 1.0));
+  output_data.set(kFields[13], std::ceil(num_keys));
+  *output = output_data.getMutable();
+  return true;
+}
+
+bool Database::warm(bool full, int max_pages, int* num_pages) {
+  error_detail_.clear();
+  // Pages are parsed as btree or recno pages.
+  if (type_ != DB_BTREE && type_ != DB_RECNO) {
+    code_ = EINVAL;
+    return false;
+  }
+#ifdef HAVE_PAGE_LAYOUT
+  // The layout is only known for the library the driver is built with, and
+  // an encrypted page has an initialization vector in its header.
+  int major = 0, minor = 0, patch = 0;
+  db_version(&major, &minor, &patch);
+  uint32_t database_flags = 0;
+  code_ = database_->get_flags(database_, &database_flags);
+  if (!ok()) return false;
+  if (major != DB_VERSION_MAJOR || minor != DB_VERSION_MINOR ||
+      (database_flags & DB_ENCRYPT)) {
+    code_ = DB_OPNOTSUP;
+    return false;
+  }
+#else
+  code_ = DB_OPNOTSUP;
+  return false;
+#endif
+  DB_MPOOLFILE* mpf = database_->get_mpf(database_);
+  db_pgno_t last_pgno = 0;
+  code_ = mpf->get_last_pgno(mpf, &last_pgno);
+  if (!ok()) return false;
+  vector<pair<db_pgno_t, db_pgno_t> > kept_pages;
+  *num_pages = 0;
+  if (full) {
+    // Read every page in file order so that the disk sees one sequential
+    // pass.
+    for (db_pgno_t pgno = 0; pgno <= last_pgno; ++pgno) {
+      if (max_pages > 0 && *num_pages >= max_pages)
+        break;
+      db_pgno_t page_number = pgno;
+      void* page = NULL;
+      code_ = mpf->get(mpf, &page_number, NULL, 0, &page);
+      if (!ok()) return false;
+      uint8_t page_type = static_cast<uint8_t*>(page)[kPageTypeOffset];
+      bool interior = (page_type == kInternalBtreePage ||
+                       page_type == kInternalRecnoPage);
+      code_ = mpf->put(mpf,
+                       page,
+                       (interior) ? DB_PRIORITY_VERY_HIGH :
+                                    DB_PRIORITY_DEFAULT,
+                       0);
+      if (!ok()) return false;
+      ++(*num_pages);
+      if (!kept_pages.empty() && kept_pages.back().second + 1 == pgno)
+        kept_pages.back().second = pgno;
+      else
+        kept_pages.push_back(make_pair(pgno, pgno));
+    }
+  }
+  else {
+    // Descend from the meta page one level at a time, reading the pages of
+    // a level in file order. Children of the lowest interior level are
+    // leaves and are never read.
+    db_pgno_t meta_pgno = 0;
+    if (!find_meta_page(&meta_pgno)) return false;
+    uint32_t page_size = 0;
+    code_ = database_->get_pagesize(database_, &page_size);
+    if (!ok()) return false;
+    size_t header_size = kPageHeaderSize +
+        ((database_flags & DB_CHKSUM) ? kPageChecksumSize : 0);
+    vector<db_pgno_t> level(1, meta_pgno), children;
+    bool meta = true;
+    while (!level.empty() && (max_pages <= 0 || *num_pages < max_pages)) {
+      std::sort(level.begin(), level.end());
+      children.clear();
+      for (size_t i = 0; i < level.size(); ++i) {
+        if (max_pages > 0 && *num_pages >= max_pages)
+          break;
+        db_pgno_t page_number = level[i];
+        void* page = NULL;
+        code_ = mpf->get(mpf, &page_number, NULL, 0, &page);
+        if (!ok()) return false;
+        const uint8_t* data = static_cast<const uint8_t*>(page);
+        uint8_t page_type = data[kPageTypeOffset];
+        if (meta) {
+          uint32_t magic = 0;
+          memcpy(&magic, data + kMetaMagicOffset, sizeof(uint32_t));
+          db_pgno_t root = 0;
+          memcpy(&root, data + kMetaRootOffset, sizeof(db_pgno_t));
+          if (page_type == kBtreeMetaPage && magic == kBtreeMagic &&
+              root > 0 && root <= last_pgno)
+            children.push_back(root);
+          else
+            code_ = EINVAL;
+        }
+        else if ((page_type == kInternalBtreePage ||
+                  page_type == kInternalRecnoPage) &&
+                 data[kPageLevelOffset] > kLeafLevel + 1) {
+          // Internal items start with the child page number in a recno tree
+          // and after a 2-byte length and 2 type bytes in a btree.
+          size_t child_offset = (page_type == kInternalBtreePage) ? 4 : 0;
+          uint16_t entries = 0;
+          memcpy(&entries, data + kPageEntriesOffset, sizeof(uint16_t));
+          for (uint16_t j = 0; j < entries && ok(); ++j) {
+            uint16_t offset = 0;
+            size_t index_offset = header_size + j * sizeof(uint16_t);
+            if (index_offset + sizeof(uint16_t) > page_size) {
+              code_ = EINVAL;
+              break;
+            }
+            memcpy(&offset, data + index_offset, sizeof(uint16_t));
+            db_pgno_t child = 0;
+            if (offset + child_offset + sizeof(db_pgno_t) > page_size) {
+              code_ = EINVAL;
+              break;
+            }
+            memcpy(&child, data + offset + child_offset, sizeof(db_pgno_t));
+            if (child == 0 || child > last_pgno)
+              code_ = EINVAL;
+            else
+              children.push_back(child);
+          }
+        }
+        int code = mpf->put(mpf, page, DB_PRIORITY_VERY_HIGH, 0);
+        if (ok())
+          code_ = code;
+        if (!ok()) return false;
+        ++(*num_pages);
+        kept_pages.push_back(make_pair(level[i], level[i]));
+      }
+      meta = false;
+      level.swap(children);
+    }
+  }
+  if (environment_ == NULL)
+    return true;
+  const char* filename = NULL;
+  const char* name = NULL;
+  code_ = database_->get_dbname(database_, &filename, &name);
+  if (!ok()) return false;
+  if (filename == NULL)
+    return true;
+  uint8_t file_id[DB_FILE_ID_LEN];
+  code_ = mpf->get_fileid(mpf, file_id);
+  if (!ok()) return false;
+  uint32_t page_size = 0;
+  code_ = database_->get_pagesize(database_, &page_size);
+  if (!ok()) return false;
+  for (size_t i = 0; i < kept_pages.size(); ++i)
+    environment_->add_warm_pages(
+        filename,
+        string(reinterpret_cast<char*>(file_id), DB_FILE_ID_LEN),
+        page_size,
+        kept_pages[i].first,
+        kept_pages[i].second);
+  return true;
+}
+
+bool Database::find_meta_page(db_pgno_t* meta_pgno) {
+  const char* filename = NULL;
+  const char* name = NULL;
+  code_ = database_->get_dbname(database_, &filename, &name);
+  if (!ok()) return false;
+  *meta_pgno = 0;
+  if (name == NULL)
+    return true;
+  if (filename == NULL) {
+    code_ = EINVAL;
+    return false;
+  }
+  // The master database of the file maps the name to the meta page number
+  // in big-endian.
+  DB* master = NULL;
+  code_ = db_create(&master, database_->get_env(database_), 0);
+  if (!ok()) return false;
+  code_ = master->open(master, NULL, filename, NULL, DB_BTREE, DB_RDONLY, 0);
+  if (ok()) {
+    uint8_t buffer[sizeof(db_pgno_t)];
+    DBT key, value;
+    memset(&key, 0, sizeof(DBT));
+    memset(&value, 0, sizeof(DBT));
+    key.data = const_cast<char*>(name);
+    key.size = strlen(name);
+    value.data = buffer;
+    value.ulen = sizeof(buffer);
+    value.flags = DB_DBT_USERMEM;
+    code_ = master->get(master, NULL, &key, &value, 0);
+    if (ok() && value.size != sizeof(buffer))
+      code_ = EINVAL;
+    if (ok())
+      *meta_pgno = (static_cast<db_pgno_t>(buffer[0]) << 24) |
+                   (static_cast<db_pgno_t>(buffer[1]) << 16) |
+                   (static_cast<db_pgno_t>(buffer[2]) << 8) |
+                   static_cast<db_pgno_t>(buffer[3]);
+  }
+  int code = master->close(master, 0);
+  if (ok())
+    code_ = code;
+  return ok();
+}
+
+bool Database::bulk_load(const mxArray* keys,
+                         const mxArray* values,
+                         size_t memory_limit,
+                         int* num_records) {
+  error_detail_.clear();
+  if (!mxIsCell(keys) || !mxIsCell(values))
+    ERROR("Keys and values must be cell arrays.");
+  if (mxGetNumberOfElements(keys) != mxGetNumberOfElements(values))
+    ERROR("Keys and values must have the same number of elements.");
+  // Sorting by encoded keys fills pages of the default btree order. A hash
+  // database only gains the deduplication and the batched commits.
+  if (type_ != DB_BTREE && type_ != DB_HASH) {
+    code_ = EINVAL;
+    return false;
+  }
+  RecordSorter sorter(memory_limit);
+  for (mwIndex i = 0; i < mxGetNumberOfElements(keys); ++i) {
+    Record record(mxGetCell(keys, i), mxGetCell(values, i), native_values_);
+    string bytes(static_cast<const char*>(record.value()->data),
+                 record.value()->size);
+    if (!log_value(record.key_bytes(), &bytes, false))
+      return false;
+    if (!sorter.add(record.key_bytes(), bytes))
+      ERROR("Failed to write a temporary file.");
+  }
+  if (!sorter.finish())
+    ERROR("Failed to write a temporary file.");
+  // Logged values must be on disk before their pointers.
+  if (value_log_ != NULL && !value_log_->sync()) {
+    code_ = value_log_->error_code();
+    return false;
+  }
+  cache_.clear();
+  // Bulk transactions of a bounded number of records avoid logging every
+  // page of the new tree while keeping the lock and log footprint small.
+  DB_TXN* transaction = NULL;
+  DB_ENV* environment = database_->get_env(database_);
+  bool transactional = database_->get_transactional(database_);
+  uint32_t transaction_flags = 0;
+#ifdef DB_TXN_BULK
+  transaction_flags |= DB_TXN_BULK;
+#endif
+  *num_records = 0;
+  string key_bytes, value_bytes;
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.flags = DB_DBT_USERMEM;
+  value.flags = DB_DBT_USERMEM;
+  while (sorter.next(&key_bytes, &value_bytes)) {
+    if (transactional && transaction == NULL) {
+      code_ = environment->txn_begin(environment,
+                                     NULL,
+                                     &transaction,
+                                     transaction_flags);
+      if (!ok()) return false;
+    }
+    key.data = const_cast<char*>(key_bytes.data());
+    key.size = key_bytes.size();
+    value.data = const_cast<char*>(value_bytes.data());
+    value.size = value_bytes.size();
+    code_ = database_->put(database_, transaction, &key, &value, 0);
+    if (!ok()) {
+      if (transaction)
+        transaction->abort(transaction);
+      return false;
+    }
+    ++(*num_records);
+    if (transaction && *num_records % kImportBatchSize == 0) {
+      code_ = transaction->commit(transaction, 0);
+      transaction = NULL;
+      if (!ok()) return false;
+    }
+  }
+  if (!sorter.ok()) {
+    if (transaction)
+      transaction->abort(transaction);
+    code_ = EIO;
+    return false;
+  }
+  if (transaction) {
+    code_ = transaction->commit(transaction, 0);
+    if (!ok()) return false;
+  }
+  code_ = database_->sync(database_, 0);
+  return ok();
+}
+
+bool Database::export_dump(const string& filename,
+                           bool compress,
+                           int* num_records) {
+  error_detail_.clear();
+  DumpWriter writer;
+  if (!writer.open(filename, compress))
+    ERROR("%s", writer.error_message());
+  DBTYPE type;
+  code_ = database_->get_type(database_, &type);
+  if (!ok()) return false;
+  DBC* cursor = NULL;
+  code_ = database_->cursor(database_, NULL, &cursor, 0);
+  if (!ok()) return false;
+  *num_records = 0;
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  vector<uint8_t> buffer;
+  if (type == DB_BTREE || type == DB_HASH) {
+    // Retrieve pages of records at once.
+    buffer.resize(kBulkBufferSize);
+    value.flags = DB_DBT_USERMEM;
+    while (true) {
+      value.data = &buffer[0];
+      value.ulen = buffer.size();
+      code_ = cursor->get(cursor, &key, &value, DB_NEXT | DB_MULTIPLE_KEY);
+      if (code_ == DB_BUFFER_SMALL) {
+        buffer.resize(max<size_t>(buffer.size() * 2, value.size));
+        continue;
+      }
+      if (!ok()) break;
+      void* pointer = NULL;
+      DB_MULTIPLE_INIT(pointer, &value);
+      while (true) {
+        void* key_data = NULL;
+        void* value_data = NULL;
+        uint32_t key_size = 0;
+        uint32_t value_size = 0;
+        DB_MULTIPLE_KEY_NEXT(pointer,
+                             &value,
+                             key_data,
+                             key_size,
+                             value_data,
+                             value_size);
+        if (pointer == NULL)
+          break;
+        // Dumps carry logged values in place of their pointers.
+        string bytes(static_cast<const char*>(value_data), value_size);
+        if (!resolve_value(&bytes)) {
+          cursor->close(cursor);
+          return false;
+        }
+        if (!writer.add(key_data, key_size, bytes.data(), bytes.size())) {
+          cursor->close(cursor);
+          ERROR("%s", writer.error_message());
+        }
+        ++(*num_records);
+      }
+    }
+  }
+  else {
+    key.flags = DB_DBT_REALLOC;
+    value.flags = DB_DBT_REALLOC;
+    while ((code_ = cursor->get(cursor, &key, &value, DB_NEXT)) == 0) {
+      string bytes(static_cast<const char*>(value.data), value.size);
+      if (!resolve_value(&bytes))
+        break;
+      if (!writer.add(key.data, key.size, bytes.data(), bytes.size())) {
+        cursor->close(cursor);
+        ERROR("%s", writer.error_message());
+      }
+      ++(*num_records);
+    }
+    if (key.data)
+      free(key.data);
+    if (value.data)
+      free(value.data);
+  }
+  cursor->close(cursor);
+  if (code_ != DB_NOTFOUND)
+    return false;
+  code_ = 0;
+  if (!writer.close())
+    ERROR("%s", writer.error_message());
+  return ok();
+}
+
+bool Database::import_dump(const string& filename, int* num_records) {
+  error_detail_.clear();
+  DumpReader reader;
+  if (!reader.open(filename))
+    ERROR("%s", reader.error_message());
+  cache_.clear();
+  DB_ENV* environment = database_->get_env(database_);
+  bool transactional = database_->get_transactional(database_);
+  DB_TXN* transaction = NULL;
+  *num_records = 0;
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.flags = DB_DBT_USERMEM;
+  value.flags = DB_DBT_USERMEM;
+  vector<pair<string, string> > batch;
+  bool more = true;
+  while (more) {
+    // Values of a batch are logged first and flushed once before their
+    // pointers are put.
+    batch.clear();
+    string key_bytes, value_bytes;
+    while (batch.size() < static_cast<size_t>(kImportBatchSize) &&
+           (more = reader.next(&key_bytes, &value_bytes))) {
+      if (!log_value(key_bytes, &value_bytes, false))
+        return false;
+      batch.push_back(make_pair(key_bytes, value_bytes));
+    }
+    if (batch.empty())
+      break;
+    if (value_log_ != NULL && !value_log_->sync()) {
+      code_ = value_log_->error_code();
+      return false;
+    }
+    if (transactional) {
+      code_ = environment->txn_begin(environment, NULL, &transaction, 0);
+      if (!ok()) return false;
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+      key.data = const_cast<char*>(batch[i].first.data());
+      key.size = batch[i].first.size();
+      value.data = const_cast<char*>(batch[i].second.data());
+      value.size = batch[i].second.size();
+      code_ = database_->put(database_, transaction, &key, &value, 0);
+      if (!ok()) {
+        if (transaction)
+          transaction->abort(transaction);
+        return false;
+      }
+    }
+    if (transaction) {
+      code_ = transaction->commit(transaction, 0);
+      transaction = NULL;
+      if (!ok()) return false;
+    }
+    *num_records += batch.size();
+  }
+  if (reader.failed())
+    ERROR("%s", reader.error_message());
+  code_ = database_->sync(database_, 0);
+  return ok();
+}
+
+bool Database::append(const mxArray* values,
+                      Transaction* transaction,
+                      mxArray** recnos) {
+  error_detail_.clear();
+  if (!mxIsCell(values))
+    ERROR("Values must be a cell array.");
+  DBTYPE type;
+  code_ = database_->get_type(database_, &type);
+  if (!ok()) return false;
+  if (type != DB_QUEUE && type != DB_RECNO) {
+    code_ = EINVAL;
+    return false;
+  }
+  // Encode everything first so that the transaction is kept short.
+  mwSize num_values = mxGetNumberOfElements(values);
+  vector<string> encoded(num_values);
+  for (mwIndex i = 0; i < num_values; ++i) {
+    if (!native_values_ ||
+        !Record::encode_native(mxGetCell(values, i), &encoded[i]))
+      Record::encode_value(mxGetCell(values, i), &encoded[i]);
+  }
+  // One commit per call amortizes the log flush over the batch.
+  DB_TXN* parent = (transaction == NULL) ? NULL : transaction->get();
+  DB_TXN* batch = NULL;
+  if (parent == NULL && database_->get_transactional(database_)) {
+    DB_ENV* environment = database_->get_env(database_);
+    code_ = environment->txn_begin(environment, NULL, &batch, 0);
+    if (!ok()) return false;
+  }
+  vector<db_recno_t> numbers(num_values);
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.flags = DB_DBT_USERMEM;
+  key.ulen = sizeof(db_recno_t);
+  value.flags = DB_DBT_USERMEM;
+  for (mwIndex i = 0; i < num_values; ++i) {
+    key.data = &numbers[i];
+    value.data = const_cast<char*>(encoded[i].data());
+    value.size = encoded[i].size();
+    code_ = database_->put(database_,
+                           (batch) ? batch : parent,
+                           &key,
+                           &value,
+                           DB_APPEND);
+    if (!ok()) {
+      if (batch)
+        batch->abort(batch);
+      return false;
+    }
+  }
+  if (batch) {
+    code_ = batch->commit(batch, 0);
+    if (!ok()) return false;
+  }
+  *recnos = mxCreateDoubleMatrix(num_values, 1, mxREAL);
+  double* output = mxGetPr(*recnos);
+  for (mwIndex i = 0; i < num_values; ++i)
+    output[i] = numbers[i];
+  return true;
+}
+
+bool Database::consume(int count,
+                       bool wait,
+                       Transaction* transaction,
+                       mxArray** values,
+                       mxArray** recnos) {
+  error_detail_.clear();
+  DB_TXN* parent = (transaction == NULL) ? NULL : transaction->get();
+  DB_TXN* batch = NULL;
+  if (parent == NULL && database_->get_transactional(database_)) {
+    DB_ENV* environment = database_->get_env(database_);
+    code_ = environment->txn_begin(environment, NULL, &batch, 0);
+    if (!ok()) return false;
+  }
+  vector<db_recno_t> numbers;
+  vector<string> encoded;
+  db_recno_t number = 0;
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.data = &number;
+  key.ulen = sizeof(db_recno_t);
+  key.flags = DB_DBT_USERMEM;
+  value.flags = DB_DBT_REALLOC;
+  code_ = 0;
+  while (static_cast<int>(encoded.size()) < count) {
+    // Only the first record is waited for; the rest drain what is there.
+    uint32_t flags = (wait && encoded.empty()) ? DB_CONSUME_WAIT : DB_CONSUME;
+    code_ = database_->get(database_,
+                           (batch) ? batch : parent,
+                           &key,
+                           &value,
+                           flags);
+    if (!ok()) break;
+    numbers.push_back(number);
+    encoded.push_back(string(static_cast<const char*>(value.data),
+                             value.size));
+  }
+  if (value.data)
+    free(value.data);
+  if (!ok() && code_ != DB_NOTFOUND) {
+    if (batch)
+      batch->abort(batch);
+    return false;
+  }
+  if (batch) {
+    code_ = batch->commit(batch, 0);
+    if (!ok()) return false;
+  }
+  code_ = 0;
+  cache_.clear();
+  *values = mxCreateCellMatrix(encoded.size(), 1);
+  for (size_t i = 0; i < encoded.size(); ++i) {
+    Record record;
+    record.assign(string(), encoded[i]);
+    mxArray* element = NULL;
+    record.get_value(&element);
+    mxSetCell(*values, i, element);
+  }
+  if (recnos) {
+    *recnos = mxCreateDoubleMatrix(numbers.size(), 1, mxREAL);
+    double* output = mxGetPr(*recnos);
+    for (size_t i = 0; i < numbers.size(); ++i)
+      output[i] = numbers[i];
+  }
+  return true;
+}
+
+/// Decode raw records of a database of the access method into column cell
+/// arrays of values and keys, resolving values from the value log if any.
+/// Keys may be NULL.
+static void decode_records(const vector<pair<string, string> >& records,
+                           DBTYPE type,
+                           ValueLog* value_log,
+                           mxArray** values,
+                           mxArray** keys) {
+  *values = mxCreateCellMatrix(records.size(), 1);
+  if (keys)
+    *keys = mxCreateCellMatrix(records.size(), 1);
+  for (size_t i = 0; i < records.size(); ++i) {
+    Record record;
+    record.assign(records[i].first, records[i].second);
+    record.set_key_type(type);
+    record.set_value_log(value_log);
+    mxArray* element = NULL;
+    record.get_value(&element);
+    mxSetCell(*values, i, element);
+    if (keys) {
+      record.get_key(&element);
+      mxSetCell(*keys, i, element);
+    }
+  }
+}
+
+bool Database::create_index(const string& field,
+                            const string& filename,
+                            Database* index) {
+  error_detail_.clear();
+  if (index == NULL)
+    ERROR("Null pointer exception.");
+  uint32_t open_flags = 0;
+  code_ = database_->get_open_flags(database_, &open_flags);
+  if (!ok()) return false;
+  bool transactional = database_->get_transactional(database_);
+  string index_filename = filename;
+  if (index_filename.empty()) {
+    const char* primary_filename = NULL;
+    const char* primary_name = NULL;
+    code_ = database_->get_dbname(database_, &primary_filename, &primary_name);
+    if (!ok()) return false;
+    if (primary_filename) {
+      index_filename = string(primary_filename) + "." +
+          ((primary_name) ? string(primary_name) + "." : string("")) +
+          field + ".idx";
+    }
+  }
+  uint32_t flags =
+      (open_flags & (DB_THREAD | DB_RDONLY | DB_MULTIVERSION |
+                     DB_READ_UNCOMMITTED)) |
+      ((open_flags & DB_RDONLY) ? 0 : DB_CREATE) |
+      (transactional ? DB_AUTO_COMMIT : 0);
+  DatabaseConfig config;
+  config.duplicates = DB_DUPSORT;
+  if (!index->open(index_filename,
+                   "",
+                   DB_BTREE,
+                   flags,
+                   0,
+                   environment_,
+                   NULL,
+                   config)) {
+    code_ = index->error_code();
+    return false;
+  }
+  index->index_field_ = field;
+  index->database_->app_private = index;
+  index->primary_ = this;
+  DB_TXN* transaction = NULL;
+  if (transactional) {
+    DB_ENV* environment = database_->get_env(database_);
+    code_ = environment->txn_begin(environment, NULL, &transaction, 0);
+    if (!ok()) {
+      index->primary_ = NULL;
+      return false;
+    }
+  }
+  // Index existing records when the index is empty.
+  code_ = database_->associate(database_,
+                               transaction,
+                               index->database_,
+                               &Database::extract_index_key,
+                               DB_CREATE);
+  if (transaction) {
+    if (ok())
+      code_ = transaction->commit(transaction, 0);
+    else
+      transaction->abort(transaction);
+  }
+  if (!ok()) {
+    index->primary_ = NULL;
+    return false;
+  }
+  ++num_indexes_;
+  return ok();
+}
+
+bool Database::get_by(const mxArray* lower,
+                      const mxArray* upper,
+                      mxArray** values,
+                      mxArray** keys) {
+  error_detail_.clear();
+  if (primary_ == NULL)
+    ERROR("Not an index.");
+  string lower_bytes, upper_bytes;
+  if (!encode_index_key(lower, &lower_bytes))
+    ERROR("Failed to encode an index key.");
+  if (upper) {
+    if (!encode_index_key(upper, &upper_bytes))
+      ERROR("Failed to encode an index key.");
+  }
+  else
+    upper_bytes = lower_bytes;
+  DBC* cursor = NULL;
+  code_ = database_->cursor(database_, NULL, &cursor, 0);
+  if (!ok()) return false;
+  DBT index_key, key, value;
+  memset(&index_key, 0, sizeof(DBT));
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  index_key.flags = DB_DBT_REALLOC;
+  key.flags = DB_DBT_REALLOC;
+  value.flags = DB_DBT_REALLOC;
+  index_key.data = malloc(max<size_t>(lower_bytes.size(), 1));
+  if (index_key.data == NULL)
+    ERROR("Failed to allocate memory.");
+  memcpy(index_key.data, lower_bytes.data(), lower_bytes.size());
+  index_key.size = lower_bytes.size();
+  vector<pair<string, string> > records;
+  uint32_t flags = DB_SET_RANGE;
+  while ((code_ = cursor->pget(cursor, &index_key, &key, &value, flags)) ==
+         0) {
+    string found(static_cast<const char*>(index_key.data), index_key.size);
+    if (RecordSorter::compare(found, upper_bytes) > 0)
+      break;
+    records.push_back(pair<string, string>(
+        string(static_cast<const char*>(key.data), key.size),
+        string(static_cast<const char*>(value.data), value.size)));
+    flags = DB_NEXT;
+  }
+  cursor->close(cursor);
+  free(index_key.data);
+  if (key.data)
+    free(key.data);
+  if (value.data)
+    free(value.data);
+  if (code_ != 0 && code_ != DB_NOTFOUND)
+    return false;
+  code_ = 0;
+  decode_records(records, type_, value_log_, values, keys);
+  return ok();
+}
+
+bool Database::join(const vector<Database*>& indexes,
+                    const vector<const mxArray*>& index_values,
+                    uint32_t flags,
+                    mxArray** values,
+                    mxArray** keys) {
+  error_detail_.clear();
+  if (indexes.empty() || indexes.size() != index_values.size())
+    ERROR("Invalid join condition.");
+  for (size_t i = 0; i < indexes.size(); ++i)
+    if (indexes[i]->primary_ != this)
+      ERROR("Index is not associated with the database.");
+  // Position a cursor of each index on its value; the NULL terminates.
+  vector<DBC*> cursors(indexes.size() + 1, static_cast<DBC*>(NULL));
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.flags = DB_DBT_REALLOC;
+  value.flags = DB_DBT_REALLOC;
+  vector<pair<string, string> > records;
+  code_ = 0;
+  for (size_t i = 0; ok() && i < indexes.size(); ++i) {
+    string index_key;
+    if (!encode_index_key(index_values[i], &index_key)) {
+      code_ = EINVAL;
+      break;
+    }
+    DB* index = indexes[i]->database_;
+    code_ = index->cursor(index, NULL, &cursors[i], 0);
+    if (!ok()) break;
+    DBT index_dbt;
+    memset(&index_dbt, 0, sizeof(DBT));
+    index_dbt.data = const_cast<char*>(index_key.data());
+    index_dbt.size = index_key.size();
+    index_dbt.ulen = index_key.size();
+    index_dbt.flags = DB_DBT_USERMEM;
+    code_ = cursors[i]->get(cursors[i], &index_dbt, &value, DB_SET);
+  }
+  if (ok()) {
+    DBC* join_cursor = NULL;
+    code_ = database_->join(database_, &cursors[0], &join_cursor, flags);
+    while (ok() &&
+           (code_ = join_cursor->get(join_cursor, &key, &value, 0)) == 0)
+      records.push_back(pair<string, string>(
+          string(static_cast<const char*>(key.data), key.size),
+          string(static_cast<const char*>(value.data), value.size)));
+    if (join_cursor)
+      join_cursor->close(join_cursor);
+  }
+  for (size_t i = 0; i < cursors.size(); ++i)
+    if (cursors[i])
+      cursors[i]->close(cursors[i]);
+  if (key.data)
+    free(key.data);
+  if (value.data)
+    free(value.data);
+  if (code_ != 0 && code_ != DB_NOTFOUND)
+    return false;
+  code_ = 0;
+  decode_records(records, type_, value_log_, values, keys);
+  return ok();
+}
+
+bool Database::encode_index_key(const mxArray* value, string* key) {
+  key->clear();
+  if ((mxIsNumeric(value) || mxIsLogical(value)) && !mxIsComplex(value) &&
+      !mxIsSparse(value) && mxGetNumberOfElements(value) == 1) {
+    // Flip the sign bit of positive numbers and all bits of negative ones,
+    // so that big-endian bytes sort in numeric order.
+    double number = mxGetScalar(value);
+    uint64_t bits = 0;
+    memcpy(&bits, &number, sizeof(bits));
+    const uint64_t kSignBit = static_cast<uint64_t>(1) << 63;
+    bits = (bits & kSignBit) ? ~bits : (bits | kSignBit);
+    key->push_back(static_cast<char>(kIndexNumber));
+    for (int i = 7; i >= 0; --i)
+      key->push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+  }
+  else if (mxIsChar(value) && mxGetM(value) <= 1) {
+    const mxChar* chars = mxGetChars(value);
+    key->push_back(static_cast<char>(kIndexChar));
+    for (size_t i = 0; i < mxGetNumberOfElements(value); ++i) {
+      key->push_back(static_cast<char>((chars[i] >> 8) & 0xFF));
+      key->push_back(static_cast<char>(chars[i] & 0xFF));
+    }
+  }
+  else {
+    // Serialized without Record, which raises errors, since this runs in
+    // the secondary key callback.
+    mxArray* serialized_array = static_cast<mxArray*>(mxSerialize(value));
+    if (serialized_array == NULL)
+      return false;
+    key->push_back(static_cast<char>(kIndexOther));
+    key->append(static_cast<const char*>(mxGetData(serialized_array)),
+                mxGetNumberOfElements(serialized_array));
+    mxDestroyArray(serialized_array);
+  }
+  return true;
+}
+
+int Database::extract_index_key(DB* secondary,
+                                const DBT* key,
+                                const DBT* data,
+                                DBT* result) {
+  // Errors must not be raised inside Berkeley DB. The message is kept in
+  // the primary and reported by the caller of the failed operation.
+  Database* index = static_cast<Database*>(secondary->app_private);
+  Database* primary = index->primary_;
+  mxArray* value = NULL;
+  if (!Record::decode_value(data->data,
+                            data->size,
+                            primary->value_log_,
+                            &value,
+                            &primary->error_detail_))
+    return EINVAL;
+  int code = DB_DONOTINDEX;
+  mxArray* field = (mxIsStruct(value) && mxGetNumberOfElements(value) == 1) ?
+      mxGetField(value, 0, index->index_field_.c_str()) : NULL;
+  if (field && !mxIsEmpty(field)) {
+    string index_key;
+    if (!encode_index_key(field, &index_key)) {
+      primary->error_detail_ = "Failed to encode an index key.";
+      code = EINVAL;
+    }
+    else {
+      memset(result, 0, sizeof(DBT));
+      result->data = malloc(max<size_t>(index_key.size(), 1));
+      if (result->data) {
+        memcpy(result->data, index_key.data(), index_key.size());
+        result->size = index_key.size();
+        result->flags = DB_DBT_APPMALLOC;
+        code = 0;
+      }
+      else
+        code = ENOMEM;
+    }
+  }
+  mxDestroyArray(value);
+  return code;
+}
+
+bool Database::prefetch(const mxArray* keys) {
+  error_detail_.clear();
+  vector<string> key_bytes;
+  if (mxIsCell(keys)) {
+    key_bytes.reserve(mxGetNumberOfElements(keys));
+    for (mwIndex i = 0; i < mxGetNumberOfElements(keys); ++i)
+      key_bytes.push_back(encode_key(mxGetCell(keys, i)));
+  }
+  else
+    key_bytes.push_back(encode_key(keys));
+  if (prefetcher_ == NULL)
+    prefetcher_ = new Prefetcher(database_);
+  code_ = (prefetcher_->push(key_bytes)) ? 0 : EAGAIN;
   return ok();
 }
 
+bool Database::is_threaded() {
+  uint32_t flags = 0;
+  code_ = database_->get_open_flags(database_, &flags);
+  return ok() && (flags & DB_THREAD);
+}
+
+bool Database::get_async(const mxArray* key, AsyncOperation* operation) {
+  error_detail_.clear();
+  if (operation == NULL)
+    ERROR("Null pointer exception.");
+  operation->reset(database_, AsyncOperation::GET, &pending_writes_);
+  operation->add(encode_key(key), string());
+  return submit(operation);
+}
+
+bool Database::put_async(const mxArray* key,
+                         const mxArray* value,
+                         AsyncOperation* operation) {
+  error_detail_.clear();
+  if (operation == NULL)
+    ERROR("Null pointer exception.");
+  // Index callbacks decode values and must run on the matlab thread.
+  if (num_indexes_ > 0)
+    ERROR("Asynchronous put is not supported on an indexed database.");
+  Record record(key, value, native_values_);
+  if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
+  string bytes(static_cast<const char*>(record.value()->data),
+               record.value()->size);
+  if (!log_value(record.key_bytes(), &bytes))
+    return false;
+  invalidate(&record, 0);
+  operation->reset(database_, AsyncOperation::PUT, &pending_writes_);
+  operation->add(record.key_bytes(), bytes);
+  return submit(operation);
+}
+
+bool Database::mget_async(const mxArray* keys, AsyncOperation* operation) {
+  error_detail_.clear();
+  if (operation == NULL)
+    ERROR("Null pointer exception.");
+  if (!mxIsCell(keys))
+    ERROR("Keys must be a cell array.");
+  operation->reset(database_, AsyncOperation::MGET, &pending_writes_);
+  for (mwIndex i = 0; i < mxGetNumberOfElements(keys); ++i)
+    operation->add(encode_key(mxGetCell(keys, i)), string());
+  return submit(operation);
+}
+
+bool Database::submit(AsyncOperation* operation) {
+  if (pool_ == NULL)
+    pool_ = new ThreadPool(kAsyncThreads);
+  operation->submit();
+  if (!pool_->push(operation))
+    operation->fail(EAGAIN);
+  code_ = operation->error_code();
+  return ok();
+}
+
+void Database::invalidate(Record* record, uint32_t flags) {
+  if (!cache_.enabled())
+    return;
+  if (flags & (DB_APPEND | DB_MULTIPLE | DB_MULTIPLE_KEY))
+    cache_.clear();
+  else
+    cache_.erase(record->key_bytes());
+}
+
+string Database::encode_key(const mxArray* key) {
+  Record record(key);
+  if (Record::has_native_keys(type_))
+    record.set_native_key(key, type_);
+  return record.key_bytes();
+}
+
+/// Add an integral delta to an integer, saturating at the limits of T. The
+/// difference to a limit is exact in 64-bit unsigned arithmetic.
+template <typename T>
+static T add_integral(T value, double whole) {
+  const double kTwoTo64 = 18446744073709551616.0;
+  if (whole >= 0) {
+    uint64_t room = static_cast<uint64_t>(numeric_limits<T>::max()) -
+                    static_cast<uint64_t>(value);
+    if (whole >= kTwoTo64 || static_cast<uint64_t>(whole) >= room)
+      return numeric_limits<T>::max();
+    return static_cast<T>(static_cast<uint64_t>(value) +
+                          static_cast<uint64_t>(whole));
+  }
+  uint64_t room = static_cast<uint64_t>(value) -
+                  static_cast<uint64_t>(numeric_limits<T>::min());
+  if (-whole >= kTwoTo64 || static_cast<uint64_t>(-whole) >= room)
+    return numeric_limits<T>::min();
+  return static_cast<T>(static_cast<uint64_t>(value) -
+                        static_cast<uint64_t>(-whole));
+}
+
+/// Add a delta to an element as matlab arithmetic does: floating point
+/// classes add in their precision, and integers add exactly, rounding half
+/// away from zero and saturating.
+template <typename T>
+static T add_element(T value, double delta) {
+  if (!numeric_limits<T>::is_integer)
+    return static_cast<T>(static_cast<double>(value) + delta);
+  if (delta != delta)
+    return 0;
+  double whole = floor(delta);
+  double fraction = delta - whole;
+  T sum = add_integral<T>(value, whole);
+  // The sum plus a half rounds up only from a non-negative integer.
+  if (fraction > 0.5 || (fraction == 0.5 && sum >= 0))
+    sum = add_integral<T>(sum, 1.0);
+  return sum;
+}
+
+/// Add a delta to elements of type T in place.
+template <typename T>
+static void add_elements(char* data, size_t num_elements, double delta) {
+  for (size_t i = 0; i < num_elements; ++i) {
+    T element;
+    memcpy(&element, data + i * sizeof(T), sizeof(T));
+    element = add_element<T>(element, delta);
+    memcpy(data + i * sizeof(T), &element, sizeof(T));
+  }
+}
+
+/// Read the header of a native value and check that the bytes hold exactly
+/// its elements.
+static bool read_native_value(const string& bytes, NativeHeader* header) {
+  return Record::read_native_header(bytes.data(), bytes.size(), header) &&
+         bytes.size() == sizeof(NativeHeader) +
+             header->rows * header->columns * Record::native_element_size(
+                 static_cast<mxClassID>(header->class_id));
+}
+
+/// Add a delta to every element of a native numeric value.
+class IncrementUpdater : public RecordUpdater {
+public:
+  explicit IncrementUpdater(double delta) : delta_(delta) {}
+  virtual int update(bool found, string* bytes, bool* write) {
+    NativeHeader header;
+    if (!found) {
+      Record::make_native_header(mxDOUBLE_CLASS, 1, 1, &header);
+      bytes->assign(reinterpret_cast<const char*>(&header),
+                    sizeof(NativeHeader));
+      bytes->append(reinterpret_cast<const char*>(&delta_), sizeof(double));
+      *write = true;
+      return 0;
+    }
+    if (!read_native_value(*bytes, &header))
+      return EINVAL;
+    char* data = &(*bytes)[sizeof(NativeHeader)];
+    size_t num_elements = header.rows * header.columns;
+    switch (static_cast<mxClassID>(header.class_id)) {
+      case mxDOUBLE_CLASS: add_elements<double>(data, num_elements, delta_);
+                           break;
+      case mxSINGLE_CLASS: add_elements<float>(data, num_elements, delta_);
+                           break;
+      case mxINT8_CLASS:   add_elements<int8_t>(data, num_elements, delta_);
+                           break;
+      case mxUINT8_CLASS:  add_elements<uint8_t>(data, num_elements, delta_);
+                           break;
+      case mxINT16_CLASS:  add_elements<int16_t>(data, num_elements, delta_);
+                           break;
+      case mxUINT16_CLASS: add_elements<uint16_t>(data, num_elements, delta_);
+                           break;
+      case mxINT32_CLASS:  add_elements<int32_t>(data, num_elements, delta_);
+                           break;
+      case mxUINT32_CLASS: add_elements<uint32_t>(data, num_elements, delta_);
+                           break;
+      case mxINT64_CLASS:  add_elements<int64_t>(data, num_elements, delta_);
+                           break;
+      case mxUINT64_CLASS: add_elements<uint64_t>(data, num_elements, delta_);
+                           break;
+      default:             return EINVAL;
+    }
+    *write = true;
+    return 0;
+  }
+
+private:
+  /// Added value.
+  double delta_;
+};
+
+/// Append elements to a native vector value.
+class AppendUpdater : public RecordUpdater {
+public:
+  /// Take the native encoding of the appended elements.
+  explicit AppendUpdater(const string& values) : values_(values) {
+    valid_ = read_native_value(values_, &header_);
+  }
+  virtual int update(bool found, string* bytes, bool* write) {
+    if (!valid_)
+      return EINVAL;
+    uint64_t num_values = header_.rows * header_.columns;
+    if (!found) {
+      // Keep a row vector, and make anything else a column.
+      NativeHeader header = header_;
+      if (header.rows != 1) {
+        header.rows = num_values;
+        header.columns = 1;
+      }
+      bytes->assign(reinterpret_cast<const char*>(&header),
+                    sizeof(NativeHeader));
+      bytes->append(values_, sizeof(NativeHeader), string::npos);
+      *write = true;
+      return 0;
+    }
+    NativeHeader header;
+    if (!read_native_value(*bytes, &header) ||
+        header.class_id != header_.class_id)
+      return EINVAL;
+    if (header.rows * header.columns == 0) {
+      header.rows = (header_.rows == 1) ? 1 : num_values;
+      header.columns = (header_.rows == 1) ? num_values : 1;
+    }
+    else if (header.rows == 1 && header.columns > 1)
+      header.columns += num_values;
+    else if (header.columns == 1)
+      header.rows += num_values;
+    else
+      return EINVAL;
+    memcpy(&(*bytes)[0], &header, sizeof(NativeHeader));
+    bytes->append(values_, sizeof(NativeHeader), string::npos);
+    *write = true;
+    return 0;
+  }
+
+private:
+  /// Native encoding of the appended elements.
+  string values_;
+  /// Header of the appended elements.
+  NativeHeader header_;
+  /// Whether the appended elements are a well-formed native value.
+  bool valid_;
+};
+
+/// Replace a value only if it equals the expected one.
+class CompareAndSwapUpdater : public RecordUpdater {
+public:
+  /// Take encodings of the expected value in both codecs and the new value.
+  CompareAndSwapUpdater(bool expect_missing,
+                        const string& expected_native,
+                        const string& expected_compressed,
+                        const string& value) :
+      expect_missing_(expect_missing),
+      expected_native_(expected_native),
+      expected_compressed_(expected_compressed),
+      value_(value),
+      swapped_(false) {}
+  virtual int update(bool found, string* bytes, bool* write) {
+    if (!found)
+      swapped_ = expect_missing_;
+    else if (Record::is_native(bytes->data(), bytes->size()))
+      swapped_ = (*bytes == expected_native_);
+    else
+      swapped_ = (*bytes == expected_compressed_);
+    if (swapped_)
+      *bytes = value_;
+    *write = swapped_;
+    return 0;
+  }
+  /// Return if the value was replaced.
+  bool swapped() const { return swapped_; }
+
+private:
+  /// Match a missing key.
+  bool expect_missing_;
+  /// Expected value in the native codec, or empty if not supported.
+  string expected_native_;
+  /// Expected value in the compressed codec.
+  string expected_compressed_;
+  /// New value.
+  string value_;
+  /// Result.
+  bool swapped_;
+};
+
+bool Database::update_record(const string& key_bytes,
+                             RecordUpdater* updater,
+                             string* result) {
+  DB_ENV* environment = database_->get_env(database_);
+  bool transactional = database_->get_transactional(database_);
+  for (int attempt = 0; attempt < kUpdateRetries; ++attempt) {
+    DB_TXN* transaction = NULL;
+    if (transactional) {
+      code_ = environment->txn_begin(environment, NULL, &transaction, 0);
+      if (!ok()) return false;
+    }
+    DBT key, value;
+    memset(&key, 0, sizeof(DBT));
+    memset(&value, 0, sizeof(DBT));
+    key.data = const_cast<char*>(key_bytes.data());
+    key.size = key_bytes.size();
+    key.ulen = key_bytes.size();
+    key.flags = DB_DBT_USERMEM;
+    value.flags = DB_DBT_REALLOC;
+    // The write lock is taken on read so that concurrent updates serialize
+    // instead of deadlocking on lock upgrade.
+    code_ = database_->get(database_,
+                           transaction,
+                           &key,
+                           &value,
+                           (transaction) ? DB_RMW : 0);
+    bool found = ok();
+    string bytes;
+    if (found)
+      bytes.assign(static_cast<const char*>(value.data), value.size);
+    if (value.data)
+      free(value.data);
+    // A value log failure skips the update and aborts below.
+    if (found && !resolve_value(&bytes))
+      found = false;
+    bool write = false;
+    if (found || code_ == DB_NOTFOUND)
+      code_ = updater->update(found, &bytes, &write);
+    string stored = bytes;
+    if (ok() && write && log_value(key_bytes, &stored)) {
+      memset(&value, 0, sizeof(DBT));
+      value.data = const_cast<char*>(stored.data());
+      value.size = stored.size();
+      value.ulen = stored.size();
+      value.flags = DB_DBT_USERMEM;
+      code_ = database_->put(database_, transaction, &key, &value, 0);
+    }
+    if (ok() && transaction) {
+      code_ = transaction->commit(transaction, 0);
+      transaction = NULL;
+    }
+    if (ok()) {
+      cache_.erase(key_bytes);
+      if (result)
+        result->swap(bytes);
+      return true;
+    }
+    if (transaction)
+      transaction->abort(transaction);
+    if (code_ != DB_LOCK_DEADLOCK)
+      return false;
+  }
+  return false;
+}
+
+bool Database::update(const string& key_bytes,
+                      RecordUpdater* updater,
+                      string* result) {
+  error_detail_.clear();
+  if (database_->get_transactional(database_))
+    return update_record(key_bytes, updater, result);
+  DB_ENV* environment = database_->get_env(database_);
+  uint32_t environment_flags = 0;
+  code_ = environment->get_open_flags(environment, &environment_flags);
+  if (!ok()) return false;
+  if (!(environment_flags & (DB_INIT_LOCK | DB_INIT_CDB))) {
+    // Without a lock region nothing else writes through this handle unless
+    // it is free-threaded, where background writers would interleave.
+    if (is_threaded()) {
+      code_ = EINVAL;
+      return false;
+    }
+    return update_record(key_bytes, updater, result);
+  }
+  // Updates serialize on a write lock of the file, the database name and
+  // the key in the lock region, shared by every process of the environment.
+  DB_MPOOLFILE* mpf = database_->get_mpf(database_);
+  uint8_t file_id[DB_FILE_ID_LEN];
+  code_ = mpf->get_fileid(mpf, file_id);
+  if (!ok()) return false;
+  const char* filename = NULL;
+  const char* name = NULL;
+  code_ = database_->get_dbname(database_, &filename, &name);
+  if (!ok()) return false;
+  string object(reinterpret_cast<char*>(file_id), DB_FILE_ID_LEN);
+  if (name)
+    object.append(name);
+  object.push_back('\0');
+  object.append(key_bytes);
+  DBT lock_object;
+  memset(&lock_object, 0, sizeof(DBT));
+  lock_object.data = const_cast<char*>(object.data());
+  lock_object.size = object.size();
+  uint32_t locker = 0;
+  code_ = environment->lock_id(environment, &locker);
+  if (!ok()) return false;
+  DB_LOCK lock;
+  code_ = environment->lock_get(environment,
+                                locker,
+                                0,
+                                &lock_object,
+                                DB_LOCK_WRITE,
+                                &lock);
+  if (ok()) {
+    update_record(key_bytes, updater, result);
+    int code = code_;
+    int put_code = environment->lock_put(environment, &lock);
+    code_ = (code != 0) ? code : put_code;
+  }
+  int free_code = environment->lock_id_free(environment, locker);
+  if (ok())
+    code_ = free_code;
+  return ok();
+}
+
+bool Database::incr(const mxArray* key, double delta, mxArray** value) {
+  IncrementUpdater updater(delta);
+  string bytes;
+  if (!update(encode_key(key), &updater, &bytes))
+    return false;
+  Record record;
+  record.assign(string(), bytes);
+  record.get_value(value);
+  return true;
+}
+
+bool Database::append_to(const mxArray* key,
+                         const mxArray* values,
+                         int* length) {
+  string encoded;
+  if (!Record::encode_native(values, &encoded))
+    ERROR("Values must be a real numeric, logical or char array.");
+  AppendUpdater updater(encoded);
+  string bytes;
+  if (!update(encode_key(key), &updater, &bytes))
+    return false;
+  NativeHeader header;
+  Record::read_native_header(bytes.data(), bytes.size(), &header);
+  *length = static_cast<int>(header.rows * header.columns);
+  return true;
+}
+
+bool Database::cas(const mxArray* key,
+                   const mxArray* expected,
+                   const mxArray* value,
+                   bool* swapped) {
+  string expected_native, expected_compressed, new_value;
+  Record::encode_native(expected, &expected_native);
+  Record::encode_value(expected, &expected_compressed);
+  if (!native_values_ || !Record::encode_native(value, &new_value))
+    Record::encode_value(value, &new_value);
+  CompareAndSwapUpdater updater(mxIsEmpty(expected),
+                                expected_native,
+                                expected_compressed,
+                                new_value);
+  if (!update(encode_key(key), &updater, NULL))
+    return false;
+  *swapped = updater.swapped();
+  return true;
+}
+
 
 } // namespace bdbmex
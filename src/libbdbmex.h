@@ -10,15 +10,46 @@
 #include <mex.h>
 #include <string>
 #include <vector>
+#include "async.h"
+#include "checkpoint.h"
+#include "dump.h"
 #include "mex/session.h"
+#include "prefetch.h"
+#include "sorter.h"
+#include "value_cache.h"
 
 using namespace std;
 
 /// Alias for the mex error function.
 #define ERROR(...) mexErrMsgIdAndTxt("bdb:error", __VA_ARGS__)
 
+/// Heap databases are available since Berkeley DB 5.2.
+#if DB_VERSION_MAJOR > 5 || (DB_VERSION_MAJOR == 5 && DB_VERSION_MINOR >= 2)
+#define HAVE_DB_HEAP
+#endif
+
 namespace bdbmex {
 
+class ValueLog;
+
+/// Header of a value in the native codec, followed by the raw elements in
+/// column-major order. The magic and the sentinel never appear in the size
+/// header of a compressed value.
+struct NativeHeader {
+  /// Magic bytes 0xFF 'N' 'A' 'T'.
+  uint8_t magic[4];
+  /// mxClassID of the elements.
+  uint8_t class_id;
+  /// Reserved, zero.
+  uint8_t reserved[2];
+  /// Sentinel byte 0xFF.
+  uint8_t sentinel;
+  /// Number of rows.
+  uint64_t rows;
+  /// Number of columns.
+  uint64_t columns;
+};
+
 /// Database record consisting of (key, value) pair of DBT struct.
 class Record {
 public:
@@ -26,8 +57,9 @@ public:
   Record();
   /// Construct a new record for retrieval.
   Record(const mxArray* key);
-  /// Construct a new record for store.
-  Record(const mxArray* key, const mxArray* value);
+  /// Construct a new record for store. When native is set, real 2-D numeric,
+  /// logical and char values are stored uncompressed in the native codec.
+  Record(const mxArray* key, const mxArray* value, bool native = false);
   virtual ~Record();
   /// Get key.
   void get_key(mxArray** key);
@@ -37,6 +69,57 @@ public:
   DBT* key() { return &key_; }
   /// Mutable value.
   DBT* value() { return &value_; }
+  /// Encoded key bytes.
+  string key_bytes() const {
+    return string(static_cast<const char*>(key_.data), key_.size);
+  }
+  /// Copy raw key and value bytes into a record for cursor operation.
+  void assign(const string& key, const string& value);
+  /// Encode a value into stored bytes without a key.
+  static void encode_value(const mxArray* value, string* bytes);
+  /// Decode stored bytes of a value without raising an error. Pointer
+  /// records are resolved from the value log unless it is NULL. Return
+  /// false and set the error message on failure.
+  static bool decode_value(const void* data,
+                           size_t size,
+                           ValueLog* value_log,
+                           mxArray** value,
+                           string* error_message);
+  /// Encode a value in the native codec. Return false if the value is not
+  /// a real 2-D numeric, logical or char array.
+  static bool encode_native(const mxArray* value, string* bytes);
+  /// Return if stored bytes are in the native codec.
+  static bool is_native(const void* data, size_t size);
+  /// Read the header of stored bytes in the native codec. Return false if
+  /// the bytes are not native.
+  static bool read_native_header(const void* data,
+                                 size_t size,
+                                 NativeHeader* header);
+  /// Size in bytes of an element of the class, or 0 if not supported.
+  static size_t native_element_size(mxClassID class_id);
+  /// Create an uninitialized array of the native header.
+  static mxArray* create_native_array(const NativeHeader& header);
+  /// Fill a native header of the class and size.
+  static void make_native_header(mxClassID class_id,
+                                 uint64_t rows,
+                                 uint64_t columns,
+                                 NativeHeader* header);
+  /// Replace the key with a record number of a queue or recno database, or
+  /// a record id [pgno, indx] of a heap database.
+  void set_native_key(const mxArray* key, DBTYPE type);
+  /// Prepare the key to receive a record number or id assigned by append.
+  void set_append_key(DBTYPE type);
+  /// Decode keys of the database type from now on.
+  void set_key_type(DBTYPE type) { key_type_ = type; }
+  /// Resolve pointer records from the value log when decoding values.
+  void set_value_log(ValueLog* value_log) { value_log_ = value_log; }
+  /// Replace the value of a record for store with encoded bytes.
+  void set_value_bytes(const string& bytes);
+  /// Never read values into a record for cursor operation.
+  void set_keys_only();
+  /// Return if keys of the database type are record numbers or ids rather
+  /// than serialized arrays.
+  static bool has_native_keys(DBTYPE type);
 
 private:
   /// Reset the record.
@@ -44,20 +127,26 @@ private:
   /// Set key.
   void set_key(const mxArray* key);
   /// Set value.
-  void set_value(const mxArray* value);
+  void set_value(const mxArray* value, bool native);
   /// Serialize an mxArray.
   void serialize_mxarray(const mxArray* value, vector<uint8_t>* binary);
-  /// Deserialize an mxArray.
-  void deserialize_mxarray(const vector<uint8_t>& binary, mxArray** value);
+  /// Deserialize an mxArray. Return an error message or NULL.
+  static const char* deserialize_mxarray(const vector<uint8_t>& binary,
+                                         mxArray** value);
   /// Serialize and compress an mxArray.
   void compress_mxarray(const mxArray* value, vector<uint8_t>* binary);
-  /// Decompress and deserialize mxArray.
-  void decompress_mxarray(const vector<uint8_t>& binary, mxArray** value);
+  /// Decompress and deserialize mxArray. Return an error message or NULL.
+  static const char* decompress_mxarray(const vector<uint8_t>& binary,
+                                        mxArray** value);
 
   /// Key or the record.
   DBT key_;
   /// Value of the record.
   DBT value_;
+  /// Database type deciding the key encoding.
+  DBTYPE key_type_;
+  /// Value log of pointer records, or NULL.
+  ValueLog* value_log_;
   /// Temporary buffer for reference.
   vector<uint8_t> key_buffer_;
   /// Temporary buffer for reference.
@@ -68,11 +157,13 @@ private:
 class Cursor {
 public:
   /// Create an empty cursor.
-  Cursor() : cursor_(NULL), code_(0) {}
+  Cursor() : code_(0), cursor_(NULL), reader_(NULL) {}
   /// Destructor.
   virtual ~Cursor();
-  /// Open a new cursor.
-  int open(DB* database_);
+  /// Open a new cursor. When prefetch is positive, a background thread reads
+  /// up to that many records ahead and the cursor only moves forward. With
+  /// keys_only, values are never read from the database.
+  int open(DB* database_, int prefetch = 0, bool keys_only = false);
   /// Return the last error code.
   int error_code() const { return code_; }
   /// Return the last error message.
@@ -81,6 +172,8 @@ public:
   int next();
   /// Go to the previous record.
   int prev();
+  /// Go to the first record of the next key, skipping duplicates.
+  int next_nodup();
   /// Get the record.
   Record* get() { return &record_; }
 
@@ -91,6 +184,8 @@ private:
   Record record_;
   /// Cursor pointer.
   DBC* cursor_;
+  /// Background reader of a prefetch cursor, or NULL.
+  CursorReader* reader_;
 };
 
 /// Transaction.
@@ -118,6 +213,28 @@ private:
   DB_TXN* transaction_;
 };
 
+/// Tuning parameters of an environment. Zero means the Berkeley DB default.
+struct EnvironmentConfig {
+  EnvironmentConfig() : cache_size(0),
+                        cache_regions(0),
+                        mmap_size(0),
+                        log_buffer_size(0),
+                        log_auto_remove(false),
+                        checkpoint_interval(0) {}
+  /// Size of the shared memory buffer pool in bytes.
+  uint64_t cache_size;
+  /// Number of buffer pool regions.
+  int cache_regions;
+  /// Maximum file size to map into process memory in bytes.
+  size_t mmap_size;
+  /// Size of the in-memory log buffer in bytes.
+  uint32_t log_buffer_size;
+  /// Remove log files no longer needed after checkpoints.
+  bool log_auto_remove;
+  /// Seconds between background checkpoints.
+  double checkpoint_interval;
+};
+
 /// Database environment.
 class Environment {
 public:
@@ -126,8 +243,12 @@ public:
   /// Descructor.
   virtual ~Environment();
   /// Open an environment.
-  bool open(const string& home, uint32_t flags, int mode);
-  /// Close the environment.
+  bool open(const string& home,
+            uint32_t flags,
+            int mode,
+            const EnvironmentConfig& config);
+  /// Close the environment. An error of the last background checkpoint is
+  /// returned after closing.
   bool close(uint32_t flags);
   /// Return if the status is okay.
   bool ok() const { return code_ == 0; }
@@ -139,12 +260,94 @@ public:
   bool txn_begin(uint32_t flags,
                  Transaction* parent,
                  Transaction* transaction);
+  /// Flush the buffer pool and write a checkpoint record to the log.
+  bool checkpoint(uint32_t kbytes, uint32_t minutes, uint32_t flags);
+  /// List log or database files for archival or removal.
+  bool log_archive(uint32_t flags, vector<string>* files);
+  /// Copy databases and logs to a directory without blocking writers. When
+  /// rate is positive, reading is throttled to the megabytes per second.
+  bool backup(const string& target, uint32_t flags, double rate);
+  /// Return buffer pool, lock, log and transaction statistics, and the
+  /// state of the background checkpoint.
+  bool stat(uint32_t flags, mxArray** output);
+  /// Return subsystem statistics of any environment handle, including the
+  /// private environment of a standalone database.
+  static int stat(DB_ENV* environment, uint32_t flags, mxArray** output);
+  /// Record a range of pages preloaded into the buffer pool.
+  void add_warm_pages(const string& filename,
+                      const string& file_id,
+                      uint32_t page_size,
+                      db_pgno_t first,
+                      db_pgno_t last);
+  /// Save the list of preloaded pages to a file.
+  bool save_warm_list(const string& path);
+  /// Preload pages listed in a file in sequential file order.
+  bool load_warm_list(const string& path, int* num_pages);
 
 private:
+  /// Pages of a database file preloaded into the buffer pool.
+  struct WarmFile {
+    /// Unique file id in the buffer pool.
+    string file_id;
+    /// Page size of the file.
+    uint32_t page_size;
+    /// Inclusive ranges of page numbers.
+    vector<pair<db_pgno_t, db_pgno_t> > pages;
+  };
+  /// Sort and merge page ranges.
+  static void merge_pages(vector<pair<db_pgno_t, db_pgno_t> >* pages);
+
   /// Last return code.
   int code_;
   /// Environment C object.
   DB_ENV* environment_;
+  /// Background checkpoint thread, or NULL.
+  Checkpointer* checkpointer_;
+  /// Preloaded pages keyed by database file name.
+  map<string, WarmFile> warm_files_;
+};
+
+/// Tuning parameters of a database. Zero means the Berkeley DB default.
+struct DatabaseConfig {
+  DatabaseConfig() : cache_size(0),
+                     page_size(0),
+                     hash_nelem(0),
+                     hash_ffactor(0),
+                     duplicates(0),
+                     record_length(0),
+                     record_pad(-1),
+                     extent_size(0),
+                     heap_size(0) {}
+  /// Size of the private buffer pool in bytes. Only for a database opened
+  /// outside of an environment.
+  uint64_t cache_size;
+  /// Page size in bytes.
+  uint32_t page_size;
+  /// Estimated number of elements in a hash table.
+  uint32_t hash_nelem;
+  /// Desired density within a hash bucket.
+  uint32_t hash_ffactor;
+  /// Allow duplicate keys, either DB_DUP or DB_DUPSORT for sorted order.
+  uint32_t duplicates;
+  /// Fixed record length in bytes of a queue or recno database.
+  uint32_t record_length;
+  /// Pad byte of fixed-length records, or negative for the default.
+  int record_pad;
+  /// Number of pages in a queue extent file.
+  uint32_t extent_size;
+  /// Maximum size of a heap database file in bytes.
+  uint64_t heap_size;
+};
+
+/// Modification of a stored value in Database::update. It runs inside the
+/// write transaction and must not raise matlab errors.
+class RecordUpdater {
+public:
+  /// Destructor.
+  virtual ~RecordUpdater() {}
+  /// Modify the stored bytes, which are empty when the key is not found.
+  /// Set write to store the bytes. Return 0 or an error code.
+  virtual int update(bool found, string* bytes, bool* write) = 0;
 };
 
 /// Database connection.
@@ -161,7 +364,8 @@ public:
             uint32_t flags,
             int mode,
             Environment* environment,
-            Transaction* transaction);
+            Transaction* transaction,
+            const DatabaseConfig& config);
   /// Close the connection.
   bool close(uint32_t flags);
   /// Return the last error code.
@@ -170,20 +374,53 @@ public:
   const char* error_message() const;
   /// Return if the status is okay.
   bool ok() const { return code_ == 0; }
+  /// Get mutable pointer.
+  DB* handle() { return database_; }
+  /// Access method of the database.
+  DBTYPE type() const { return type_; }
+  /// Encode a key in the format of the access method.
+  string encode_key(const mxArray* key);
   /// Get an entry.
   bool get(const mxArray* key,
            uint32_t flags,
            mxArray** value,
            Transaction* transaction);
-  /// Put an entry.
+  /// Put an entry. With DB_APPEND, the assigned key is returned when
+  /// new_key is not NULL.
   bool put(const mxArray* key,
            const mxArray* value,
            uint32_t flags,
-           Transaction* transaction);
+           Transaction* transaction,
+           mxArray** new_key = NULL);
+  /// Put a stream manifest, dropping chunk records of the key except those
+  /// under the generation prefix to keep.
+  bool put_manifest(const mxArray* key,
+                    const mxArray* value,
+                    const string& keep);
+  /// Get count elements from a zero-based element offset of a native value
+  /// into a column vector, transferring only the requested bytes.
+  bool get_range(const mxArray* key,
+                 uint64_t offset,
+                 uint64_t count,
+                 Transaction* transaction,
+                 mxArray** value);
+  /// Overwrite elements of a native value from a zero-based element offset,
+  /// transferring only the given bytes. The class must match and the
+  /// elements must lie within the value.
+  bool put_at(const mxArray* key,
+              const mxArray* elements,
+              uint64_t offset,
+              Transaction* transaction);
   /// Delete an entry.
   bool del(const mxArray* key,
            uint32_t flags,
            Transaction* transaction);
+  /// Get all duplicate values of a key in bulk.
+  bool get_all(const mxArray* key,
+               Transaction* transaction,
+               mxArray** values);
+  /// Count duplicate values of a key. Zero when the key is not found.
+  bool count(const mxArray* key, Transaction* transaction, int* count);
   /// Check if the entry exists.
   bool exists(const mxArray* key,
               uint32_t flags,
@@ -199,15 +436,189 @@ public:
   bool compact(uint32_t flags,
                DB_COMPACT* compact_data,
                Transaction* transaction);
-  /// Create a new cursor.
-  bool cursor(Cursor* cursor);
+  /// Create a new cursor, optionally reading ahead in the background or
+  /// skipping values.
+  bool cursor(Cursor* cursor, int prefetch, bool keys_only = false);
+  /// Return statistics of the environment the database belongs to.
+  bool env_stat(uint32_t flags, mxArray** output);
+  /// Sample record sizes and recommend the page and cache geometry.
+  bool advise(int samples, double working_set, mxArray** output);
+  /// Preload pages into the buffer pool in sequential file order.
+  bool warm(bool full, int max_pages, int* num_pages);
+  /// Store records of cell arrays of keys and values in key order, sorting
+  /// on disk when the encoded records exceed the memory limit in bytes.
+  bool bulk_load(const mxArray* keys,
+                 const mxArray* values,
+                 size_t memory_limit,
+                 int* num_records);
+  /// Write all records to a dump file without decoding them.
+  bool export_dump(const string& filename, bool compress, int* num_records);
+  /// Store all records of a dump file without decoding them.
+  bool import_dump(const string& filename, int* num_records);
+  /// Append a cell array of values to a queue or recno database in one
+  /// transaction and return the assigned record numbers.
+  bool append(const mxArray* values,
+              Transaction* transaction,
+              mxArray** recnos);
+  /// Remove and return up to the given number of records from the head of a
+  /// queue database. When wait is set, block until at least one record is
+  /// available. Record numbers may be NULL.
+  bool consume(int count,
+               bool wait,
+               Transaction* transaction,
+               mxArray** values,
+               mxArray** recnos);
+  /// Fetch records of the keys in a background thread without decoding.
+  /// The keys are either a cell array of keys or a single key.
+  bool prefetch(const mxArray* keys);
+  /// Return if the handle is free-threaded.
+  bool is_threaded();
+  /// Queue a get in the background. The handle must be free-threaded.
+  bool get_async(const mxArray* key, AsyncOperation* operation);
+  /// Queue a put in the background. The handle must be free-threaded.
+  bool put_async(const mxArray* key,
+                 const mxArray* value,
+                 AsyncOperation* operation);
+  /// Queue gets of a cell array of keys in the background. The handle must
+  /// be free-threaded.
+  bool mget_async(const mxArray* keys, AsyncOperation* operation);
+  /// Open a secondary index keyed by a field of struct values and associate
+  /// it with this database. An empty filename is derived from the primary.
+  bool create_index(const string& field,
+                    const string& filename,
+                    Database* index);
+  /// Primary database of a secondary index, or NULL.
+  Database* primary() { return primary_; }
+  /// Find primary records of an index whose field value is between lower
+  /// and upper, or equal to lower when upper is NULL. Keys may be NULL.
+  bool get_by(const mxArray* lower,
+              const mxArray* upper,
+              mxArray** values,
+              mxArray** keys);
+  /// Find records of this database whose indexed fields equal all of the
+  /// given values, one for each index. Keys may be NULL.
+  bool join(const vector<Database*>& indexes,
+            const vector<const mxArray*>& index_values,
+            uint32_t flags,
+            mxArray** values,
+            mxArray** keys);
+  /// Encode a field value into an index key. Real scalars and char rows keep
+  /// their natural order; other values are only comparable for equality.
+  /// Return false if the value cannot be serialized.
+  static bool encode_index_key(const mxArray* value, string* key);
+  /// Set the capacity of the decoded value cache in bytes. Zero disables.
+  void set_value_cache_size(size_t size) { cache_.set_capacity(size); }
+  /// Store supported values in the native codec.
+  void set_native_values(bool native) { native_values_ = native; }
+  /// Companion database of stream chunks, opened on demand. Without create,
+  /// return NULL if the companion does not exist.
+  DB* stream_store(bool create);
+  /// Store values larger than the threshold in bytes in a value log next to
+  /// the database file. Only for btree and hash databases without duplicates.
+  bool set_value_log(size_t threshold, uint64_t segment_size);
+  /// Value log of the database, or NULL.
+  ValueLog* value_log() { return value_log_; }
+  /// Rewrite live values of value log segments having at least the given
+  /// ratio of dead bytes to the head segment and delete the segments.
+  bool collect_value_log(double min_garbage,
+                         int* num_segments,
+                         uint64_t* reclaimed);
+  /// Atomically add delta to every element of a native numeric value and
+  /// return the new value. A missing key starts from a double zero.
+  bool incr(const mxArray* key, double delta, mxArray** value);
+  /// Atomically append elements to a native vector value and return the
+  /// new number of elements. A missing key is created.
+  bool append_to(const mxArray* key, const mxArray* values, int* length);
+  /// Atomically replace the value only if it equals the expected value. An
+  /// empty expected value matches a missing key.
+  bool cas(const mxArray* key,
+           const mxArray* expected,
+           const mxArray* value,
+           bool* swapped);
+  /// Read, modify and write a record in one transaction, retrying on
+  /// deadlock. Without transactions, the update holds a write lock of the
+  /// key in the lock region, and a free-threaded handle of an environment
+  /// without locking is refused. The updated bytes are returned when result
+  /// is not NULL.
+  bool update(const string& key_bytes,
+              RecordUpdater* updater,
+              string* result);
 
 private:
+  /// Read, modify and write a record, in a transaction if the handle is
+  /// transactional, without locking the key.
+  bool update_record(const string& key_bytes,
+                     RecordUpdater* updater,
+                     string* result);
+  /// Put an entry and drop chunk records of the key except those under the
+  /// generation prefix to keep.
+  bool put_record(const mxArray* key,
+                  const mxArray* value,
+                  uint32_t flags,
+                  Transaction* transaction,
+                  mxArray** new_key,
+                  const string& keep);
+  /// Invalidate cached values affected by a write.
+  void invalidate(Record* record, uint32_t flags);
+  /// Append encoded value bytes larger than the threshold to the value log
+  /// and replace them with a pointer record. The log is flushed to disk
+  /// unless sync is false, in which case the caller must flush it before the
+  /// pointer is stored.
+  bool log_value(const string& key_bytes, string* bytes, bool sync = true);
+  /// Replace a pointer record with the value bytes from the value log.
+  bool resolve_value(string* bytes);
+  /// Read a whole native value logged under the key into bytes and its
+  /// header. Fail with EINVAL when the value is not a logged native array.
+  bool read_logged_native(DB_TXN* transaction,
+                          DBT* key,
+                          uint32_t flags,
+                          string* bytes,
+                          NativeHeader* header);
+  /// Find the meta page of the database in its file.
+  bool find_meta_page(db_pgno_t* meta_pgno);
+  /// Queue an operation to the thread pool.
+  bool submit(AsyncOperation* operation);
+  /// Secondary key callback of DB->associate.
+  static int extract_index_key(DB* secondary,
+                               const DBT* key,
+                               const DBT* data,
+                               DBT* result);
 
   /// Last return code.
   int code_;
   /// DB C object.
   DB* database_;
+  /// Access method of the open database.
+  DBTYPE type_;
+  /// Environment of the database, or NULL.
+  Environment* environment_;
+  /// Background prefetcher, created on demand.
+  Prefetcher* prefetcher_;
+  /// Workers of asynchronous operations, created on demand.
+  ThreadPool* pool_;
+  /// Number of unfinished asynchronous writes.
+  Counter pending_writes_;
+  /// Primary database of a secondary index, or NULL.
+  Database* primary_;
+  /// Indexed struct field of a secondary index.
+  string index_field_;
+  /// Detail of the error of the last operation, reported for EINVAL, e.g.,
+  /// the failure of the secondary key callback in a write to a primary.
+  string error_detail_;
+  /// Number of open secondary indices of a primary.
+  int num_indexes_;
+  /// Decoded value cache.
+  ValueCache cache_;
+  /// Store supported values in the native codec.
+  bool native_values_;
+  /// Companion database of stream chunks, or NULL.
+  Database* streams_;
+  /// Whether a missing companion database has been looked for.
+  bool streams_checked_;
+  /// Value log of large values, or NULL.
+  ValueLog* value_log_;
+  /// Size in bytes above which values go to the value log.
+  size_t value_log_threshold_;
 };
 
 } // namespace bdbmex
@@ -215,6 +626,7 @@ private:
 namespace mex {
 
 // Template instanciations.
+extern template class Session<bdbmex::AsyncOperation>;
 extern template class Session<bdbmex::Cursor>;
 extern template class Session<bdbmex::Database>;
 extern template class Session<bdbmex::Environment>;
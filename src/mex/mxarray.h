@@ -333,50 +333,62 @@ void MxArray::toVector(std::vector<T>* values) const {
     case mxCHAR_CLASS: {
       mxChar* data = mxGetChars(array_);
       values->assign(data, data + num_elements);
+      break;
     }
     case mxDOUBLE_CLASS: {
       double* data = mxGetPr(array_);
       values->assign(data, data + num_elements);
+      break;
     }
     case mxINT8_CLASS: {
       int8_t* data = reinterpret_cast<int8_t*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     case mxUINT8_CLASS: {
       uint8_t* data = reinterpret_cast<uint8_t*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     case mxINT16_CLASS: {
       int16_t* data = reinterpret_cast<int16_t*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     case mxUINT16_CLASS: {
       uint16_t* data = reinterpret_cast<uint16_t*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     case mxINT32_CLASS: {
       int32_t* data = reinterpret_cast<int32_t*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     case mxUINT32_CLASS: {
       uint32_t* data = reinterpret_cast<uint32_t*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     case mxINT64_CLASS: {
       int64_t* data = reinterpret_cast<int64_t*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     case mxUINT64_CLASS: {
       uint64_t* data = reinterpret_cast<uint64_t*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     case mxSINGLE_CLASS: {
       float* data = reinterpret_cast<float*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     case mxLOGICAL_CLASS: {
       mxLogical* data = reinterpret_cast<mxLogical*>(mxGetData(array_));
       values->assign(data, data + num_elements);
+      break;
     }
     default: {
       mexErrMsgIdAndTxt("mxarray:error",
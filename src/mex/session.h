@@ -5,73 +5,196 @@
 #ifndef __MEX_SESSION_H__
 #define __MEX_SESSION_H__
 
-#include <map>
 #include <mex.h>
+#include <vector>
 
 namespace mex {
 
 /// Session keeper useful to make a stateful API.
+///
+/// Instances live in a slot table with a free list. A session id encodes the
+/// slot index and a generation counter of the slot, so that lookup is O(1)
+/// and an id of a destroyed instance is never resolved to another instance
+/// that reuses the slot. A slot whose generation is exhausted is retired
+/// instead of wrapping around.
 template <typename T>
 class Session {
 public:
-  /// Create an instance.
-  static int create(T** instance);
-  /// Destroy an instance.
+  /// Create an instance. A hidden instance never becomes the default one.
+  static int create(T** instance, bool hidden = false);
+  /// Destroy an instance. When special id=0 is specified, it destroys the
+  /// default instance. Unknown ids are ignored.
   static void destroy(int id);
   /// Retrieve an instance. When special id=0 is specified, it returns default
-  /// instance or NULL if there is no instance.
+  /// instance or NULL if there is no instance. The default instance is the
+  /// most recently created one that is not hidden.
   static T* get(int id);
-  /// Get session instances.
-  static const std::map<int, T>& get_const_instances();
+  /// Get ids of the open instances in creation order.
+  static void ids(std::vector<int>* session_ids);
 
 private:
+  /// Number of bits in the id used for the slot index.
+  enum { kIndexBits = 20 };
+  /// Mask of the slot index in the id.
+  enum { kIndexMask = (1 << kIndexBits) - 1 };
+  /// Maximum value of the generation counter.
+  enum { kMaxGeneration = (1 << (30 - kIndexBits)) - 1 };
+  /// Slot of the instance table.
+  struct Slot {
+    /// Instance pointer, or NULL when the slot is free.
+    T* instance;
+    /// Generation counter incremented every time the slot is freed.
+    int generation;
+    /// Previous live slot in creation order.
+    int prev;
+    /// Next live slot in creation order.
+    int next;
+    /// Excluded from the default instance.
+    bool hidden;
+  };
+  /// Instance table.
+  struct Table {
+    Table() : head(-1), tail(-1) {}
+    ~Table();
+    /// Slot storage.
+    std::vector<Slot> slots;
+    /// Free slot indices.
+    std::vector<int> free_slots;
+    /// Oldest live slot.
+    int head;
+    /// Newest live slot.
+    int tail;
+  };
   /// Constructor prohibited.
   Session() {}
   ~Session() {}
   /// Instance storage.
-  static std::map<int, T>* get_instances();
+  static Table* get_table();
+  /// Find a slot index of the id, or -1 if the id is not valid.
+  static int find(const Table& table, int id);
+  /// Find the slot index of the default instance, or -1 if none.
+  static int find_default(const Table& table);
+  /// Encode a slot into an id.
+  static int encode(const Table& table, int index) {
+    return (table.slots[index].generation << kIndexBits) | (index + 1);
+  }
 };
 
 template <typename T>
-int Session<T>::create(T** instance) {
-  std::map<int, T>* instances = get_instances();
-  int id = (instances->empty()) ? 0 : instances->rbegin()->first;
-  T* instance_ptr = &(*instances)[++id];
+int Session<T>::create(T** instance, bool hidden) {
+  Table* table = get_table();
+  int index;
+  if (table->free_slots.empty()) {
+    if (table->slots.size() >= kIndexMask)
+      mexErrMsgIdAndTxt("mex:sessionError", "Too many open instances.");
+    Slot slot = {NULL, 1, -1, -1, false};
+    index = table->slots.size();
+    table->slots.push_back(slot);
+  }
+  else {
+    index = table->free_slots.back();
+    table->free_slots.pop_back();
+  }
+  Slot& slot = table->slots[index];
+  slot.instance = new T();
+  slot.prev = table->tail;
+  slot.next = -1;
+  slot.hidden = hidden;
+  if (table->tail >= 0)
+    table->slots[table->tail].next = index;
+  else
+    table->head = index;
+  table->tail = index;
   if (instance != NULL)
-    *instance = instance_ptr;
-  return id;
+    *instance = slot.instance;
+  return encode(*table, index);
 }
 
 template <typename T>
 void Session<T>::destroy(int id) {
-  std::map<int, T>* instances = get_instances();
-  id = (id == 0 && !instances->empty()) ? instances->rbegin()->first : id;
-  instances->erase(id);
+  Table* table = get_table();
+  int index = (id == 0) ? find_default(*table) : find(*table, id);
+  if (index < 0)
+    return;
+  Slot& slot = table->slots[index];
+  T* instance = slot.instance;
+  if (slot.prev >= 0)
+    table->slots[slot.prev].next = slot.next;
+  else
+    table->head = slot.next;
+  if (slot.next >= 0)
+    table->slots[slot.next].prev = slot.prev;
+  else
+    table->tail = slot.prev;
+  slot.instance = NULL;
+  slot.prev = -1;
+  slot.next = -1;
+  // Reusing the slot after the last generation would alias stale ids.
+  if (slot.generation < kMaxGeneration) {
+    ++slot.generation;
+    table->free_slots.push_back(index);
+  }
+  delete instance;
 }
 
 template <typename T>
 T* Session<T>::get(int id) {
-  std::map<int, T>* instances = get_instances();
-  if (id == 0)
-    return (instances->empty()) ? NULL : &instances->rbegin()->second;
-  typename std::map<int, T>::iterator instance = instances->find(id);
-  if (instance == instances->end())
+  Table* table = get_table();
+  if (id == 0) {
+    int index = find_default(*table);
+    return (index < 0) ? NULL : table->slots[index].instance;
+  }
+  int index = find(*table, id);
+  if (index < 0)
     mexErrMsgIdAndTxt("mex:instanceNotFound",
                       "Invalid id %d. Did you open?", id);
-  return &instance->second;
+  return table->slots[index].instance;
+}
+
+template <typename T>
+void Session<T>::ids(std::vector<int>* session_ids) {
+  const Table& table = *get_table();
+  session_ids->clear();
+  for (int index = table.head; index >= 0; index = table.slots[index].next)
+    session_ids->push_back(encode(table, index));
+}
+
+template <typename T>
+int Session<T>::find(const Table& table, int id) {
+  int index = (id & kIndexMask) - 1;
+  if (id <= 0 || index < 0 || index >= static_cast<int>(table.slots.size()))
+    return -1;
+  const Slot& slot = table.slots[index];
+  if (slot.instance == NULL || slot.generation != (id >> kIndexBits))
+    return -1;
+  return index;
+}
+
+template <typename T>
+int Session<T>::find_default(const Table& table) {
+  int index = table.tail;
+  while (index >= 0 && table.slots[index].hidden)
+    index = table.slots[index].prev;
+  return index;
 }
 
 template <typename T>
-const std::map<int, T>& Session<T>::get_const_instances() {
-  return *get_instances();
+Session<T>::Table::~Table() {
+  while (tail >= 0) {
+    Slot& slot = slots[tail];
+    T* instance = slot.instance;
+    tail = slot.prev;
+    slot.instance = NULL;
+    delete instance;
+  }
 }
 
 template <typename T>
-std::map<int, T>* Session<T>::get_instances() {
-  static std::map<int, T> instances;
-  return &instances;
+typename Session<T>::Table* Session<T>::get_table() {
+  static Table table;
+  return &table;
 }
 
 } // namespace mex
 
-#endif // __MEX_SESSION_H__
\ No newline at end of file
+#endif // __MEX_SESSION_H__
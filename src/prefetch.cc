@@ -0,0 +1,147 @@
+/// Background page and cursor prefetchers for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "prefetch.h"
+#include <cstdlib>
+#include <cstring>
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace bdbmex {
+
+Prefetcher::Prefetcher(DB* database) : database_(database),
+                                       stopping_(false) {}
+
+Prefetcher::~Prefetcher() {
+  {
+    MutexLock lock(&mutex_);
+    stopping_ = true;
+    keys_.clear();
+    condition_.broadcast();
+  }
+  join();
+}
+
+bool Prefetcher::push(const vector<string>& keys) {
+  {
+    MutexLock lock(&mutex_);
+    keys_.insert(keys_.end(), keys.begin(), keys.end());
+    condition_.signal();
+  }
+  return start();
+}
+
+void Prefetcher::run() {
+  DB_ENV* environment = database_->get_env(database_);
+  uint32_t environment_flags = 0;
+  environment->get_open_flags(environment, &environment_flags);
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.flags = DB_DBT_USERMEM;
+  value.flags = DB_DBT_REALLOC;
+  while (true) {
+    string key_bytes;
+    {
+      MutexLock lock(&mutex_);
+      while (keys_.empty() && !stopping_)
+        condition_.wait(&mutex_);
+      if (stopping_)
+        break;
+      key_bytes = keys_.front();
+      keys_.pop_front();
+    }
+    key.data = const_cast<char*>(key_bytes.data());
+    key.size = key_bytes.size();
+    key.ulen = key_bytes.size();
+    // Never wait for locks held by the matlab thread; the key is skipped.
+    DB_TXN* transaction = NULL;
+    if ((environment_flags & DB_INIT_TXN) &&
+        environment->txn_begin(environment,
+                               NULL,
+                               &transaction,
+                               DB_TXN_NOWAIT | DB_READ_COMMITTED) != 0)
+      continue;
+    database_->get(database_, transaction, &key, &value, 0);
+    if (transaction)
+      transaction->commit(transaction, 0);
+  }
+  if (value.data)
+    free(value.data);
+}
+
+CursorReader::CursorReader(DBC* cursor, size_t capacity, bool keys_only) :
+    cursor_(cursor),
+    capacity_((capacity > 0) ? capacity : 1),
+    keys_only_(keys_only),
+    code_(0),
+    finished_(false),
+    stopping_(false) {}
+
+CursorReader::~CursorReader() {
+  {
+    MutexLock lock(&mutex_);
+    stopping_ = true;
+    writable_.broadcast();
+  }
+  join();
+}
+
+int CursorReader::pop(string* key, string* value) {
+  MutexLock lock(&mutex_);
+  while (records_.empty() && !finished_)
+    readable_.wait(&mutex_);
+  if (records_.empty())
+    return code_;
+  key->swap(records_.front().first);
+  value->swap(records_.front().second);
+  records_.pop_front();
+  writable_.signal();
+  return 0;
+}
+
+void CursorReader::run() {
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.flags = DB_DBT_REALLOC;
+  value.flags = DB_DBT_REALLOC;
+  if (keys_only_) {
+    // Skip reading values.
+    value.flags |= DB_DBT_PARTIAL;
+    value.dlen = 0;
+  }
+  while (true) {
+    {
+      MutexLock lock(&mutex_);
+      while (records_.size() >= capacity_ && !stopping_)
+        writable_.wait(&mutex_);
+      if (stopping_)
+        break;
+    }
+    int code = cursor_->get(cursor_, &key, &value, DB_NEXT);
+    MutexLock lock(&mutex_);
+    if (code != 0) {
+      code_ = code;
+      break;
+    }
+    records_.push_back(pair<string, string>(
+        string(static_cast<const char*>(key.data), key.size),
+        string(static_cast<const char*>(value.data), value.size)));
+    readable_.signal();
+  }
+  {
+    MutexLock lock(&mutex_);
+    finished_ = true;
+    readable_.broadcast();
+  }
+  if (key.data)
+    free(key.data);
+  if (value.data)
+    free(value.data);
+}
+
+} // namespace bdbmex
@@ -0,0 +1,88 @@
+/// Background page and cursor prefetchers for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __PREFETCH_H__
+#define __PREFETCH_H__
+
+#include <db.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "thread.h"
+
+namespace bdbmex {
+
+/// Background reader that fetches records of queued keys without decoding
+/// them, so that the pages are in the buffer pool when the keys are read
+/// later. The database handle must be opened with DB_THREAD.
+class Prefetcher : public Thread {
+public:
+  /// Create a prefetcher for the database handle.
+  explicit Prefetcher(DB* database);
+  /// Stop the thread and drop the pending keys.
+  virtual ~Prefetcher();
+  /// Queue encoded keys and start the thread if necessary.
+  bool push(const std::vector<std::string>& keys);
+
+protected:
+  /// Fetch queued keys until stopped.
+  virtual void run();
+
+private:
+  /// Database handle.
+  DB* database_;
+  /// Lock of the queue.
+  Mutex mutex_;
+  /// Signaled when keys are queued or the thread is stopped.
+  Condition condition_;
+  /// Queue of encoded keys.
+  std::deque<std::string> keys_;
+  /// Stop flag.
+  bool stopping_;
+};
+
+/// Background reader that advances a cursor ahead of the caller and keeps
+/// the raw bytes of the next records in a bounded buffer. The reader owns the
+/// cursor until it is destroyed.
+class CursorReader : public Thread {
+public:
+  /// Create a reader of the cursor buffering at most capacity records. With
+  /// keys_only, values are never read and buffered as empty.
+  CursorReader(DBC* cursor, size_t capacity, bool keys_only = false);
+  /// Cancel reading and join the thread.
+  virtual ~CursorReader();
+  /// Take the next record, blocking until it is read. Return 0 on success,
+  /// or the code that stopped the cursor such as DB_NOTFOUND.
+  int pop(std::string* key, std::string* value);
+
+protected:
+  /// Read records until the end, an error, or cancellation.
+  virtual void run();
+
+private:
+  /// Cursor handle.
+  DBC* cursor_;
+  /// Maximum number of buffered records.
+  size_t capacity_;
+  /// Skip values.
+  bool keys_only_;
+  /// Lock of the buffer.
+  Mutex mutex_;
+  /// Signaled when a record is read or reading ends.
+  Condition readable_;
+  /// Signaled when a record is taken or reading is cancelled.
+  Condition writable_;
+  /// Buffered records in cursor order.
+  std::deque<std::pair<std::string, std::string> > records_;
+  /// Code that stopped the cursor.
+  int code_;
+  /// Set when no more records will be read.
+  bool finished_;
+  /// Cancel flag.
+  bool stopping_;
+};
+
+} // namespace bdbmex
+
+#endif // __PREFETCH_H__
@@ -0,0 +1,72 @@
+/// Database sequence for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "sequence.h"
+#include <cerrno>
+#include <cstring>
+
+namespace mex {
+
+template class Session<bdbmex::Sequence>;
+
+}
+
+namespace bdbmex {
+
+Sequence::Sequence() : code_(0), sequence_(NULL), database_(NULL) {}
+
+Sequence::~Sequence() {
+  close();
+}
+
+bool Sequence::open(Database* database,
+                    const string& key_bytes,
+                    uint32_t flags,
+                    int32_t cache_size,
+                    db_seq_t initial_value,
+                    Transaction* transaction) {
+  database_ = database;
+  key_bytes_ = key_bytes;
+  code_ = db_sequence_create(&sequence_, database->handle(), 0);
+  if (!ok()) return false;
+  code_ = sequence_->initial_value(sequence_, initial_value);
+  if (!ok()) return false;
+  if (cache_size > 0) {
+    code_ = sequence_->set_cachesize(sequence_, cache_size);
+    if (!ok()) return false;
+  }
+  DBT key;
+  memset(&key, 0, sizeof(DBT));
+  key.data = const_cast<char*>(key_bytes_.data());
+  key.size = key_bytes_.size();
+  key.ulen = key_bytes_.size();
+  key.flags = DB_DBT_USERMEM;
+  code_ = sequence_->open(sequence_,
+                          (transaction == NULL) ? NULL : transaction->get(),
+                          &key,
+                          flags);
+  return ok();
+}
+
+bool Sequence::close() {
+  if (sequence_) {
+    code_ = sequence_->close(sequence_, 0);
+    sequence_ = NULL;
+  }
+  database_ = NULL;
+  return ok();
+}
+
+bool Sequence::next(int32_t count, db_seq_t* value) {
+  if (count <= 0) {
+    code_ = EINVAL;
+    return false;
+  }
+  // A cached handle must not be used inside a transaction. The sequence
+  // record is updated in its own transaction when the cache runs out.
+  code_ = sequence_->get(sequence_, NULL, count, value, 0);
+  return ok();
+}
+
+} // namespace bdbmex
@@ -0,0 +1,64 @@
+/// Database sequence for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __SEQUENCE_H__
+#define __SEQUENCE_H__
+
+#include "libbdbmex.h"
+
+namespace bdbmex {
+
+/// Persistent integer sequence stored as a record of a database. A handle
+/// with a cache reserves a block of values at once, so that most calls do
+/// not touch the database.
+class Sequence {
+public:
+  /// Create an empty sequence.
+  Sequence();
+  /// Close the sequence.
+  virtual ~Sequence();
+  /// Open a sequence stored under the encoded key in the database. When
+  /// cache_size is positive, that many values are reserved per update.
+  bool open(Database* database,
+            const string& key_bytes,
+            uint32_t flags,
+            int32_t cache_size,
+            db_seq_t initial_value,
+            Transaction* transaction);
+  /// Close the sequence.
+  bool close();
+  /// Return if the status is okay.
+  bool ok() const { return code_ == 0; }
+  /// Return the last error message.
+  const char* error_message() const { return db_strerror(code_); }
+  /// Database of the sequence.
+  Database* database() { return database_; }
+  /// Reserve count consecutive values and return the first one.
+  bool next(int32_t count, db_seq_t* value);
+
+private:
+  /// Copy prohibited.
+  Sequence(const Sequence&);
+  Sequence& operator=(const Sequence&);
+
+  /// Last return code.
+  int code_;
+  /// Sequence C object.
+  DB_SEQUENCE* sequence_;
+  /// Database of the sequence.
+  Database* database_;
+  /// Encoded key of the sequence record.
+  string key_bytes_;
+};
+
+} // namespace bdbmex
+
+namespace mex {
+
+// Template instanciations.
+extern template class Session<bdbmex::Sequence>;
+
+}
+
+#endif // __SEQUENCE_H__
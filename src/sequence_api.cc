@@ -0,0 +1,109 @@
+/// Berkeley DB sequence mex interface.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "sequence.h"
+#include "mex/arguments.h"
+#include "mex/function.h"
+#include "mex/mxarray.h"
+
+using bdbmex::Database;
+using bdbmex::Record;
+using bdbmex::Sequence;
+using bdbmex::Transaction;
+using mex::CheckInputArguments;
+using mex::CheckOutputArguments;
+using mex::MxArray;
+using mex::Session;
+using mex::VariableInputArguments;
+
+namespace {
+
+/// Get a sequence from the id argument.
+Sequence* GetSequence(const mxArray* id) {
+  Sequence* sequence = Session<Sequence>::get(MxArray(id).toInt());
+  if (!sequence)
+    ERROR("No open sequence found.");
+  return sequence;
+}
+
+MEX_FUNCTION(sequence_open) (int nlhs,
+                             mxArray *plhs[],
+                             int nrhs,
+                             const mxArray *prhs[]) {
+  CheckInputArguments(1, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Transaction", 0);
+  options.set("CacheSize",   0);
+  options.set("Initial",     0);
+  options.set("Create",      true);
+  options.set("Excl",        false);
+  Database* database = NULL;
+  MxArray name;
+  if (nrhs == 1 || !MxArray(prhs[0]).isNumeric()) {
+    database = Session<Database>::get(0);
+    name.reset(prhs[0]);
+    options.update(prhs + 1, prhs + nrhs);
+  }
+  else {
+    database = Session<Database>::get(MxArray(prhs[0]).toInt());
+    name.reset(prhs[1]);
+    options.update(prhs + 2, prhs + nrhs);
+  }
+  if (!database)
+    ERROR("No open database found.");
+  Transaction* transaction = Session<Transaction>::get(
+      options["Transaction"].toInt());
+  uint32_t flags =
+      (options["Create"].toBool() ? DB_CREATE : 0) |
+      (options["Excl"].toBool()   ? DB_EXCL : 0) |
+      (database->is_threaded()    ? DB_THREAD : 0);
+  Sequence* sequence = NULL;
+  int sequence_id = Session<Sequence>::create(&sequence);
+  if (!sequence->open(database,
+                      Record(name.get()).key_bytes(),
+                      flags,
+                      options["CacheSize"].toInt(),
+                      static_cast<db_seq_t>(options["Initial"].toDouble()),
+                      transaction)) {
+    const char* error_message = sequence->error_message();
+    Session<Sequence>::destroy(sequence_id);
+    ERROR("Failed to open a sequence: %s", error_message);
+  }
+  plhs[0] = MxArray(sequence_id).getMutable();
+}
+
+MEX_FUNCTION(sequence_next) (int nlhs,
+                             mxArray *plhs[],
+                             int nrhs,
+                             const mxArray *prhs[]) {
+  CheckInputArguments(1, 2, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  Sequence* sequence = GetSequence(prhs[0]);
+  int count = (nrhs > 1) ? MxArray(prhs[1]).toInt() : 1;
+  db_seq_t first = 0;
+  if (!sequence->next(count, &first))
+    ERROR("Failed to get a sequence value: %s", sequence->error_message());
+  plhs[0] = mxCreateNumericMatrix(count, 1, mxINT64_CLASS, mxREAL);
+  int64_t* values = static_cast<int64_t*>(mxGetData(plhs[0]));
+  for (int i = 0; i < count; ++i)
+    values[i] = first + i;
+}
+
+MEX_FUNCTION(sequence_close) (int nlhs,
+                              mxArray *plhs[],
+                              int nrhs,
+                              const mxArray *prhs[]) {
+  CheckInputArguments(1, 1, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  int sequence_id = MxArray(prhs[0]).toInt();
+  Sequence* sequence = GetSequence(prhs[0]);
+  bool success = sequence->close();
+  const char* error_message = sequence->error_message();
+  Session<Sequence>::destroy(sequence_id);
+  if (!success)
+    ERROR("Failed to close a sequence: %s", error_message);
+}
+
+} // namespace
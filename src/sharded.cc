@@ -0,0 +1,417 @@
+/// Sharded database for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "sharded.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace mex {
+
+template class Session<bdbmex::ShardedDatabase>;
+
+}
+
+namespace bdbmex {
+
+/// Maximum number of worker threads of parallel operations.
+static const int kMaxShardThreads = 8;
+
+/// 32-bit FNV-1a hash of encoded key bytes.
+static uint32_t fnv1a_hash(const string& data) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < data.size(); ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/// Replace the %d conversion in a pattern with the index. Only a flag 0 and
+/// a width are allowed, e.g., %d or %03d. Return false on invalid pattern.
+static bool format_shard_name(const string& pattern,
+                              int index,
+                              string* filename) {
+  size_t start = pattern.find('%');
+  if (start == string::npos || pattern.find('%', start + 1) != string::npos)
+    return false;
+  size_t end = start + 1;
+  while (end < pattern.size() && isdigit(pattern[end]))
+    ++end;
+  if (end >= pattern.size() || pattern[end] != 'd' || end - start > 4)
+    return false;
+  char number[32];
+  snprintf(number, sizeof(number),
+           pattern.substr(start, end - start + 1).c_str(), index);
+  *filename = pattern.substr(0, start) + number + pattern.substr(end + 1);
+  return true;
+}
+
+/// Task reading every record of a database as raw bytes.
+class ScanTask : public Task {
+public:
+  /// Create a scan of the database.
+  ScanTask(DB* database, bool keys_only) : database_(database),
+                                           keys_only_(keys_only),
+                                           code_(0) {}
+  /// Read all records.
+  virtual void run() {
+    DBC* cursor = NULL;
+    code_ = database_->cursor(database_, NULL, &cursor, 0);
+    if (code_ != 0)
+      return;
+    DBT key, value;
+    memset(&key, 0, sizeof(DBT));
+    memset(&value, 0, sizeof(DBT));
+    key.flags = DB_DBT_REALLOC;
+    value.flags = DB_DBT_REALLOC;
+    if (keys_only_) {
+      // Skip reading values.
+      value.flags |= DB_DBT_PARTIAL;
+      value.dlen = 0;
+    }
+    while ((code_ = cursor->get(cursor, &key, &value, DB_NEXT)) == 0)
+      records_.push_back(pair<string, string>(
+          string(static_cast<const char*>(key.data), key.size),
+          (keys_only_) ?
+              string() :
+              string(static_cast<const char*>(value.data), value.size)));
+    if (code_ == DB_NOTFOUND)
+      code_ = 0;
+    cursor->close(cursor);
+    if (key.data)
+      free(key.data);
+    if (value.data)
+      free(value.data);
+  }
+  /// Records in cursor order.
+  vector<pair<string, string> >* records() { return &records_; }
+  /// Return code of the scan.
+  int error_code() const { return code_; }
+
+private:
+  /// Database handle.
+  DB* database_;
+  /// Skip values.
+  bool keys_only_;
+  /// Retrieved records.
+  vector<pair<string, string> > records_;
+  /// Return code.
+  int code_;
+};
+
+/// Tasks deleted when leaving the scope, even if decoding raises an error.
+/// Tasks must be finished or never queued by then.
+template <typename T>
+class TaskList {
+public:
+  /// Create an empty list.
+  TaskList() {}
+  /// Delete the tasks.
+  ~TaskList() {
+    for (size_t i = 0; i < tasks_.size(); ++i)
+      delete tasks_[i];
+  }
+  /// Take ownership of a task.
+  void push_back(T* task) { tasks_.push_back(task); }
+  /// Number of tasks.
+  size_t size() const { return tasks_.size(); }
+  /// The i-th task.
+  T* operator[](size_t i) { return tasks_[i]; }
+
+private:
+  /// Copy prohibited.
+  TaskList(const TaskList&);
+  TaskList& operator=(const TaskList&);
+
+  /// Tasks.
+  vector<T*> tasks_;
+};
+
+/// Order of records by key in the access method. Record numbers compare as
+/// integers, and other keys in the default btree order.
+class RecordLess {
+public:
+  /// Create an order of the access method.
+  explicit RecordLess(DBTYPE type) : type_(type) {}
+  /// Compare records.
+  bool operator()(const pair<string, string>& a,
+                  const pair<string, string>& b) const {
+    if ((type_ == DB_RECNO || type_ == DB_QUEUE) &&
+        a.first.size() == sizeof(db_recno_t) &&
+        b.first.size() == sizeof(db_recno_t)) {
+      db_recno_t a_recno = 0, b_recno = 0;
+      memcpy(&a_recno, a.first.data(), sizeof(db_recno_t));
+      memcpy(&b_recno, b.first.data(), sizeof(db_recno_t));
+      return a_recno < b_recno;
+    }
+    return RecordSorter::compare(a.first, b.first) < 0;
+  }
+
+private:
+  /// Access method.
+  DBTYPE type_;
+};
+
+/// Head record of a shard being merged.
+struct ScanHead {
+  /// Current record.
+  const pair<string, string>* record;
+  /// Shard index.
+  size_t shard;
+};
+
+/// Order of heads for a min-heap.
+class ScanHeadGreater {
+public:
+  /// Create an order of the access method.
+  explicit ScanHeadGreater(DBTYPE type) : less_(type) {}
+  /// Compare heads.
+  bool operator()(const ScanHead& a, const ScanHead& b) const {
+    return less_(*b.record, *a.record);
+  }
+
+private:
+  /// Order of records.
+  RecordLess less_;
+};
+
+ShardedDatabase::ShardedDatabase() : code_(0), pool_(NULL) {}
+
+ShardedDatabase::~ShardedDatabase() {
+  close(0);
+}
+
+bool ShardedDatabase::open(const string& pattern,
+                           int num_shards,
+                           DBTYPE type,
+                           uint32_t flags,
+                           int mode,
+                           Environment* environment,
+                           const DatabaseConfig& config) {
+  if (num_shards <= 0)
+    ERROR("Number of shards must be positive: %d", num_shards);
+  for (int i = 0; i < num_shards; ++i) {
+    string filename;
+    if (!format_shard_name(pattern, i, &filename))
+      ERROR("Invalid filename pattern: %s", pattern.c_str());
+    Database* database = new Database();
+    shards_.push_back(database);
+    if (!database->open(filename,
+                        "",
+                        type,
+                        flags | DB_THREAD,
+                        mode,
+                        environment,
+                        NULL,
+                        config)) {
+      code_ = database->error_code();
+      return false;
+    }
+  }
+  code_ = 0;
+  return ok();
+}
+
+bool ShardedDatabase::close(uint32_t flags) {
+  delete pool_;
+  pool_ = NULL;
+  code_ = 0;
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    if (!shards_[i]->close(flags) && ok())
+      code_ = shards_[i]->error_code();
+    delete shards_[i];
+  }
+  shards_.clear();
+  return ok();
+}
+
+bool ShardedDatabase::set_value_log(size_t threshold,
+                                    uint64_t segment_size) {
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    if (!shards_[i]->set_value_log(threshold, segment_size)) {
+      code_ = shards_[i]->error_code();
+      return false;
+    }
+  }
+  code_ = 0;
+  return true;
+}
+
+string ShardedDatabase::encode_key(const mxArray* key) {
+  if (shards_.empty())
+    ERROR("No open shard found.");
+  return shards_[0]->encode_key(key);
+}
+
+Database* ShardedDatabase::route(const string& key_bytes) {
+  if (shards_.empty())
+    ERROR("No open shard found.");
+  return shards_[fnv1a_hash(key_bytes) % shards_.size()];
+}
+
+bool ShardedDatabase::get(const mxArray* key, mxArray** value) {
+  Database* database = route(encode_key(key));
+  *value = NULL;
+  bool success = database->get(key, 0, value, NULL);
+  code_ = database->error_code();
+  return success;
+}
+
+bool ShardedDatabase::put(const mxArray* key, const mxArray* value) {
+  Database* database = route(encode_key(key));
+  bool success = database->put(key, value, 0, NULL);
+  code_ = database->error_code();
+  return success;
+}
+
+bool ShardedDatabase::del(const mxArray* key) {
+  Database* database = route(encode_key(key));
+  bool success = database->del(key, 0, NULL);
+  code_ = database->error_code();
+  return success;
+}
+
+bool ShardedDatabase::mget(const mxArray* keys, mxArray** values) {
+  if (!mxIsCell(keys))
+    ERROR("Keys must be a cell array.");
+  if (pool_ == NULL)
+    pool_ = new ThreadPool(min<int>(shards_.size(), kMaxShardThreads));
+  size_t num_keys = mxGetNumberOfElements(keys);
+  TaskList<AsyncOperation> operations;
+  vector<vector<size_t> > positions(shards_.size());
+  for (size_t i = 0; i < shards_.size(); ++i)
+    operations.push_back(new AsyncOperation());
+  for (size_t i = 0; i < num_keys; ++i) {
+    string key_bytes = encode_key(mxGetCell(keys, i));
+    size_t shard = fnv1a_hash(key_bytes) % shards_.size();
+    if (positions[shard].empty())
+      operations[shard]->reset(shards_[shard]->handle(),
+                               AsyncOperation::MGET,
+                               NULL);
+    operations[shard]->add(key_bytes, string());
+    positions[shard].push_back(i);
+  }
+  code_ = 0;
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    if (positions[i].empty())
+      continue;
+    operations[i]->submit();
+    if (!pool_->push(operations[i]))
+      operations[i]->fail(EAGAIN);
+  }
+  // Every operation finishes before decoding, which may raise an error.
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    operations[i]->wait();
+    if (operations[i]->error_code() != 0 && ok())
+      code_ = operations[i]->error_code();
+  }
+  if (!ok())
+    return false;
+  *values = mxCreateCellArray(mxGetNumberOfDimensions(keys),
+                              mxGetDimensions(keys));
+  if (*values == NULL)
+    ERROR("Null pointer exception.");
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    AsyncOperation* operation = operations[i];
+    for (size_t j = 0; j < positions[i].size(); ++j) {
+      mxArray* value = NULL;
+      if (operation->code(j) == DB_NOTFOUND)
+        value = mxCreateDoubleMatrix(0, 0, mxREAL);
+      else {
+        Record record;
+        record.assign(operation->key(j), operation->value(j));
+        record.set_value_log(shards_[i]->value_log());
+        record.get_value(&value);
+      }
+      mxSetCell(*values, positions[i][j], value);
+    }
+  }
+  return true;
+}
+
+bool ShardedDatabase::keys(bool ordered, mxArray** output) {
+  return scan(ordered, true, output);
+}
+
+bool ShardedDatabase::values(bool ordered, mxArray** output) {
+  return scan(ordered, false, output);
+}
+
+bool ShardedDatabase::scan(bool ordered, bool keys_only, mxArray** output) {
+  if (shards_.empty())
+    ERROR("No open shard found.");
+  if (pool_ == NULL)
+    pool_ = new ThreadPool(min<int>(shards_.size(), kMaxShardThreads));
+  DBTYPE type = shards_[0]->type();
+  TaskList<ScanTask> tasks;
+  for (size_t i = 0; i < shards_.size(); ++i)
+    tasks.push_back(new ScanTask(shards_[i]->handle(), keys_only));
+  code_ = 0;
+  for (size_t i = 0; i < tasks.size(); ++i)
+    if (!pool_->push(tasks[i]))
+      code_ = EAGAIN;
+  pool_->wait();
+  size_t num_records = 0;
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    if (tasks[i]->error_code() != 0 && ok())
+      code_ = tasks[i]->error_code();
+    num_records += tasks[i]->records()->size();
+  }
+  if (!ok())
+    return false;
+  *output = mxCreateCellMatrix(num_records, 1);
+  if (*output == NULL)
+    ERROR("Null pointer exception.");
+  // Merge the sorted shards through a heap of their heads, or concatenate
+  // them.
+  vector<ScanHead> heads;
+  ScanHeadGreater greater(type);
+  for (size_t i = 0; ordered && i < tasks.size(); ++i) {
+    std::stable_sort(tasks[i]->records()->begin(),
+                     tasks[i]->records()->end(),
+                     RecordLess(type));
+    if (tasks[i]->records()->empty())
+      continue;
+    ScanHead head;
+    head.record = &tasks[i]->records()->front();
+    head.shard = i;
+    heads.push_back(head);
+  }
+  std::make_heap(heads.begin(), heads.end(), greater);
+  vector<size_t> positions(tasks.size(), 0);
+  for (size_t index = 0, shard = 0; index < num_records; ++index) {
+    if (ordered) {
+      std::pop_heap(heads.begin(), heads.end(), greater);
+      shard = heads.back().shard;
+      if (positions[shard] + 1 < tasks[shard]->records()->size()) {
+        heads.back().record = &(*tasks[shard]->records())[positions[shard] + 1];
+        std::push_heap(heads.begin(), heads.end(), greater);
+      }
+      else
+        heads.pop_back();
+    }
+    else {
+      while (positions[shard] >= tasks[shard]->records()->size())
+        ++shard;
+    }
+    const pair<string, string>& entry =
+        (*tasks[shard]->records())[positions[shard]++];
+    Record record;
+    record.set_key_type(type);
+    record.assign(entry.first, entry.second);
+    record.set_value_log(shards_[shard]->value_log());
+    mxArray* element = NULL;
+    if (keys_only)
+      record.get_key(&element);
+    else
+      record.get_value(&element);
+    mxSetCell(*output, index, element);
+  }
+  return true;
+}
+
+} // namespace bdbmex
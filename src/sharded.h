@@ -0,0 +1,81 @@
+/// Sharded database for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __SHARDED_H__
+#define __SHARDED_H__
+
+#include "libbdbmex.h"
+
+namespace bdbmex {
+
+/// Set of databases over which records are hash-partitioned by encoded key.
+/// Every shard is opened free-threaded so that scans and multi-key reads run
+/// on all shards in parallel.
+class ShardedDatabase {
+public:
+  /// Create an empty set.
+  ShardedDatabase();
+  /// Close the shards.
+  virtual ~ShardedDatabase();
+  /// Open num_shards databases. The filename pattern contains a %d
+  /// conversion, e.g., data_%02d.bdb, replaced by the shard index from 0.
+  bool open(const string& pattern,
+            int num_shards,
+            DBTYPE type,
+            uint32_t flags,
+            int mode,
+            Environment* environment,
+            const DatabaseConfig& config);
+  /// Close the shards.
+  bool close(uint32_t flags);
+  /// Store values larger than the threshold in bytes in a value log of
+  /// every shard.
+  bool set_value_log(size_t threshold, uint64_t segment_size);
+  /// Return if the status is okay.
+  bool ok() const { return code_ == 0; }
+  /// Return the last error message.
+  const char* error_message() const { return db_strerror(code_); }
+  /// Number of shards.
+  int size() const { return shards_.size(); }
+  /// Get an entry.
+  bool get(const mxArray* key, mxArray** value);
+  /// Put an entry.
+  bool put(const mxArray* key, const mxArray* value);
+  /// Delete an entry.
+  bool del(const mxArray* key);
+  /// Get entries of a cell array of keys in parallel.
+  bool mget(const mxArray* keys, mxArray** values);
+  /// Dump keys of all shards scanned in parallel, optionally in key order.
+  bool keys(bool ordered, mxArray** output);
+  /// Dump values of all shards scanned in parallel, optionally in key order.
+  bool values(bool ordered, mxArray** output);
+
+private:
+  /// Copy prohibited.
+  ShardedDatabase(const ShardedDatabase&);
+  ShardedDatabase& operator=(const ShardedDatabase&);
+  /// Encode a key in the format of the access method of the shards.
+  string encode_key(const mxArray* key);
+  /// Shard of an encoded key.
+  Database* route(const string& key_bytes);
+  /// Scan all shards in parallel and decode keys or values.
+  bool scan(bool ordered, bool keys_only, mxArray** output);
+
+  /// Last return code.
+  int code_;
+  /// Shard databases.
+  vector<Database*> shards_;
+  /// Workers of parallel operations, created on demand.
+  ThreadPool* pool_;
+};
+
+} // namespace bdbmex
+
+namespace mex {
+
+extern template class Session<bdbmex::ShardedDatabase>;
+
+}
+
+#endif // __SHARDED_H__
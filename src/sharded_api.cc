@@ -0,0 +1,186 @@
+/// Berkeley DB sharded database mex interface.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "sharded.h"
+#include "mex/arguments.h"
+#include "mex/function.h"
+#include "mex/mxarray.h"
+
+using bdbmex::DatabaseConfig;
+using bdbmex::Environment;
+using bdbmex::ShardedDatabase;
+using mex::CheckInputArguments;
+using mex::CheckOutputArguments;
+using mex::MxArray;
+using mex::Session;
+using mex::VariableInputArguments;
+
+namespace {
+
+/// Get a sharded database from the id argument.
+ShardedDatabase* GetShardedDatabase(const mxArray* id) {
+  ShardedDatabase* database = Session<ShardedDatabase>::get(
+      MxArray(id).toInt());
+  if (!database)
+    ERROR("No open sharded database found.");
+  return database;
+}
+
+MEX_FUNCTION(open_sharded) (int nlhs,
+                            mxArray *plhs[],
+                            int nrhs,
+                            const mxArray *prhs[]) {
+  CheckInputArguments(2, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  string pattern(MxArray(prhs[0]).toString());
+  int num_shards = MxArray(prhs[1]).toInt();
+  VariableInputArguments options;
+  options.set("Environment", 0);
+  options.set("Type",        string("btree"));
+  options.set("AutoCommit",  true);
+  options.set("Create",      true);
+  options.set("Rdonly",      false);
+  options.set("Truncate",    false);
+  options.set("Mode",        0);
+  options.set("CacheSize",   0);
+  options.set("PageSize",    0);
+  options.set("HashNelem",   0);
+  options.set("HashFfactor", 0);
+  options.set("ValueLog",    0);
+  options.set("ValueLogSegmentSize", 64 * 1024 * 1024);
+  options.update(prhs + 2, prhs + nrhs);
+  Environment* environment = Session<Environment>::get(
+      options["Environment"].toInt());
+  string type_name = options["Type"].toString();
+  if (type_name != "btree" && type_name != "hash")
+    ERROR("Invalid type for sharding: %s", type_name.c_str());
+  DBTYPE type = (type_name == "btree") ? DB_BTREE : DB_HASH;
+  uint32_t flags =
+      ((options["AutoCommit"].toBool() && environment) ? DB_AUTO_COMMIT : 0) |
+      (options["Create"].toBool()   ? DB_CREATE : 0) |
+      (options["Rdonly"].toBool()   ? DB_RDONLY : 0) |
+      (options["Truncate"].toBool() ? DB_TRUNCATE : 0);
+  DatabaseConfig config;
+  config.cache_size = static_cast<uint64_t>(options["CacheSize"].toDouble());
+  config.page_size = options["PageSize"].toInt();
+  config.hash_nelem = options["HashNelem"].toInt();
+  config.hash_ffactor = options["HashFfactor"].toInt();
+  ShardedDatabase* database = NULL;
+  int database_id = Session<ShardedDatabase>::create(&database);
+  if (!database->open(pattern,
+                      num_shards,
+                      type,
+                      flags,
+                      options["Mode"].toInt(),
+                      environment,
+                      config)) {
+    const char* error_message = database->error_message();
+    Session<ShardedDatabase>::destroy(database_id);
+    ERROR("Failed to open shards at %s: %s", pattern.c_str(), error_message);
+  }
+  if (!database->set_value_log(
+          static_cast<size_t>(options["ValueLog"].toDouble()),
+          static_cast<uint64_t>(
+              options["ValueLogSegmentSize"].toDouble()))) {
+    const char* error_message = database->error_message();
+    Session<ShardedDatabase>::destroy(database_id);
+    ERROR("Failed to open value logs at %s: %s",
+          pattern.c_str(),
+          error_message);
+  }
+  plhs[0] = MxArray(database_id).getMutable();
+}
+
+MEX_FUNCTION(close_sharded) (int nlhs,
+                             mxArray *plhs[],
+                             int nrhs,
+                             const mxArray *prhs[]) {
+  CheckInputArguments(1, 3, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  VariableInputArguments options;
+  options.set("Nosync", false);
+  options.update(prhs + 1, prhs + nrhs);
+  int database_id = MxArray(prhs[0]).toInt();
+  ShardedDatabase* database = GetShardedDatabase(prhs[0]);
+  bool success = database->close(
+      options["Nosync"].toBool() ? DB_NOSYNC : 0);
+  const char* error_message = database->error_message();
+  Session<ShardedDatabase>::destroy(database_id);
+  if (!success)
+    ERROR("Failed to close shards: %s", error_message);
+}
+
+MEX_FUNCTION(sharded_get) (int nlhs,
+                           mxArray *plhs[],
+                           int nrhs,
+                           const mxArray *prhs[]) {
+  CheckInputArguments(2, 2, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  ShardedDatabase* database = GetShardedDatabase(prhs[0]);
+  if (!database->get(prhs[1], &plhs[0]))
+    ERROR("Failed to get an entry: %s", database->error_message());
+}
+
+MEX_FUNCTION(sharded_put) (int nlhs,
+                           mxArray *plhs[],
+                           int nrhs,
+                           const mxArray *prhs[]) {
+  CheckInputArguments(3, 3, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  ShardedDatabase* database = GetShardedDatabase(prhs[0]);
+  if (!database->put(prhs[1], prhs[2]))
+    ERROR("Failed to put an entry: %s", database->error_message());
+}
+
+MEX_FUNCTION(sharded_delete) (int nlhs,
+                              mxArray *plhs[],
+                              int nrhs,
+                              const mxArray *prhs[]) {
+  CheckInputArguments(2, 2, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  ShardedDatabase* database = GetShardedDatabase(prhs[0]);
+  if (!database->del(prhs[1]))
+    ERROR("Failed to delete an entry: %s", database->error_message());
+}
+
+MEX_FUNCTION(sharded_mget) (int nlhs,
+                            mxArray *plhs[],
+                            int nrhs,
+                            const mxArray *prhs[]) {
+  CheckInputArguments(2, 2, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  ShardedDatabase* database = GetShardedDatabase(prhs[0]);
+  if (!database->mget(prhs[1], &plhs[0]))
+    ERROR("Failed to get entries: %s", database->error_message());
+}
+
+MEX_FUNCTION(sharded_keys) (int nlhs,
+                            mxArray *plhs[],
+                            int nrhs,
+                            const mxArray *prhs[]) {
+  CheckInputArguments(1, 3, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Ordered", false);
+  options.update(prhs + 1, prhs + nrhs);
+  ShardedDatabase* database = GetShardedDatabase(prhs[0]);
+  if (!database->keys(options["Ordered"].toBool(), &plhs[0]))
+    ERROR("Failed to query keys: %s", database->error_message());
+}
+
+MEX_FUNCTION(sharded_values) (int nlhs,
+                              mxArray *plhs[],
+                              int nrhs,
+                              const mxArray *prhs[]) {
+  CheckInputArguments(1, 3, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("Ordered", false);
+  options.update(prhs + 1, prhs + nrhs);
+  ShardedDatabase* database = GetShardedDatabase(prhs[0]);
+  if (!database->values(options["Ordered"].toBool(), &plhs[0]))
+    ERROR("Failed to query values: %s", database->error_message());
+}
+
+} // namespace
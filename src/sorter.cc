@@ -0,0 +1,229 @@
+/// External record sorter for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "sorter.h"
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+
+using std::string;
+using std::vector;
+
+namespace bdbmex {
+
+/// Approximate bookkeeping bytes of a buffered record.
+static const size_t kEntryOverhead = 64;
+
+/// Stream buffer size of a run file.
+static const size_t kRunBufferSize = 1 << 20;
+
+/// Maximum number of runs merged at once.
+static const size_t kMaxFanIn = 64;
+
+/// Write a length-prefixed string.
+static bool write_string(FILE* file, const string& data) {
+  uint32_t size = data.size();
+  return fwrite(&size, sizeof(size), 1, file) == 1 &&
+         (size == 0 || fwrite(data.data(), size, 1, file) == 1);
+}
+
+/// Read a length-prefixed string.
+static bool read_string(FILE* file, string* data) {
+  uint32_t size = 0;
+  if (fread(&size, sizeof(size), 1, file) != 1)
+    return false;
+  data->resize(size);
+  return size == 0 || fread(&(*data)[0], size, 1, file) == 1;
+}
+
+/// Write a record with its insertion order.
+static bool write_record(FILE* file,
+                         const string& key,
+                         const string& value,
+                         uint64_t order) {
+  return fwrite(&order, sizeof(order), 1, file) == 1 &&
+         write_string(file, key) &&
+         write_string(file, value);
+}
+
+RecordSorter::RecordSorter(size_t memory_limit) :
+    memory_limit_(memory_limit),
+    memory_size_(0),
+    count_(0),
+    position_(0),
+    failed_(false) {}
+
+RecordSorter::~RecordSorter() {
+  for (size_t i = 0; i < runs_.size(); ++i)
+    fclose(runs_[i]);
+}
+
+bool RecordSorter::add(const string& key, const string& value) {
+  buffer_.push_back(Entry());
+  buffer_.back().key = key;
+  buffer_.back().value = value;
+  buffer_.back().order = count_++;
+  memory_size_ += key.size() + value.size() + kEntryOverhead;
+  return (memory_size_ > memory_limit_) ? spill() : true;
+}
+
+bool RecordSorter::finish() {
+  if (runs_.empty()) {
+    std::stable_sort(buffer_.begin(), buffer_.end(), less);
+    position_ = 0;
+    return true;
+  }
+  if (!buffer_.empty() && !spill())
+    return false;
+  while (runs_.size() > kMaxFanIn) {
+    if (!merge(runs_.size() - kMaxFanIn))
+      return false;
+  }
+  return start_merge(0, &heads_);
+}
+
+bool RecordSorter::next(string* key, string* value) {
+  if (runs_.empty()) {
+    if (position_ >= buffer_.size())
+      return false;
+    key->swap(buffer_[position_].key);
+    value->swap(buffer_[position_].value);
+    ++position_;
+    return true;
+  }
+  Entry entry;
+  int status = pop(&heads_, &entry);
+  if (status < 0)
+    failed_ = true;
+  if (status <= 0)
+    return false;
+  key->swap(entry.key);
+  value->swap(entry.value);
+  return true;
+}
+
+int RecordSorter::compare(const string& a, const string& b) {
+  size_t size = std::min(a.size(), b.size());
+  int result = (size > 0) ? memcmp(a.data(), b.data(), size) : 0;
+  if (result != 0)
+    return result;
+  return (a.size() < b.size()) ? -1 : (a.size() > b.size()) ? 1 : 0;
+}
+
+bool RecordSorter::less(const Entry& a, const Entry& b) {
+  int result = compare(a.key, b.key);
+  return (result != 0) ? result < 0 : a.order < b.order;
+}
+
+bool RecordSorter::greater(const Head& a, const Head& b) {
+  return less(b.entry, a.entry);
+}
+
+bool RecordSorter::spill() {
+  std::stable_sort(buffer_.begin(), buffer_.end(), less);
+  FILE* file = tmpfile();
+  if (file == NULL)
+    return false;
+  runs_.push_back(file);
+  levels_.push_back(0);
+  setvbuf(file, NULL, _IOFBF, kRunBufferSize);
+  for (size_t i = 0; i < buffer_.size(); ++i) {
+    if (!write_record(file,
+                      buffer_[i].key,
+                      buffer_[i].value,
+                      buffer_[i].order))
+      return false;
+  }
+  buffer_.clear();
+  memory_size_ = 0;
+  return fflush(file) == 0 && cascade();
+}
+
+bool RecordSorter::cascade() {
+  while (runs_.size() >= kMaxFanIn) {
+    size_t first = runs_.size() - kMaxFanIn;
+    if (levels_[first] != levels_.back())
+      break;
+    if (!merge(first))
+      return false;
+  }
+  return true;
+}
+
+bool RecordSorter::merge(size_t first) {
+  int level = levels_[first] + 1;
+  vector<Head> heads;
+  if (!start_merge(first, &heads))
+    return false;
+  FILE* file = tmpfile();
+  if (file == NULL)
+    return false;
+  setvbuf(file, NULL, _IOFBF, kRunBufferSize);
+  Entry entry;
+  int status = 0;
+  while ((status = pop(&heads, &entry)) > 0) {
+    if (!write_record(file, entry.key, entry.value, entry.order))
+      break;
+  }
+  if (status != 0 || fflush(file) != 0) {
+    fclose(file);
+    return false;
+  }
+  for (size_t i = first; i < runs_.size(); ++i)
+    fclose(runs_[i]);
+  runs_.resize(first);
+  levels_.resize(first);
+  runs_.push_back(file);
+  levels_.push_back(level);
+  return true;
+}
+
+bool RecordSorter::start_merge(size_t first, vector<Head>* heads) {
+  heads->clear();
+  for (size_t i = first; i < runs_.size(); ++i) {
+    rewind(runs_[i]);
+    Head head;
+    head.run = i;
+    int status = read(i, &head.entry);
+    if (status < 0)
+      return false;
+    if (status > 0)
+      heads->push_back(head);
+  }
+  std::make_heap(heads->begin(), heads->end(), greater);
+  return true;
+}
+
+int RecordSorter::pop(vector<Head>* heads, Entry* entry) {
+  if (heads->empty())
+    return 0;
+  std::pop_heap(heads->begin(), heads->end(), greater);
+  Head& head = heads->back();
+  entry->key.swap(head.entry.key);
+  entry->value.swap(head.entry.value);
+  entry->order = head.entry.order;
+  int status = read(head.run, &head.entry);
+  if (status < 0)
+    return -1;
+  if (status > 0)
+    std::push_heap(heads->begin(), heads->end(), greater);
+  else
+    heads->pop_back();
+  return 1;
+}
+
+int RecordSorter::read(size_t run, Entry* entry) {
+  FILE* file = runs_[run];
+  uint64_t order = 0;
+  size_t size = fread(&order, 1, sizeof(order), file);
+  if (size == 0 && feof(file) && !ferror(file))
+    return 0;
+  if (size != sizeof(order))
+    return -1;
+  entry->order = order;
+  return (read_string(file, &entry->key) &&
+          read_string(file, &entry->value)) ? 1 : -1;
+}
+
+} // namespace bdbmex
@@ -0,0 +1,95 @@
+/// External record sorter for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __SORTER_H__
+#define __SORTER_H__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace bdbmex {
+
+/// Sorts encoded records by key in the default btree order with bounded
+/// memory. Records beyond the memory limit are written to temporary files
+/// as sorted runs, which are merged when reading. Runs are merged into
+/// larger runs whenever the fan-in limit is reached, so that the number of
+/// open temporary files stays bounded. Records of equal keys are returned
+/// in insertion order.
+class RecordSorter {
+public:
+  /// Create a sorter keeping at most memory_limit bytes of records.
+  explicit RecordSorter(size_t memory_limit);
+  /// Close temporary files.
+  virtual ~RecordSorter();
+  /// Add a record. Return false on I/O error.
+  bool add(const std::string& key, const std::string& value);
+  /// Finish adding records and prepare reading. Return false on I/O error.
+  bool finish();
+  /// Read the next record in order. Return false at the end or on error.
+  bool next(std::string* key, std::string* value);
+  /// Return false if reading a temporary file failed.
+  bool ok() const { return !failed_; }
+  /// Number of runs written to temporary files.
+  size_t num_runs() const { return runs_.size(); }
+  /// Order of encoded keys in the default btree comparison.
+  static int compare(const std::string& a, const std::string& b);
+
+private:
+  /// Record in memory with its insertion order.
+  struct Entry {
+    std::string key;
+    std::string value;
+    size_t order;
+  };
+  /// Head record of a run being merged.
+  struct Head {
+    Entry entry;
+    size_t run;
+  };
+  /// Copy prohibited.
+  RecordSorter(const RecordSorter&);
+  RecordSorter& operator=(const RecordSorter&);
+  /// Strict weak ordering of entries.
+  static bool less(const Entry& a, const Entry& b);
+  /// Strict weak ordering of heads for a min-heap.
+  static bool greater(const Head& a, const Head& b);
+  /// Sort the buffer and write it to a new run.
+  bool spill();
+  /// Merge runs of the same level while the fan-in limit is reached.
+  bool cascade();
+  /// Merge the runs from the index to the end into a single run.
+  bool merge(size_t first);
+  /// Fill the heap with the head of each run.
+  bool start_merge(size_t first, std::vector<Head>* heads);
+  /// Pop the smallest head and refill it from its run. Return 1 on success,
+  /// 0 when the heap is empty, and -1 on error.
+  int pop(std::vector<Head>* heads, Entry* entry);
+  /// Read the next entry of a run. Return 1 on success, 0 at the end of the
+  /// run, and -1 on error.
+  int read(size_t run, Entry* entry);
+
+  /// Memory limit in bytes.
+  size_t memory_limit_;
+  /// Bytes of buffered records.
+  size_t memory_size_;
+  /// Number of added records.
+  size_t count_;
+  /// Buffered records.
+  std::vector<Entry> buffer_;
+  /// Position in the buffer when reading without runs.
+  size_t position_;
+  /// Temporary files of sorted runs.
+  std::vector<FILE*> runs_;
+  /// Merge level of each run. Levels do not increase along the runs.
+  std::vector<int> levels_;
+  /// Reading a run failed.
+  bool failed_;
+  /// Heap of run heads when merging.
+  std::vector<Head> heads_;
+};
+
+} // namespace bdbmex
+
+#endif // __SORTER_H__
@@ -0,0 +1,419 @@
+/// Chunked value stream for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "stream.h"
+#include "dump.h"
+#include "mex/mxarray.h"
+#include <cerrno>
+#include <cstring>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+using mex::MxArray;
+
+namespace mex {
+
+template class Session<bdbmex::Stream>;
+
+}
+
+namespace bdbmex {
+
+/// Size of the chunk record header.
+static const size_t kChunkHeaderSize = 16;
+
+/// Chunk flag of zlib compression.
+static const uint32_t kChunkCompressed = 1;
+
+/// Class names in the manifest.
+static const struct {
+  const char* name;
+  mxClassID class_id;
+} kClassNames[] = {
+  {"logical", mxLOGICAL_CLASS},
+  {"char",    mxCHAR_CLASS},
+  {"double",  mxDOUBLE_CLASS},
+  {"single",  mxSINGLE_CLASS},
+  {"int8",    mxINT8_CLASS},
+  {"uint8",   mxUINT8_CLASS},
+  {"int16",   mxINT16_CLASS},
+  {"uint16",  mxUINT16_CLASS},
+  {"int32",   mxINT32_CLASS},
+  {"uint32",  mxUINT32_CLASS},
+  {"int64",   mxINT64_CLASS},
+  {"uint64",  mxUINT64_CLASS}
+};
+
+mxClassID class_id_of(const string& name) {
+  for (size_t i = 0; i < sizeof(kClassNames) / sizeof(kClassNames[0]); ++i)
+    if (name == kClassNames[i].name)
+      return kClassNames[i].class_id;
+  return mxUNKNOWN_CLASS;
+}
+
+const char* class_name_of(mxClassID class_id) {
+  for (size_t i = 0; i < sizeof(kClassNames) / sizeof(kClassNames[0]); ++i)
+    if (class_id == kClassNames[i].class_id)
+      return kClassNames[i].name;
+  return "unknown";
+}
+
+/// Append a little-endian word.
+static void append_word(uint64_t value, int bytes, string* output) {
+  for (int i = 0; i < bytes; ++i)
+    output->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+/// Read a little-endian word.
+static uint64_t read_word(const string& input, size_t offset, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; ++i)
+    value |= static_cast<uint64_t>(
+        static_cast<uint8_t>(input[offset + i])) << (8 * i);
+  return value;
+}
+
+void encode_chunk(const void* data, size_t size, string* chunk) {
+  chunk->clear();
+  append_word(size, 8, chunk);
+  append_word(crc32_checksum(data, size), 4, chunk);
+#ifdef ENABLE_ZLIB
+  uLongf compressed_size = compressBound(size);
+  chunk->resize(kChunkHeaderSize + compressed_size);
+  if (compress(reinterpret_cast<Bytef*>(&(*chunk)[kChunkHeaderSize]),
+               &compressed_size,
+               static_cast<const Bytef*>(data),
+               size) == Z_OK &&
+      compressed_size < size) {
+    chunk->resize(kChunkHeaderSize + compressed_size);
+    string flags;
+    append_word(kChunkCompressed, 4, &flags);
+    chunk->replace(12, 4, flags);
+    return;
+  }
+  chunk->resize(12);
+#endif
+  append_word(0, 4, chunk);
+  chunk->append(static_cast<const char*>(data), size);
+}
+
+bool decode_chunk(const string& chunk, string* data) {
+  if (chunk.size() < kChunkHeaderSize)
+    return false;
+  uint64_t size = read_word(chunk, 0, 8);
+  uint32_t checksum = static_cast<uint32_t>(read_word(chunk, 8, 4));
+  uint32_t flags = static_cast<uint32_t>(read_word(chunk, 12, 4));
+  if (flags & kChunkCompressed) {
+#ifdef ENABLE_ZLIB
+    data->resize(size);
+    uLongf actual_size = size;
+    if (uncompress(reinterpret_cast<Bytef*>(&(*data)[0]),
+                   &actual_size,
+                   reinterpret_cast<const Bytef*>(&chunk[kChunkHeaderSize]),
+                   chunk.size() - kChunkHeaderSize) != Z_OK ||
+        actual_size != size)
+      return false;
+#else
+    return false;
+#endif
+  }
+  else {
+    if (chunk.size() - kChunkHeaderSize != size)
+      return false;
+    data->assign(chunk, kChunkHeaderSize, string::npos);
+  }
+  return crc32_checksum(data->data(), data->size()) == checksum;
+}
+
+Stream::Stream() : code_(0),
+                   database_(NULL),
+                   store_(NULL),
+                   key_(NULL),
+                   generation_(0),
+                   write_(false),
+                   chunk_size_(0),
+                   class_id_(mxDOUBLE_CLASS),
+                   element_size_(sizeof(double)),
+                   num_elements_(0),
+                   position_(0),
+                   num_chunks_(0),
+                   chunk_index_(0),
+                   offset_(0) {}
+
+Stream::~Stream() {
+  if (key_)
+    mxDestroyArray(key_);
+}
+
+bool Stream::open(Database* database,
+                  const mxArray* key,
+                  bool write,
+                  size_t chunk_size) {
+  database_ = database;
+  write_ = write;
+  chunk_size_ = (chunk_size > 0) ? chunk_size : 1;
+  key_ = mxDuplicateArray(key);
+  if (key_ == NULL)
+    ERROR("Null pointer exception.");
+  mexMakeArrayPersistent(key_);
+  prefix_ = chunk_prefix(Record(key).key_bytes());
+  if (write_) {
+    store_ = database->stream_store(true);
+    if (store_ == NULL) {
+      code_ = database->error_code();
+      return false;
+    }
+    // Chunks go to the generation after the stored one, and the old value
+    // is left to readers until close.
+    mxArray* manifest = NULL;
+    if (!database->get(key, 0, &manifest, NULL)) {
+      code_ = database->error_code();
+      if (code_ != DB_NOTFOUND)
+        return false;
+      code_ = 0;
+    }
+    generation_ = 1;
+    if (manifest) {
+      MxArray manifest_array(manifest);
+      if (manifest_array.isStruct() &&
+          manifest_array.isField("stream") &&
+          manifest_array.isField("generation"))
+        generation_ += static_cast<uint64_t>(
+            manifest_array.at("generation").toDouble());
+      mxDestroyArray(manifest);
+    }
+    return true;
+  }
+  mxArray* manifest = NULL;
+  if (!database->get(key, 0, &manifest, NULL)) {
+    code_ = database->error_code();
+    return false;
+  }
+  MxArray manifest_array(manifest);
+  bool valid = manifest_array.isStruct() &&
+               manifest_array.isField("stream") &&
+               manifest_array.isField("class") &&
+               manifest_array.isField("numel") &&
+               manifest_array.isField("chunks");
+  if (valid) {
+    class_id_ = class_id_of(manifest_array.at("class").toString());
+    num_elements_ = static_cast<uint64_t>(
+        manifest_array.at("numel").toDouble());
+    num_chunks_ = static_cast<uint64_t>(
+        manifest_array.at("chunks").toDouble());
+    // Streams written before generations have none.
+    if (manifest_array.isField("generation"))
+      generation_ = static_cast<uint64_t>(
+          manifest_array.at("generation").toDouble());
+  }
+  mxDestroyArray(manifest);
+  if (!valid || class_id_ == mxUNKNOWN_CLASS) {
+    code_ = (database->error_code() == DB_NOTFOUND) ? DB_NOTFOUND : EINVAL;
+    return false;
+  }
+  element_size_ = Record::native_element_size(class_id_);
+  store_ = database->stream_store(false);
+  if (store_ == NULL && num_chunks_ > 0) {
+    code_ = ENOENT;
+    return false;
+  }
+  return true;
+}
+
+bool Stream::write(const mxArray* elements) {
+  if (!write_) {
+    code_ = EINVAL;
+    return false;
+  }
+  if (mxIsSparse(elements) || mxIsComplex(elements) ||
+      Record::native_element_size(mxGetClassID(elements)) == 0)
+    ERROR("Elements must be a real numeric, logical or char array.");
+  if (num_elements_ == 0 && buffer_.empty()) {
+    class_id_ = mxGetClassID(elements);
+    element_size_ = Record::native_element_size(class_id_);
+  }
+  else if (mxGetClassID(elements) != class_id_)
+    ERROR("Elements must be %s.", class_name_of(class_id_));
+  size_t num_elements = mxGetNumberOfElements(elements);
+  const char* data = static_cast<const char*>(mxGetData(elements));
+  size_t size = num_elements * element_size_;
+  size_t offset = 0;
+  while (offset < size) {
+    size_t length = min(size - offset, chunk_size_ - buffer_.size());
+    buffer_.append(data + offset, length);
+    offset += length;
+    if (buffer_.size() >= chunk_size_ && !flush(buffer_.size()))
+      return false;
+  }
+  num_elements_ += num_elements;
+  return true;
+}
+
+bool Stream::read(size_t count, mxArray** elements) {
+  if (write_) {
+    code_ = EINVAL;
+    return false;
+  }
+  uint64_t remaining = num_elements_ - position_;
+  size_t num_elements = static_cast<size_t>(min<uint64_t>(count, remaining));
+  NativeHeader header;
+  Record::make_native_header(class_id_, num_elements, 1, &header);
+  *elements = Record::create_native_array(header);
+  char* output = static_cast<char*>(mxGetData(*elements));
+  size_t size = num_elements * element_size_;
+  size_t copied = 0;
+  while (copied < size) {
+    if (offset_ >= buffer_.size() && !load()) {
+      mxDestroyArray(*elements);
+      *elements = NULL;
+      return false;
+    }
+    size_t length = min(size - copied, buffer_.size() - offset_);
+    memcpy(output + copied, &buffer_[offset_], length);
+    offset_ += length;
+    copied += length;
+  }
+  position_ += num_elements;
+  return true;
+}
+
+bool Stream::close() {
+  if (database_ == NULL)
+    return ok();
+  if (write_) {
+    if (!buffer_.empty() && !flush(buffer_.size()))
+      return false;
+    const char* kFields[] = {"stream", "class", "numel", "chunks",
+                             "chunk_size", "generation"};
+    MxArray manifest = MxArray::Struct(6, kFields);
+    manifest.set(kFields[0], true);
+    manifest.set(kFields[1], string(class_name_of(class_id_)));
+    manifest.set(kFields[2], static_cast<double>(num_elements_));
+    manifest.set(kFields[3], static_cast<double>(num_chunks_));
+    manifest.set(kFields[4], static_cast<double>(chunk_size_));
+    manifest.set(kFields[5], static_cast<double>(generation_));
+    // Chunks of the replaced value and of unclosed writes are garbage now.
+    bool success = database_->put_manifest(key_,
+                                           manifest.get(),
+                                           generation_prefix());
+    manifest.destroy();
+    if (!success) {
+      code_ = database_->error_code();
+      return false;
+    }
+  }
+  database_ = NULL;
+  store_ = NULL;
+  buffer_.clear();
+  return ok();
+}
+
+string Stream::chunk_prefix(const string& key_bytes) {
+  string prefix;
+  for (int i = 3; i >= 0; --i)
+    prefix.push_back(static_cast<char>((key_bytes.size() >> (8 * i)) & 0xFF));
+  prefix.append(key_bytes);
+  return prefix;
+}
+
+int Stream::remove_chunks(DB* store,
+                          DB_TXN* transaction,
+                          const string& prefix,
+                          const string& keep) {
+  DBC* cursor = NULL;
+  int code = store->cursor(store, transaction, &cursor, DB_WRITECURSOR);
+  if (code != 0)
+    return code;
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  // The key buffer is handed to Berkeley DB for reallocation.
+  key.data = malloc(prefix.size());
+  if (key.data == NULL) {
+    cursor->close(cursor);
+    return ENOMEM;
+  }
+  memcpy(key.data, prefix.data(), prefix.size());
+  key.size = prefix.size();
+  key.flags = DB_DBT_REALLOC;
+  // Chunk values are never read.
+  value.flags = DB_DBT_PARTIAL | DB_DBT_USERMEM;
+  code = cursor->get(cursor, &key, &value, DB_SET_RANGE);
+  while (code == 0 && key.size >= prefix.size() &&
+         memcmp(key.data, prefix.data(), prefix.size()) == 0) {
+    // A kept chunk key is the generation prefix and an 8-byte index.
+    bool kept = !keep.empty() && key.size == keep.size() + 8 &&
+                memcmp(key.data, keep.data(), keep.size()) == 0;
+    if (!kept)
+      code = cursor->del(cursor, 0);
+    if (code == 0)
+      code = cursor->get(cursor, &key, &value, DB_NEXT);
+  }
+  if (key.data)
+    free(key.data);
+  cursor->close(cursor);
+  return (code == DB_NOTFOUND) ? 0 : code;
+}
+
+string Stream::generation_prefix() const {
+  string prefix = prefix_;
+  if (generation_ > 0)
+    for (int i = 7; i >= 0; --i)
+      prefix.push_back(static_cast<char>((generation_ >> (8 * i)) & 0xFF));
+  return prefix;
+}
+
+string Stream::chunk_key(uint64_t index) const {
+  string key = generation_prefix();
+  for (int i = 7; i >= 0; --i)
+    key.push_back(static_cast<char>((index >> (8 * i)) & 0xFF));
+  return key;
+}
+
+bool Stream::flush(size_t size) {
+  string chunk;
+  encode_chunk(buffer_.data(), size, &chunk);
+  string key_bytes = chunk_key(chunk_index_);
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.data = const_cast<char*>(key_bytes.data());
+  key.size = key_bytes.size();
+  value.data = const_cast<char*>(chunk.data());
+  value.size = chunk.size();
+  code_ = store_->put(store_, NULL, &key, &value, 0);
+  if (!ok()) return false;
+  buffer_.erase(0, size);
+  ++chunk_index_;
+  ++num_chunks_;
+  return true;
+}
+
+bool Stream::load() {
+  if (chunk_index_ >= num_chunks_ || store_ == NULL) {
+    code_ = EINVAL;
+    return false;
+  }
+  string key_bytes = chunk_key(chunk_index_);
+  DBT key, value;
+  memset(&key, 0, sizeof(DBT));
+  memset(&value, 0, sizeof(DBT));
+  key.data = const_cast<char*>(key_bytes.data());
+  key.size = key_bytes.size();
+  value.flags = DB_DBT_MALLOC;
+  code_ = store_->get(store_, NULL, &key, &value, 0);
+  if (!ok()) return false;
+  string chunk(static_cast<const char*>(value.data), value.size);
+  free(value.data);
+  if (!decode_chunk(chunk, &buffer_)) {
+    code_ = EINVAL;
+    return false;
+  }
+  offset_ = 0;
+  ++chunk_index_;
+  return true;
+}
+
+} // namespace bdbmex
@@ -0,0 +1,127 @@
+/// Chunked value stream for Berkeley DB matlab driver.
+///
+/// A stream stores a long sequence of elements of one class as chunk records
+/// in a companion database of the primary, e.g., data.bdb.stream, so that
+/// neither writing nor reading holds more than one chunk in memory. Chunk
+/// keys are the length-prefixed encoded key of the stream followed by the
+/// big-endian generation and chunk index. The primary database keeps a
+/// manifest struct for the key, which is written when a write stream is
+/// closed. A write stream fills a new generation, so that the old value
+/// stays readable until the manifest is replaced and its chunks dropped.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __STREAM_H__
+#define __STREAM_H__
+
+#include "libbdbmex.h"
+
+namespace bdbmex {
+
+/// Encode raw bytes into a chunk record: the raw size, the CRC-32 of the raw
+/// bytes and flags, then the bytes, zlib-compressed when enabled. Safe to
+/// call from a background thread.
+void encode_chunk(const void* data, size_t size, string* chunk);
+
+/// Decode a chunk record into raw bytes. Return false if the record is
+/// corrupted. Safe to call from a background thread.
+bool decode_chunk(const string& chunk, string* data);
+
+/// Find a class id of the element class name, or mxUNKNOWN_CLASS.
+mxClassID class_id_of(const string& name);
+
+/// Find an element class name of the id.
+const char* class_name_of(mxClassID class_id);
+
+/// Sequential reader or writer of a chunked value.
+class Stream {
+public:
+  /// Create a closed stream.
+  Stream();
+  /// Close the stream. An unclosed write stream leaves the old value.
+  virtual ~Stream();
+  /// Open a stream of the key. A write stream buffers elements up to
+  /// chunk_size bytes per chunk record of a new generation.
+  bool open(Database* database,
+            const mxArray* key,
+            bool write,
+            size_t chunk_size);
+  /// Append elements of a real numeric, logical or char array.
+  bool write(const mxArray* elements);
+  /// Read up to count elements into a column vector. Empty at the end.
+  bool read(size_t count, mxArray** elements);
+  /// Flush a write stream, store the manifest and drop chunk records of
+  /// other generations.
+  bool close();
+  /// Return if the status is okay.
+  bool ok() const { return code_ == 0; }
+  /// Return the last error message.
+  const char* error_message() const { return db_strerror(code_); }
+  /// Database of the stream.
+  Database* database() { return database_; }
+  /// Key prefix of chunk records of an encoded key.
+  static string chunk_prefix(const string& key_bytes);
+  /// Delete chunk records of a key prefix from a companion database, except
+  /// those of the generation prefix to keep when it is not empty.
+  static int remove_chunks(DB* store,
+                           DB_TXN* transaction,
+                           const string& prefix,
+                           const string& keep = string());
+
+private:
+  /// Copy prohibited.
+  Stream(const Stream&);
+  Stream& operator=(const Stream&);
+  /// Key prefix of chunk records of the generation.
+  string generation_prefix() const;
+  /// Key of a chunk record.
+  string chunk_key(uint64_t index) const;
+  /// Store buffered bytes as a chunk record.
+  bool flush(size_t size);
+  /// Load the next chunk record into the buffer.
+  bool load();
+
+  /// Last return code.
+  int code_;
+  /// Primary database of the manifest.
+  Database* database_;
+  /// Companion database of chunk records.
+  DB* store_;
+  /// Key of the manifest.
+  mxArray* key_;
+  /// Length-prefixed encoded key.
+  string prefix_;
+  /// Generation of chunk records, or 0 for records without one.
+  uint64_t generation_;
+  /// Write mode flag.
+  bool write_;
+  /// Bytes per chunk record.
+  size_t chunk_size_;
+  /// Class of the elements.
+  mxClassID class_id_;
+  /// Bytes per element.
+  size_t element_size_;
+  /// Total number of elements.
+  uint64_t num_elements_;
+  /// Number of elements written or read.
+  uint64_t position_;
+  /// Number of chunk records.
+  uint64_t num_chunks_;
+  /// Index of the next chunk record to write or read.
+  uint64_t chunk_index_;
+  /// Unwritten or unread raw bytes.
+  string buffer_;
+  /// Offset of the unread bytes in the buffer.
+  size_t offset_;
+};
+
+} // namespace bdbmex
+
+namespace mex {
+
+// Template instanciations.
+extern template class Session<bdbmex::Stream>;
+
+}
+
+#endif // __STREAM_H__
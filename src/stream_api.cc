@@ -0,0 +1,98 @@
+/// Berkeley DB stream mex interface.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "stream.h"
+#include "mex/arguments.h"
+#include "mex/function.h"
+#include "mex/mxarray.h"
+
+using bdbmex::Database;
+using bdbmex::Stream;
+using mex::CheckInputArguments;
+using mex::CheckOutputArguments;
+using mex::MxArray;
+using mex::Session;
+using mex::VariableInputArguments;
+
+namespace {
+
+/// Get a stream from the id argument.
+Stream* GetStream(const mxArray* id) {
+  Stream* stream = Session<Stream>::get(MxArray(id).toInt());
+  if (!stream)
+    ERROR("No open stream found.");
+  return stream;
+}
+
+MEX_FUNCTION(stream_open) (int nlhs,
+                           mxArray *plhs[],
+                           int nrhs,
+                           const mxArray *prhs[]) {
+  CheckInputArguments(3, 1024, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  VariableInputArguments options;
+  options.set("ChunkSize", 1024 * 1024);
+  options.update(prhs + 3, prhs + nrhs);
+  Database* database = Session<Database>::get(MxArray(prhs[0]).toInt());
+  if (!database)
+    ERROR("No open database found.");
+  string mode = MxArray(prhs[2]).toString();
+  if (mode != "r" && mode != "w")
+    ERROR("Invalid mode: %s", mode.c_str());
+  Stream* stream = NULL;
+  int stream_id = Session<Stream>::create(&stream);
+  if (!stream->open(database,
+                    prhs[1],
+                    mode == "w",
+                    static_cast<size_t>(options["ChunkSize"].toDouble()))) {
+    const char* error_message = stream->error_message();
+    Session<Stream>::destroy(stream_id);
+    ERROR("Failed to open a stream: %s", error_message);
+  }
+  plhs[0] = MxArray(stream_id).getMutable();
+}
+
+MEX_FUNCTION(stream_write) (int nlhs,
+                            mxArray *plhs[],
+                            int nrhs,
+                            const mxArray *prhs[]) {
+  CheckInputArguments(2, 2, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  Stream* stream = GetStream(prhs[0]);
+  if (!stream->write(prhs[1]))
+    ERROR("Failed to write a stream: %s", stream->error_message());
+}
+
+MEX_FUNCTION(stream_read) (int nlhs,
+                           mxArray *plhs[],
+                           int nrhs,
+                           const mxArray *prhs[]) {
+  CheckInputArguments(1, 2, nrhs);
+  CheckOutputArguments(0, 1, nlhs);
+  Stream* stream = GetStream(prhs[0]);
+  double count = (nrhs > 1) ? MxArray(prhs[1]).toDouble() : mxGetInf();
+  if (count < 0)
+    ERROR("Invalid count.");
+  size_t num_elements = (mxIsInf(count)) ?
+      static_cast<size_t>(-1) : static_cast<size_t>(count);
+  if (!stream->read(num_elements, &plhs[0]))
+    ERROR("Failed to read a stream: %s", stream->error_message());
+}
+
+MEX_FUNCTION(stream_close) (int nlhs,
+                            mxArray *plhs[],
+                            int nrhs,
+                            const mxArray *prhs[]) {
+  CheckInputArguments(1, 1, nrhs);
+  CheckOutputArguments(0, 0, nlhs);
+  int stream_id = MxArray(prhs[0]).toInt();
+  Stream* stream = GetStream(prhs[0]);
+  bool success = stream->close();
+  const char* error_message = stream->error_message();
+  Session<Stream>::destroy(stream_id);
+  if (!success)
+    ERROR("Failed to close a stream: %s", error_message);
+}
+
+} // namespace
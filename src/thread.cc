@@ -0,0 +1,107 @@
+/// Thread helper library.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "thread.h"
+#include <cerrno>
+#include <cmath>
+#include <sys/time.h>
+
+namespace bdbmex {
+
+bool Condition::wait(Mutex* mutex, double seconds) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  double deadline = now.tv_sec + now.tv_usec * 1e-6 + seconds;
+  struct timespec timeout;
+  timeout.tv_sec = static_cast<time_t>(std::floor(deadline));
+  timeout.tv_nsec = static_cast<long>((deadline - timeout.tv_sec) * 1e9);
+  return pthread_cond_timedwait(&condition_, mutex->get(), &timeout) !=
+      ETIMEDOUT;
+}
+
+bool Thread::start() {
+  if (started_)
+    return true;
+  started_ = (pthread_create(&thread_, NULL, &Thread::entry, this) == 0);
+  return started_;
+}
+
+void Thread::join() {
+  if (!started_)
+    return;
+  pthread_join(thread_, NULL);
+  started_ = false;
+}
+
+void* Thread::entry(void* thread) {
+  static_cast<Thread*>(thread)->run();
+  return NULL;
+}
+
+ThreadPool::ThreadPool(int num_threads) :
+    num_threads_((num_threads > 0) ? num_threads : 1),
+    running_(0),
+    stopping_(false) {}
+
+ThreadPool::~ThreadPool() {
+  {
+    MutexLock lock(&mutex_);
+    stopping_ = true;
+    queued_.broadcast();
+  }
+  for (size_t i = 0; i < workers_.size(); ++i)
+    delete workers_[i];
+}
+
+bool ThreadPool::push(Task* task) {
+  while (static_cast<int>(workers_.size()) < num_threads_) {
+    Worker* worker = new Worker(this);
+    if (!worker->start()) {
+      delete worker;
+      break;
+    }
+    workers_.push_back(worker);
+  }
+  if (workers_.empty())
+    return false;
+  MutexLock lock(&mutex_);
+  tasks_.push_back(task);
+  queued_.signal();
+  return true;
+}
+
+void ThreadPool::wait() {
+  MutexLock lock(&mutex_);
+  while (!tasks_.empty() || running_ > 0)
+    idle_.wait(&mutex_);
+}
+
+Task* ThreadPool::take() {
+  MutexLock lock(&mutex_);
+  while (tasks_.empty() && !stopping_)
+    queued_.wait(&mutex_);
+  if (tasks_.empty())
+    return NULL;
+  Task* task = tasks_.front();
+  tasks_.pop_front();
+  ++running_;
+  return task;
+}
+
+void ThreadPool::finish() {
+  MutexLock lock(&mutex_);
+  --running_;
+  if (tasks_.empty() && running_ == 0)
+    idle_.broadcast();
+}
+
+void ThreadPool::Worker::run() {
+  Task* task = NULL;
+  while ((task = pool_->take()) != NULL) {
+    task->run();
+    pool_->finish();
+  }
+}
+
+} // namespace bdbmex
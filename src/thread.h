@@ -0,0 +1,205 @@
+/// Thread helper library.
+///
+/// Background threads must not call any mx or mex function, since the matlab
+/// API is not thread-safe. Work passed to a thread should be encoded into
+/// plain bytes on the matlab thread beforehand.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __THREAD_H__
+#define __THREAD_H__
+
+#include <deque>
+#include <pthread.h>
+#include <vector>
+
+namespace bdbmex {
+
+/// Mutual exclusion lock.
+class Mutex {
+public:
+  /// Create an unlocked mutex.
+  Mutex() { pthread_mutex_init(&mutex_, NULL); }
+  /// Destructor.
+  ~Mutex() { pthread_mutex_destroy(&mutex_); }
+  /// Lock the mutex.
+  void lock() { pthread_mutex_lock(&mutex_); }
+  /// Unlock the mutex.
+  void unlock() { pthread_mutex_unlock(&mutex_); }
+  /// Get the mutex.
+  pthread_mutex_t* get() { return &mutex_; }
+
+private:
+  /// Copy prohibited.
+  Mutex(const Mutex&);
+  Mutex& operator=(const Mutex&);
+
+  /// Mutex object.
+  pthread_mutex_t mutex_;
+};
+
+/// Scoped lock of a mutex.
+class MutexLock {
+public:
+  /// Lock the mutex.
+  explicit MutexLock(Mutex* mutex) : mutex_(mutex) { mutex_->lock(); }
+  /// Unlock the mutex.
+  ~MutexLock() { mutex_->unlock(); }
+
+private:
+  /// Copy prohibited.
+  MutexLock(const MutexLock&);
+  MutexLock& operator=(const MutexLock&);
+
+  /// Locked mutex.
+  Mutex* mutex_;
+};
+
+/// Condition variable.
+class Condition {
+public:
+  /// Create a condition variable.
+  Condition() { pthread_cond_init(&condition_, NULL); }
+  /// Destructor.
+  ~Condition() { pthread_cond_destroy(&condition_); }
+  /// Wait for a signal. The mutex must be locked by the caller.
+  void wait(Mutex* mutex) { pthread_cond_wait(&condition_, mutex->get()); }
+  /// Wait for a signal at most the given seconds. Return false on timeout.
+  bool wait(Mutex* mutex, double seconds);
+  /// Wake up one waiting thread.
+  void signal() { pthread_cond_signal(&condition_); }
+  /// Wake up all waiting threads.
+  void broadcast() { pthread_cond_broadcast(&condition_); }
+
+private:
+  /// Copy prohibited.
+  Condition(const Condition&);
+  Condition& operator=(const Condition&);
+
+  /// Condition object.
+  pthread_cond_t condition_;
+};
+
+/// Abstract thread. Child class must implement run().
+class Thread {
+public:
+  /// Create a thread object without starting it.
+  Thread() : started_(false) {}
+  /// Destructor. Child class must stop and join the thread in its own
+  /// destructor, as run() is not available here.
+  virtual ~Thread() {}
+  /// Start the thread. Return false on failure.
+  bool start();
+  /// Wait for the thread to finish.
+  void join();
+  /// Return if the thread has been started and not joined.
+  bool started() const { return started_; }
+
+protected:
+  /// Thread body.
+  virtual void run() = 0;
+
+private:
+  /// Copy prohibited.
+  Thread(const Thread&);
+  Thread& operator=(const Thread&);
+  /// Entry point of pthread.
+  static void* entry(void* thread);
+
+  /// Started flag.
+  bool started_;
+  /// Thread object.
+  pthread_t thread_;
+};
+
+/// Integer counter shared between threads.
+class Counter {
+public:
+  /// Create a zero counter.
+  Counter() : value_(0) {}
+  /// Add one.
+  void increment() { MutexLock lock(&mutex_); ++value_; }
+  /// Subtract one.
+  void decrement() { MutexLock lock(&mutex_); --value_; }
+  /// Current value.
+  int value() { MutexLock lock(&mutex_); return value_; }
+
+private:
+  /// Copy prohibited.
+  Counter(const Counter&);
+  Counter& operator=(const Counter&);
+
+  /// Lock of the value.
+  Mutex mutex_;
+  /// Counter value.
+  int value_;
+};
+
+/// Unit of work run by a thread pool.
+class Task {
+public:
+  /// Destructor.
+  virtual ~Task() {}
+  /// Run the task in a worker thread.
+  virtual void run() = 0;
+};
+
+/// Fixed number of worker threads running queued tasks in FIFO order. Tasks
+/// are not owned by the pool. Workers start on the first push.
+class ThreadPool {
+public:
+  /// Create a pool of the given number of workers.
+  explicit ThreadPool(int num_threads);
+  /// Finish every queued task and join the workers.
+  ~ThreadPool();
+  /// Queue a task. Return false if no worker could be started.
+  bool push(Task* task);
+  /// Block until every queued task is finished.
+  void wait();
+
+private:
+  /// Worker thread taking tasks from the pool.
+  class Worker : public Thread {
+  public:
+    /// Create a worker of the pool.
+    explicit Worker(ThreadPool* pool) : pool_(pool) {}
+    /// Join the thread.
+    virtual ~Worker() { join(); }
+
+  protected:
+    /// Run tasks until the pool is stopped and empty.
+    virtual void run();
+
+  private:
+    /// Owner pool.
+    ThreadPool* pool_;
+  };
+  /// Copy prohibited.
+  ThreadPool(const ThreadPool&);
+  ThreadPool& operator=(const ThreadPool&);
+  /// Take the next task, or NULL when stopped and empty.
+  Task* take();
+  /// Mark a taken task as finished.
+  void finish();
+
+  /// Number of workers.
+  int num_threads_;
+  /// Lock of the queue.
+  Mutex mutex_;
+  /// Signaled when a task is queued or the pool is stopped.
+  Condition queued_;
+  /// Signaled when the pool becomes idle.
+  Condition idle_;
+  /// Queued tasks.
+  std::deque<Task*> tasks_;
+  /// Number of running tasks.
+  int running_;
+  /// Stop flag.
+  bool stopping_;
+  /// Worker threads.
+  std::vector<Worker*> workers_;
+};
+
+} // namespace bdbmex
+
+#endif // __THREAD_H__
@@ -0,0 +1,117 @@
+/// Decoded value cache for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "value_cache.h"
+
+using std::map;
+using std::string;
+
+namespace bdbmex {
+
+/// Bookkeeping overhead assumed for each mxArray header.
+static const size_t kArrayOverhead = 128;
+
+ValueCache::ValueCache() : capacity_(0),
+                           size_(0),
+                           hits_(0),
+                           misses_(0),
+                           evictions_(0) {}
+
+ValueCache::~ValueCache() {
+  clear();
+}
+
+void ValueCache::set_capacity(size_t capacity) {
+  capacity_ = capacity;
+  evict(capacity_);
+}
+
+mxArray* ValueCache::find(const string& key) {
+  map<string, EntryList::iterator>::iterator it = index_.find(key);
+  if (it == index_.end()) {
+    ++misses_;
+    return NULL;
+  }
+  ++hits_;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  mxArray* value = mxDuplicateArray(it->second->value);
+  if (value == NULL)
+    mexErrMsgIdAndTxt("bdb:error", "Null pointer exception.");
+  return value;
+}
+
+void ValueCache::insert(const string& key, const mxArray* value) {
+  if (!enabled())
+    return;
+  erase(key);
+  size_t bytes = key.size() + array_bytes(value);
+  if (bytes > capacity_)
+    return;
+  evict(capacity_ - bytes);
+  Entry entry;
+  entry.key = key;
+  entry.value = mxDuplicateArray(value);
+  entry.bytes = bytes;
+  if (entry.value == NULL)
+    mexErrMsgIdAndTxt("bdb:error", "Null pointer exception.");
+  mexMakeArrayPersistent(entry.value);
+  entries_.push_front(entry);
+  index_[key] = entries_.begin();
+  size_ += bytes;
+}
+
+void ValueCache::erase(const string& key) {
+  map<string, EntryList::iterator>::iterator it = index_.find(key);
+  if (it != index_.end())
+    remove(it->second);
+}
+
+void ValueCache::clear() {
+  while (!entries_.empty())
+    remove(entries_.begin());
+}
+
+size_t ValueCache::array_bytes(const mxArray* value) {
+  size_t bytes = kArrayOverhead;
+  if (value == NULL)
+    return bytes;
+  size_t num_elements = mxGetNumberOfElements(value);
+  if (mxIsCell(value)) {
+    for (size_t i = 0; i < num_elements; ++i)
+      bytes += array_bytes(mxGetCell(value, i));
+  }
+  else if (mxIsStruct(value)) {
+    int num_fields = mxGetNumberOfFields(value);
+    for (size_t i = 0; i < num_elements; ++i)
+      for (int j = 0; j < num_fields; ++j)
+        bytes += array_bytes(mxGetFieldByNumber(value, i, j));
+  }
+  else if (mxIsSparse(value)) {
+    size_t nzmax = mxGetNzmax(value);
+    bytes += nzmax * (mxGetElementSize(value) * (mxIsComplex(value) ? 2 : 1) +
+                      sizeof(mwIndex)) +
+             (mxGetN(value) + 1) * sizeof(mwIndex);
+  }
+  else {
+    bytes += num_elements * mxGetElementSize(value) *
+             (mxIsComplex(value) ? 2 : 1);
+  }
+  return bytes;
+}
+
+void ValueCache::remove(EntryList::iterator entry) {
+  size_ -= entry->bytes;
+  mxDestroyArray(entry->value);
+  index_.erase(entry->key);
+  entries_.erase(entry);
+}
+
+void ValueCache::evict(size_t capacity) {
+  while (size_ > capacity && !entries_.empty()) {
+    remove(--entries_.end());
+    ++evictions_;
+  }
+}
+
+} // namespace bdbmex
@@ -0,0 +1,84 @@
+/// Decoded value cache for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __VALUE_CACHE_H__
+#define __VALUE_CACHE_H__
+
+#include <list>
+#include <map>
+#include <mex.h>
+#include <stdint.h>
+#include <string>
+
+namespace bdbmex {
+
+/// In-process LRU cache of decoded values keyed by encoded key bytes. The
+/// cache is bounded by the approximate memory size of the decoded mxArrays.
+/// Cached arrays are persistent and a duplicate is returned on hit.
+class ValueCache {
+public:
+  /// Create a disabled cache.
+  ValueCache();
+  /// Destructor.
+  virtual ~ValueCache();
+  /// Set the capacity in bytes. Zero disables the cache.
+  void set_capacity(size_t capacity);
+  /// Capacity in bytes.
+  size_t capacity() const { return capacity_; }
+  /// Current size in bytes.
+  size_t size() const { return size_; }
+  /// Return if the cache is enabled.
+  bool enabled() const { return capacity_ > 0; }
+  /// Find a value. Return a new duplicate of the cached value or NULL.
+  mxArray* find(const std::string& key);
+  /// Insert a copy of the value.
+  void insert(const std::string& key, const mxArray* value);
+  /// Invalidate an entry.
+  void erase(const std::string& key);
+  /// Invalidate all entries.
+  void clear();
+  /// Number of cache hits.
+  uint64_t hits() const { return hits_; }
+  /// Number of cache misses.
+  uint64_t misses() const { return misses_; }
+  /// Number of entries evicted to make room.
+  uint64_t evictions() const { return evictions_; }
+
+private:
+  /// Cache entry.
+  struct Entry {
+    /// Encoded key.
+    std::string key;
+    /// Persistent decoded value.
+    mxArray* value;
+    /// Memory size of the entry.
+    size_t bytes;
+  };
+  typedef std::list<Entry> EntryList;
+  /// Approximate memory size of an mxArray.
+  static size_t array_bytes(const mxArray* value);
+  /// Remove an entry.
+  void remove(EntryList::iterator entry);
+  /// Evict least recently used entries until the size fits.
+  void evict(size_t capacity);
+
+  /// Entries in the recently used order.
+  EntryList entries_;
+  /// Index to the entries.
+  std::map<std::string, EntryList::iterator> index_;
+  /// Capacity in bytes.
+  size_t capacity_;
+  /// Current size in bytes.
+  size_t size_;
+  /// Hit counter.
+  uint64_t hits_;
+  /// Miss counter.
+  uint64_t misses_;
+  /// Eviction counter.
+  uint64_t evictions_;
+};
+
+} // namespace bdbmex
+
+#endif // __VALUE_CACHE_H__
@@ -0,0 +1,383 @@
+/// Value log for Berkeley DB matlab driver.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#include "value_log.h"
+#include "dump.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace bdbmex {
+
+/// Header of a log entry, followed by the key and the value.
+struct EntryHeader {
+  /// Magic bytes 'V' 'L' 'O' 'G'.
+  uint8_t magic[4];
+  /// Size of the key in bytes.
+  uint32_t key_size;
+  /// Size of the value in bytes.
+  uint64_t value_size;
+  /// CRC-32 of the value.
+  uint32_t checksum;
+  /// Reserved, zero.
+  uint32_t reserved;
+};
+
+/// Magic bytes of a log entry.
+static const uint8_t kEntryMagic[] = {'V', 'L', 'O', 'G'};
+
+/// Magic bytes of a pointer record.
+static const uint8_t kPointerMagic[] = {0xFF, 'V', 'L', 'P'};
+
+/// Number of digits of a segment number in the file name.
+static const int kSegmentDigits = 6;
+
+/// Write all bytes at the offset.
+static bool write_fully(int fd, const void* data, size_t size, off_t offset) {
+  const char* input = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t written = pwrite(fd, input, size, offset);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    input += written;
+    offset += written;
+    size -= written;
+  }
+  return true;
+}
+
+/// Read all bytes at the offset. Return false on error or end of file.
+static bool read_fully(int fd, void* data, size_t size, off_t offset) {
+  char* output = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t bytes = pread(fd, output, size, offset);
+    if (bytes < 0 && errno == EINTR)
+      continue;
+    if (bytes <= 0) {
+      if (bytes == 0)
+        errno = EINVAL;
+      return false;
+    }
+    output += bytes;
+    offset += bytes;
+    size -= bytes;
+  }
+  return true;
+}
+
+ValueLog::ValueLog() : code_(0),
+                       segment_size_(0),
+                       read_only_(false),
+                       lock_file_(-1),
+                       head_(1),
+                       head_size_(0) {}
+
+ValueLog::~ValueLog() {
+  close();
+}
+
+bool ValueLog::open(const string& path,
+                    uint64_t max_segment_size,
+                    bool read_only) {
+  close();
+  path_ = path;
+  segment_size_ = max_segment_size;
+  read_only_ = read_only;
+  // Appends of two writers would interleave at the same offsets.
+  if (!read_only_) {
+    lock_file_ = ::open((path_ + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+    if (lock_file_ < 0) {
+      code_ = errno;
+      return false;
+    }
+    if (flock(lock_file_, LOCK_EX | LOCK_NB) != 0) {
+      code_ = (errno == EWOULDBLOCK) ? EAGAIN : errno;
+      ::close(lock_file_);
+      lock_file_ = -1;
+      return false;
+    }
+  }
+  size_t separator = path_.rfind('/');
+  directory_ = (separator == string::npos) ?
+      string(".") : path_.substr(0, separator + 1);
+  string prefix = ((separator == string::npos) ?
+      path_ : path_.substr(separator + 1)) + ".";
+  DIR* dir = opendir(directory_.c_str());
+  if (dir == NULL) {
+    code_ = errno;
+    return false;
+  }
+  struct dirent* entry = NULL;
+  while ((entry = readdir(dir)) != NULL) {
+    string name(entry->d_name);
+    if (name.size() != prefix.size() + kSegmentDigits ||
+        name.compare(0, prefix.size(), prefix) != 0 ||
+        name.find_first_not_of("0123456789", prefix.size()) != string::npos)
+      continue;
+    segments_.insert(static_cast<uint32_t>(
+        strtoul(name.c_str() + prefix.size(), NULL, 10)));
+  }
+  closedir(dir);
+  if (!segments_.empty())
+    head_ = *segments_.rbegin();
+  head_size_ = segment_size(head_);
+  if (!read_only_ && head_size_ > 0) {
+    // Appending resumes after the last complete entry of the head.
+    vector<Entry> entries;
+    if (!scan(head_, &entries)) {
+      ++head_;
+      head_size_ = 0;
+    }
+    else {
+      uint64_t end = (entries.empty()) ? 0 :
+          entries.back().pointer.offset + entries.back().pointer.length;
+      if (end < head_size_ && ftruncate(file(head_), end) != 0) {
+        code_ = errno;
+        return false;
+      }
+      head_size_ = end;
+    }
+  }
+  code_ = 0;
+  return true;
+}
+
+void ValueLog::close() {
+  for (map<uint32_t, int>::iterator it = files_.begin();
+       it != files_.end(); ++it)
+    ::close(it->second);
+  files_.clear();
+  segments_.clear();
+  dirty_.clear();
+  if (lock_file_ >= 0)
+    ::close(lock_file_);
+  lock_file_ = -1;
+  head_ = 1;
+  head_size_ = 0;
+}
+
+bool ValueLog::append(const string& key,
+                      const void* data,
+                      size_t size,
+                      ValuePointer* pointer) {
+  if (read_only_) {
+    code_ = EACCES;
+    return false;
+  }
+  uint64_t entry_size = sizeof(EntryHeader) + key.size() + size;
+  if (head_size_ > 0 && head_size_ + entry_size > segment_size_) {
+    ++head_;
+    head_size_ = 0;
+  }
+  int fd = file(head_, true);
+  if (fd < 0)
+    return false;
+  EntryHeader header;
+  memset(&header, 0, sizeof(EntryHeader));
+  memcpy(header.magic, kEntryMagic, sizeof(kEntryMagic));
+  header.key_size = key.size();
+  header.value_size = size;
+  header.checksum = crc32_checksum(data, size);
+  off_t offset = static_cast<off_t>(head_size_);
+  if (!write_fully(fd, &header, sizeof(EntryHeader), offset) ||
+      !write_fully(fd, key.data(), key.size(), offset + sizeof(EntryHeader)) ||
+      !write_fully(fd,
+                   data,
+                   size,
+                   offset + sizeof(EntryHeader) + key.size())) {
+    code_ = errno;
+    return false;
+  }
+  memset(pointer, 0, sizeof(ValuePointer));
+  memcpy(pointer->magic, kPointerMagic, sizeof(kPointerMagic));
+  pointer->sentinel = 0xFF;
+  pointer->segment = head_;
+  pointer->checksum = header.checksum;
+  pointer->offset = head_size_ + sizeof(EntryHeader) + key.size();
+  pointer->length = size;
+  head_size_ += entry_size;
+  dirty_.insert(head_);
+  code_ = 0;
+  return true;
+}
+
+bool ValueLog::read(const ValuePointer& pointer, string* value) {
+  int fd = file(pointer.segment);
+  if (fd < 0)
+    return false;
+  value->resize(pointer.length);
+  if (pointer.length > 0 &&
+      !read_fully(fd,
+                  &(*value)[0],
+                  pointer.length,
+                  static_cast<off_t>(pointer.offset))) {
+    code_ = errno;
+    return false;
+  }
+  code_ = (crc32_checksum(value->data(), value->size()) == pointer.checksum) ?
+      0 : EINVAL;
+  return ok();
+}
+
+bool ValueLog::scan(uint32_t segment, vector<Entry>* entries) {
+  entries->clear();
+  int fd = file(segment);
+  if (fd < 0)
+    return false;
+  uint64_t size = segment_size(segment);
+  uint64_t offset = 0;
+  // A torn entry at the end of a segment is ignored.
+  while (offset + sizeof(EntryHeader) <= size) {
+    EntryHeader header;
+    if (!read_fully(fd, &header, sizeof(EntryHeader), offset)) {
+      code_ = errno;
+      return false;
+    }
+    if (memcmp(header.magic, kEntryMagic, sizeof(kEntryMagic)) != 0) {
+      code_ = EINVAL;
+      return false;
+    }
+    uint64_t value_offset = offset + sizeof(EntryHeader) + header.key_size;
+    if (value_offset + header.value_size > size)
+      break;
+    Entry entry;
+    entry.key.resize(header.key_size);
+    if (header.key_size > 0 &&
+        !read_fully(fd,
+                    &entry.key[0],
+                    header.key_size,
+                    offset + sizeof(EntryHeader))) {
+      code_ = errno;
+      return false;
+    }
+    memset(&entry.pointer, 0, sizeof(ValuePointer));
+    memcpy(entry.pointer.magic, kPointerMagic, sizeof(kPointerMagic));
+    entry.pointer.sentinel = 0xFF;
+    entry.pointer.segment = segment;
+    entry.pointer.checksum = header.checksum;
+    entry.pointer.offset = value_offset;
+    entry.pointer.length = header.value_size;
+    entries->push_back(entry);
+    offset = value_offset + header.value_size;
+  }
+  code_ = 0;
+  return true;
+}
+
+bool ValueLog::remove(uint32_t segment) {
+  if (segment == head_ || read_only_) {
+    code_ = EINVAL;
+    return false;
+  }
+  map<uint32_t, int>::iterator it = files_.find(segment);
+  if (it != files_.end()) {
+    ::close(it->second);
+    files_.erase(it);
+  }
+  if (unlink(segment_name(segment).c_str()) != 0 && errno != ENOENT) {
+    code_ = errno;
+    return false;
+  }
+  segments_.erase(segment);
+  dirty_.erase(segment);
+  return sync_directory();
+}
+
+bool ValueLog::sync() {
+  // Appends may have rolled over to a new head since the last sync.
+  for (set<uint32_t>::iterator it = dirty_.begin(); it != dirty_.end(); ++it) {
+    map<uint32_t, int>::iterator file = files_.find(*it);
+    if (file != files_.end() && fsync(file->second) != 0) {
+      code_ = errno;
+      return false;
+    }
+  }
+  dirty_.clear();
+  code_ = 0;
+  return true;
+}
+
+void ValueLog::segments(vector<uint32_t>* numbers) const {
+  numbers->assign(segments_.begin(), segments_.end());
+}
+
+uint64_t ValueLog::segment_size(uint32_t segment) {
+  struct stat status;
+  if (stat(segment_name(segment).c_str(), &status) != 0)
+    return 0;
+  return static_cast<uint64_t>(status.st_size);
+}
+
+const char* ValueLog::error_message() const {
+  if (code_ == EAGAIN)
+    return "Value log is open for writing by another handle.";
+  return (code_ == EINVAL) ? "Corrupted value log." : strerror(code_);
+}
+
+bool ValueLog::read_pointer(const void* data,
+                            size_t size,
+                            ValuePointer* pointer) {
+  if (data == NULL || size != sizeof(ValuePointer))
+    return false;
+  memcpy(pointer, data, sizeof(ValuePointer));
+  return memcmp(pointer->magic, kPointerMagic, sizeof(kPointerMagic)) == 0 &&
+         pointer->sentinel == 0xFF;
+}
+
+string ValueLog::encode_pointer(const ValuePointer& pointer) {
+  return string(reinterpret_cast<const char*>(&pointer), sizeof(ValuePointer));
+}
+
+string ValueLog::segment_name(uint32_t segment) const {
+  char number[32];
+  snprintf(number, sizeof(number), ".%0*u", kSegmentDigits, segment);
+  return path_ + number;
+}
+
+int ValueLog::file(uint32_t segment, bool create) {
+  map<uint32_t, int>::iterator it = files_.find(segment);
+  if (it != files_.end())
+    return it->second;
+  int flags = (read_only_) ? O_RDONLY : (O_RDWR | ((create) ? O_CREAT : 0));
+  bool created = !read_only_ && create && segments_.count(segment) == 0;
+  int fd = ::open(segment_name(segment).c_str(), flags, 0644);
+  if (fd < 0) {
+    code_ = errno;
+    return -1;
+  }
+  files_[segment] = fd;
+  segments_.insert(segment);
+  // The directory entry of a new segment must be durable before any
+  // pointer to it is stored.
+  if (created && !sync_directory())
+    return -1;
+  return fd;
+}
+
+bool ValueLog::sync_directory() {
+  int fd = ::open(directory_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    code_ = errno;
+    return false;
+  }
+  code_ = (fsync(fd) != 0) ? errno : 0;
+  ::close(fd);
+  return ok();
+}
+
+} // namespace bdbmex
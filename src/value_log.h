@@ -0,0 +1,136 @@
+/// Value log for Berkeley DB matlab driver.
+///
+/// A value log keeps large values out of the btree. Values are appended to
+/// segment files next to the database, e.g., data.bdb.vlog.000001, and the
+/// database stores a small pointer record in their place. Each log entry
+/// carries its key so that garbage collection can tell live entries from
+/// overwritten or deleted ones by looking up the database. The log is not
+/// transactional; entries left by aborted writes are garbage.
+///
+/// Kota Yamaguchi 2012 <kyamagu@cs.stonybrook.edu>
+
+#ifndef __VALUE_LOG_H__
+#define __VALUE_LOG_H__
+
+#include <map>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace bdbmex {
+
+/// Record stored in the database in place of a logged value. The magic and
+/// the sentinel never appear in the size header of a compressed value.
+struct ValuePointer {
+  /// Magic bytes 0xFF 'V' 'L' 'P'.
+  uint8_t magic[4];
+  /// Reserved, zero.
+  uint8_t reserved[3];
+  /// Sentinel byte 0xFF.
+  uint8_t sentinel;
+  /// Segment number.
+  uint32_t segment;
+  /// CRC-32 of the value.
+  uint32_t checksum;
+  /// Offset of the value in the segment.
+  uint64_t offset;
+  /// Size of the value in bytes.
+  uint64_t length;
+};
+
+/// Append-only segment files of large values.
+class ValueLog {
+public:
+  /// Entry found in a segment.
+  struct Entry {
+    /// Encoded key of the entry.
+    std::string key;
+    /// Location of the value.
+    ValuePointer pointer;
+  };
+
+  /// Create a closed log.
+  ValueLog();
+  /// Close the log.
+  virtual ~ValueLog();
+  /// Open segment files of the base path. A new segment is started when the
+  /// head segment would exceed max_segment_size bytes. A writable log takes
+  /// an exclusive lock on the lock file of the path and fails with EAGAIN
+  /// when another writer holds it.
+  bool open(const std::string& path,
+            uint64_t max_segment_size,
+            bool read_only);
+  /// Close every segment file and release the lock.
+  void close();
+  /// Append a value to the head segment and fill its pointer.
+  bool append(const std::string& key,
+              const void* data,
+              size_t size,
+              ValuePointer* pointer);
+  /// Read and verify a value.
+  bool read(const ValuePointer& pointer, std::string* value);
+  /// List entries of a segment in the order of appending.
+  bool scan(uint32_t segment, std::vector<Entry>* entries);
+  /// Delete a segment file and flush the directory. The head segment cannot
+  /// be deleted.
+  bool remove(uint32_t segment);
+  /// Flush every segment appended to since the last sync to disk.
+  bool sync();
+  /// Segment numbers in ascending order.
+  void segments(std::vector<uint32_t>* numbers) const;
+  /// Number of the head segment.
+  uint32_t head() const { return head_; }
+  /// Size of a segment file in bytes.
+  uint64_t segment_size(uint32_t segment);
+  /// Return if the status is okay.
+  bool ok() const { return code_ == 0; }
+  /// Return the last error code.
+  int error_code() const { return code_; }
+  /// Return the last error message.
+  const char* error_message() const;
+  /// Read a pointer record. Return false if the bytes are not a pointer.
+  static bool read_pointer(const void* data,
+                           size_t size,
+                           ValuePointer* pointer);
+  /// Encode a pointer record.
+  static std::string encode_pointer(const ValuePointer& pointer);
+
+private:
+  /// Copy prohibited.
+  ValueLog(const ValueLog&);
+  ValueLog& operator=(const ValueLog&);
+  /// File name of a segment.
+  std::string segment_name(uint32_t segment) const;
+  /// File descriptor of a segment, opened on demand, or -1.
+  int file(uint32_t segment, bool create = false);
+  /// Flush the directory of segment files to disk.
+  bool sync_directory();
+
+  /// Last return code.
+  int code_;
+  /// Base path of segment files.
+  std::string path_;
+  /// Directory of segment files.
+  std::string directory_;
+  /// Maximum size of a segment in bytes.
+  uint64_t segment_size_;
+  /// Open without writing.
+  bool read_only_;
+  /// File descriptor of the locked lock file, or -1.
+  int lock_file_;
+  /// Existing segment numbers.
+  std::set<uint32_t> segments_;
+  /// Open file descriptors by segment number.
+  std::map<uint32_t, int> files_;
+  /// Segments appended to since the last sync.
+  std::set<uint32_t> dirty_;
+  /// Number of the head segment.
+  uint32_t head_;
+  /// Size of the head segment.
+  uint64_t head_size_;
+};
+
+} // namespace bdbmex
+
+#endif // __VALUE_LOG_H__
@@ -5,7 +5,29 @@ function bdb_test()
     @test_functional_1, ...
     @test_functional_2, ...
     @test_functional_3, ...
-    @test_functional_4 ...
+    @test_functional_4, ...
+    @test_functional_5, ...
+    @test_functional_6, ...
+    @test_functional_7, ...
+    @test_functional_8, ...
+    @test_functional_9, ...
+    @test_functional_10, ...
+    @test_functional_11, ...
+    @test_functional_12, ...
+    @test_functional_13, ...
+    @test_functional_14, ...
+    @test_functional_15, ...
+    @test_functional_16, ...
+    @test_functional_17, ...
+    @test_functional_18, ...
+    @test_functional_19, ...
+    @test_functional_20, ...
+    @test_functional_21, ...
+    @test_functional_22, ...
+    @test_functional_23, ...
+    @test_functional_24, ...
+    @test_functional_25, ...
+    @test_functional_26 ...
     };
   for i = 1:numel(tests)
     try
@@ -139,6 +161,9 @@ function test_functional_4()
     bdb.put(2, 'bar');
     bdb.put(db_id, 3, 'baz', 'Transaction', transaction);
     bdb.commit();
+    stats = bdb.env_stat(env_id);
+    assert(stats.mpool.cache_hit + stats.mpool.cache_miss > 0);
+    assert(stats.txn.ncommits >= 1);
     bdb.close(db_id);
     bdb.env_close(env_id);
   catch e
@@ -149,6 +174,955 @@ function test_functional_4()
   cleanup(home_dir);
 end
 
+function test_functional_5()
+%TEST_FUNCTIONAL_5
+
+  filename = fullfile(get_test_dir, '_functional_5.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  stale_id = bdb.open(filename);
+  bdb.close(stale_id);
+  db_id = bdb.open(filename);
+  try
+    assert(db_id ~= stale_id);
+    assert(isequal(bdb.sessions(), db_id));
+    stale = false;
+    try
+      bdb.get(stale_id, 'foo');
+    catch
+      stale = true;
+    end
+    assert(stale);
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_6()
+%TEST_FUNCTIONAL_6
+
+  filename = fullfile(get_test_dir, '_functional_6.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'ValueCacheSize', 1024 * 1024);
+  try
+    bdb.put(db_id, 'foo', magic(4));
+    assert(isequal(bdb.get(db_id, 'foo'), magic(4)));
+    assert(isequal(bdb.get(db_id, 'foo'), magic(4)));
+    bdb.put(db_id, 'foo', 'bar');
+    assert(strcmp(bdb.get(db_id, 'foo'), 'bar'));
+    stats = bdb.stat(db_id);
+    assert(stats.value_cache_hits == 1);
+    assert(stats.value_cache_misses == 2);
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_7()
+%TEST_FUNCTIONAL_7
+
+  filename = fullfile(get_test_dir, '_functional_7.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'PageSize', 8192, ...
+                   'CacheSize', 4 * 1024 * 1024);
+  try
+    for i = 1:100
+      bdb.put(db_id, i, rand(1, 256));
+    end
+    result = bdb.advise(db_id);
+    assert(result.pagesize == 8192);
+    assert(result.samples == 100);
+    assert(result.recommended_pagesize >= 4096);
+    stats = bdb.env_stat('Database', db_id);
+    assert(numel(stats.files) >= 1);
+    assert(isempty(stats.txn));
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_8()
+%TEST_FUNCTIONAL_8
+
+  filename = fullfile(get_test_dir, '_functional_8.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'Thread', true);
+  try
+    keys = arrayfun(@(x)sprintf('key%d', x), 1:100, 'UniformOutput', false);
+    for i = 1:numel(keys)
+      bdb.put(db_id, keys{i}, i);
+    end
+    bdb.prefetch(db_id, keys);
+    bdb.prefetch(db_id, 'missing');
+    for i = 1:numel(keys)
+      assert(bdb.get(db_id, keys{i}) == i);
+    end
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+  db_id = bdb.open(filename, 'Create');
+  try
+    bdb.prefetch(db_id, 'foo');
+    error('bdb:test', 'Prefetch without Thread must fail.');
+  catch e
+    if strcmp(e.identifier, 'bdb:test')
+      cleanup(db_id, filename);
+      rethrow(e);
+    end
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_9()
+%TEST_FUNCTIONAL_9
+
+  filename = fullfile(get_test_dir, '_functional_9.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'Thread', true);
+  try
+    for i = 1:50
+      bdb.put(db_id, i, i * 2);
+    end
+    cursor_id = bdb.cursor_open(db_id, 'Prefetch', 4);
+    count = 0;
+    while bdb.cursor_next(cursor_id)
+      [key, value] = bdb.cursor_get(cursor_id);
+      assert(value == key * 2);
+      count = count + 1;
+    end
+    assert(count == 50);
+    bdb.cursor_close(cursor_id);
+    cursor_id = bdb.cursor_open(db_id, 'Prefetch', 4);
+    assert(bdb.cursor_next(cursor_id));
+    bdb.cursor_close(cursor_id);
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_10()
+%TEST_FUNCTIONAL_10
+
+  filename = fullfile(get_test_dir, '_functional_10.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'Thread', true);
+  try
+    handles = zeros(1, 10);
+    for i = 1:numel(handles)
+      handles(i) = bdb.put_async(db_id, i, magic(i));
+    end
+    while ~isempty(handles)
+      index = bdb.wait_any(handles);
+      assert(all(bdb.poll(handles(index))));
+      bdb.wait(handles(index));
+      handles(index) = [];
+    end
+    handle = bdb.get_async(db_id, 3);
+    assert(isequal(bdb.wait(handle), magic(3)));
+    handle = bdb.mget_async(db_id, {1, 2, 'missing'});
+    values = bdb.wait(handle);
+    assert(isequal(values{1}, magic(1)));
+    assert(isequal(values{2}, magic(2)));
+    assert(isempty(values{3}));
+    handle = bdb.put_async(db_id, 'foo', 'bar');
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_11()
+%TEST_FUNCTIONAL_11
+  home_dir = fullfile(get_test_dir, 'test_functional_11');
+  if ~exist(home_dir, 'dir'), mkdir(home_dir); end
+  function cleanup(home_dir)
+    if exist(home_dir, 'dir'), rmdir(home_dir, 's'); end
+  end
+
+  try
+    env_id = bdb.env_open(home_dir, 'LogAutoRemove', true, ...
+                          'CheckpointEvery', 0.1);
+    db_id = bdb.open('test_functional_11.bdb');
+    for i = 1:100
+      bdb.put(db_id, i, rand(10));
+    end
+    bdb.checkpoint(env_id, 'Force', true);
+    files = bdb.log_archive(env_id, 'Log', true);
+    assert(iscell(files) && ~isempty(files));
+    backup_dir = fullfile(home_dir, 'backup');
+    bdb.backup(env_id, backup_dir, 'Rate', 100);
+    assert(exist(fullfile(backup_dir, 'test_functional_11.bdb'), 'file') > 0);
+    bdb.put(db_id, 'foo', 'bar');
+    bdb.backup(env_id, backup_dir, 'Incremental', true);
+    pause(0.3);
+    stats = bdb.env_stat(env_id);
+    assert(stats.checkpoint.count > 0 && isempty(stats.checkpoint.error));
+    bdb.close(db_id);
+    bdb.env_close(env_id);
+  catch e
+    cleanup(home_dir);
+    rethrow(e);
+  end
+  cleanup(home_dir);
+end
+
+function test_functional_12()
+%TEST_FUNCTIONAL_12
+
+  filename = fullfile(get_test_dir, '_functional_12.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create');
+  try
+    keys = num2cell([randperm(1000), 7]);
+    values = num2cell([keys{1:end-1}, -1]);
+    num_records = bdb.bulk_load(db_id, keys, values, 'MemoryLimit', 4096);
+    assert(num_records == 1001);
+    assert(bdb.get(db_id, 7) == -1);
+    assert(bdb.get(db_id, 500) == 500);
+    assert(numel(bdb.keys(db_id)) == 1000);
+    dump_file = fullfile(get_test_dir, '_functional_12.dump');
+    assert(bdb.export(db_id, dump_file, 'Compress', true) == 1000);
+    bdb.close(db_id);
+    delete(filename);
+    db_id = bdb.open(filename, 'Create');
+    assert(bdb.import(db_id, dump_file) == 1000);
+    delete(dump_file);
+    assert(bdb.get(db_id, 7) == -1);
+    assert(isequal(sort(cell2mat(bdb.keys(db_id))), (1:1000)'));
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_13()
+%TEST_FUNCTIONAL_13
+
+  pattern = fullfile(get_test_dir, '_functional_13_%d.bdb');
+
+  function cleanup(db_id, pattern)
+  %CLEANUP
+    bdb.close_sharded(db_id);
+    for i = 0:2
+      filename = sprintf(pattern, i);
+      if exist(filename, 'file')
+        delete(filename);
+      end
+    end
+  end
+
+  db_id = bdb.open_sharded(pattern, 3);
+  try
+    for i = 1:30
+      bdb.sharded_put(db_id, i, -i);
+    end
+    assert(bdb.sharded_get(db_id, 10) == -10);
+    bdb.sharded_delete(db_id, 10);
+    assert(isempty(bdb.sharded_get(db_id, 10)));
+    values = bdb.sharded_mget(db_id, {1, 10, 30});
+    assert(values{1} == -1 && isempty(values{2}) && values{3} == -30);
+    keys = bdb.sharded_keys(db_id, 'Ordered', true);
+    values = bdb.sharded_values(db_id, 'Ordered', true);
+    assert(numel(keys) == 29);
+    assert(isequal(cell2mat(keys), -cell2mat(values)));
+    assert(isequal(sort(cell2mat(bdb.sharded_keys(db_id))), ...
+                   setdiff(1:30, 10)'));
+  catch e
+    cleanup(db_id, pattern);
+    rethrow(e);
+  end
+  cleanup(db_id, pattern);
+
+end
+
+function test_functional_14()
+%TEST_FUNCTIONAL_14
+
+  filename = fullfile(get_test_dir, '_functional_14.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+    index_files = {[filename, '.subject.idx'], [filename, '.parity.idx']};
+    for j = 1:numel(index_files)
+      if exist(index_files{j}, 'file')
+        delete(index_files{j});
+      end
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create');
+  try
+    for i = 1:20
+      bdb.put(db_id, i, struct('subject', mod(i, 5) - 2, ...
+                               'parity', mod(i, 2), ...
+                               'data', i));
+    end
+    bdb.put(db_id, 'other', 'not a struct');
+    index_id = bdb.create_index(db_id, 'FieldName', 'subject');
+    assert(bdb.get(20).data == 20);
+    bdb.put(db_id, 21, struct('subject', 'abc', 'parity', 1, 'data', 21));
+    [values, keys] = bdb.get_by(index_id, -2);
+    assert(numel(values) == 4);
+    assert(isequal(sort(cell2mat(keys))', [5, 10, 15, 20]));
+    values = bdb.get_by(index_id, -1, 'Upper', 0);
+    assert(numel(values) == 8);
+    subjects = cellfun(@(x)x.subject, values);
+    assert(issorted(subjects));
+    values = bdb.get_by(index_id, 'abc');
+    assert(numel(values) == 1 && values{1}.data == 21);
+    bdb.delete(db_id, 21);
+    assert(isempty(bdb.get_by(index_id, 'abc')));
+    parity_id = bdb.create_index(db_id, 'FieldName', 'parity');
+    [values, keys] = bdb.join(db_id, {index_id, -2; parity_id, 0});
+    assert(isequal(sort(cell2mat(keys))', [10, 20]));
+    assert(all(cellfun(@(x)x.parity == 0 && x.subject == -2, values)));
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_15()
+%TEST_FUNCTIONAL_15
+
+  filename = fullfile(get_test_dir, '_functional_15.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'Type', 'queue', ...
+                   'RecordLength', 256, 'ExtentSize', 16);
+  try
+    messages = arrayfun(@(x)struct('task', x), 1:100, 'UniformOutput', false);
+    recnos = bdb.append(db_id, messages);
+    assert(isequal(recnos', 1:100));
+    recnos = bdb.append(db_id, {'last'});
+    assert(recnos == 101);
+    [values, recnos] = bdb.consume(db_id, 60);
+    assert(numel(values) == 60 && isequal(recnos', 1:60));
+    assert(all(cellfun(@(x)x.task, values)' == 1:60));
+    values = bdb.consume(db_id, 100, 'Wait', true);
+    assert(numel(values) == 41 && strcmp(values{end}, 'last'));
+    assert(isempty(bdb.consume(db_id, 10)));
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_16()
+%TEST_FUNCTIONAL_16
+
+  filename = fullfile(get_test_dir, '_functional_16.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'Type', 'heap');
+  try
+    rids = cell(1, 10);
+    for i = 1:10
+      rids{i} = bdb.put(db_id, [], rand(100, i), 'Append', true);
+      assert(numel(rids{i}) == 2);
+    end
+    assert(isequal(size(bdb.get(db_id, rids{3})), [100, 3]));
+    bdb.put(db_id, rids{3}, 'replaced');
+    assert(strcmp(bdb.get(db_id, rids{3}), 'replaced'));
+    bdb.delete(db_id, rids{5});
+    assert(~bdb.exist(db_id, rids{5}));
+    assert(numel(bdb.keys(db_id)) == 9);
+    result = bdb.stat(db_id);
+    assert(result.nrecs == 9);
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_17()
+%TEST_FUNCTIONAL_17
+
+  filename = fullfile(get_test_dir, '_functional_17.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'Duplicates', 'sorted');
+  try
+    for i = 1:500
+      bdb.put(db_id, 'a', i);
+    end
+    bdb.put(db_id, 'b', 'single');
+    values = bdb.get_all(db_id, 'a');
+    assert(numel(values) == 500);
+    assert(isequal(sort(cell2mat(values))', 1:500));
+    assert(bdb.count(db_id, 'a') == 500);
+    assert(bdb.count(db_id, 'b') == 1);
+    assert(bdb.count(db_id, 'c') == 0);
+    assert(isempty(bdb.get_all(db_id, 'c')));
+    assert(numel(bdb.keys(db_id)) == 2);
+    assert(numel(bdb.values(db_id)) == 501);
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_18()
+%TEST_FUNCTIONAL_18
+
+  filename = fullfile(get_test_dir, '_functional_18.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create');
+  try
+    sequence_id = bdb.sequence_open(db_id, 'id', 'CacheSize', 100, ...
+                                    'Initial', 1);
+    values = bdb.sequence_next(sequence_id, 10);
+    assert(isa(values, 'int64') && isequal(values', int64(1:10)));
+    assert(bdb.sequence_next(sequence_id) == 11);
+    bdb.sequence_close(sequence_id);
+    % Values cached by the closed handle are skipped.
+    sequence_id = bdb.sequence_open(db_id, 'id');
+    assert(bdb.sequence_next(sequence_id) > 11);
+    other_id = bdb.sequence_open(db_id, 'other');
+    assert(bdb.sequence_next(other_id) == 0);
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_19()
+%TEST_FUNCTIONAL_19
+
+  filename = fullfile(get_test_dir, '_functional_19.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'Codec', 'native');
+  try
+    value = magic(4);
+    bdb.put(db_id, 'matrix', value);
+    assert(isequal(bdb.get(db_id, 'matrix'), value));
+    bdb.put(db_id, 'text', 'abc');
+    assert(strcmp(bdb.get(db_id, 'text'), 'abc'));
+    bdb.put(db_id, 'struct', struct('a', 1));
+    assert(bdb.get(db_id, 'struct').a == 1);
+    for i = 1:100
+      bdb.incr(db_id, 'counter');
+    end
+    assert(bdb.get(db_id, 'counter') == 100);
+    assert(bdb.incr(db_id, 'counter', -50) == 50);
+    bdb.put(db_id, 'small', uint8(250));
+    assert(bdb.incr(db_id, 'small', 10) == uint8(255));
+    bdb.put(db_id, 'large', int64(2)^53 + 1);
+    assert(bdb.incr(db_id, 'large', 1) == int64(2)^53 + 2);
+    bdb.put(db_id, 'large', intmax('int64') - 1);
+    assert(bdb.incr(db_id, 'large', 5) == intmax('int64'));
+    assert(bdb.incr(db_id, 'large', -1) == intmax('int64') - 1);
+    bdb.put(db_id, 'large', intmax('uint64') - 2);
+    assert(bdb.incr(db_id, 'large', 1) == intmax('uint64') - 1);
+    assert(bdb.append_to(db_id, 'list', int32([1, 2])) == 2);
+    assert(bdb.append_to(db_id, 'list', int32(3)) == 3);
+    assert(isequal(bdb.get(db_id, 'list'), int32([1, 2, 3])));
+    assert(bdb.cas(db_id, 'lock', [], 'owner1'));
+    assert(~bdb.cas(db_id, 'lock', [], 'owner2'));
+    assert(bdb.cas(db_id, 'lock', 'owner1', 'owner2'));
+    assert(strcmp(bdb.get(db_id, 'lock'), 'owner2'));
+    assert(bdb.incr('counter') == 51);
+    assert(bdb.append_to('list', int32(4)) == 4);
+    assert(bdb.cas('lock', 'owner2', 'owner3'));
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_20()
+%TEST_FUNCTIONAL_20
+
+  filename = fullfile(get_test_dir, '_functional_20.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    files = {filename, [filename, '.stream']};
+    for j = 1:numel(files)
+      if exist(files{j}, 'file')
+        delete(files{j});
+      end
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create');
+  try
+    stream_id = bdb.stream_open(db_id, 'signal', 'w', 'ChunkSize', 1000);
+    for i = 1:10
+      bdb.stream_write(stream_id, int16((1:300) + 300 * (i - 1)));
+    end
+    bdb.stream_close(stream_id);
+    manifest = bdb.get(db_id, 'signal');
+    assert(manifest.numel == 3000 && strcmp(manifest.class, 'int16'));
+    stream_id = bdb.stream_open(db_id, 'signal', 'r');
+    first = bdb.stream_read(stream_id, 1234);
+    rest = bdb.stream_read(stream_id);
+    assert(isempty(bdb.stream_read(stream_id, 1)));
+    bdb.stream_close(stream_id);
+    assert(isa(first, 'int16') && isequal([first; rest], int16(1:3000)'));
+    writer_id = bdb.stream_open(db_id, 'signal', 'w', 'ChunkSize', 1000);
+    bdb.stream_write(writer_id, int16(1:700));
+    stream_id = bdb.stream_open(db_id, 'signal', 'r');
+    assert(isequal(bdb.stream_read(stream_id), int16(1:3000)'));
+    bdb.stream_close(stream_id);
+    bdb.stream_close(writer_id);
+    stream_id = bdb.stream_open(db_id, 'signal', 'r');
+    assert(isequal(bdb.stream_read(stream_id), int16(1:700)'));
+    bdb.stream_close(stream_id);
+    bdb.delete(db_id, 'signal');
+    assert(~bdb.exist(db_id, 'signal'));
+    stream_id = bdb.stream_open(db_id, 'signal', 'w', 'ChunkSize', 1000);
+    bdb.stream_write(stream_id, int16(1:700));
+    bdb.stream_close(stream_id);
+    bdb.put(db_id, 'signal', 'plain');
+    bdb.close(db_id);
+    store_id = bdb.open([filename, '.stream']);
+    chunks = numel(bdb.keys(store_id));
+    bdb.close(store_id);
+    db_id = bdb.open(filename);
+    assert(chunks == 0);
+    assert(strcmp(bdb.get(db_id, 'signal'), 'plain'));
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_21()
+%TEST_FUNCTIONAL_21
+
+  filename = fullfile(get_test_dir, '_functional_21.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'Codec', 'native');
+  try
+    value = single(1:10000)';
+    bdb.put(db_id, 'signal', value);
+    assert(isequal(bdb.get(db_id, 'signal', 'Range', [100, 5]), value(101:105)));
+    assert(isequal(bdb.get(db_id, 'signal', 'Range', [9998, 5]), value(9999:end)));
+    assert(isempty(bdb.get(db_id, 'signal', 'Range', [20000, 5])));
+    assert(isequal(bdb.get(db_id, 'signal', 'Range', uint32([100, 5])), ...
+                   value(101:105)));
+    bdb.put(db_id, 'signal', single([-1; -2]), 'At', 0);
+    value(1:2) = [-1; -2];
+    assert(isequal(bdb.get(db_id, 'signal'), value));
+    failed = false;
+    try
+      bdb.put(db_id, 'signal', single([1; 2]), 'At', 9999);
+    catch
+      failed = true;
+    end
+    assert(failed);
+    failed = false;
+    try
+      bdb.put(db_id, 'signal', [1; 2], 'At', 0);
+    catch
+      failed = true;
+    end
+    assert(failed);
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_22()
+%TEST_FUNCTIONAL_22
+
+  filename = fullfile(get_test_dir, '_functional_22.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    files = {filename, [filename, '.stream']};
+    for j = 1:numel(files)
+      if exist(files{j}, 'file')
+        delete(files{j});
+      end
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create');
+  try
+    dataset_id = bdb.dataset_create(db_id, 'volume', [30 20 5], 'int32', ...
+                                    [8 8 2]);
+    value = zeros(30, 20, 5, 'int32');
+    value(:, :, 2:4) = reshape(int32(1:1800), [30 20 3]);
+    bdb.dataset_write(dataset_id, {':', ':', 2:4}, value(:, :, 2:4));
+    value(5:12, 3, 1) = -1;
+    bdb.dataset_write(dataset_id, {5:12, 3, 1}, -ones(8, 1, 'int32'));
+    bdb.dataset_close(dataset_id);
+    dataset_id = bdb.dataset_open(db_id, 'volume');
+    assert(isequal(bdb.dataset_read(dataset_id), value));
+    assert(isequal(bdb.dataset_read(dataset_id, {7:25, 9:17, 1:3}), ...
+                   value(7:25, 9:17, 1:3)));
+    assert(isequal(bdb.dataset_read(dataset_id, {30, ':', 5}), ...
+                   value(30, :, 5)));
+    bdb.dataset_close(dataset_id);
+    metadata = bdb.get(db_id, 'volume');
+    assert(isequal(metadata.size, [30 20 5]) && strcmp(metadata.class, 'int32'));
+    bdb.delete(db_id, 'volume');
+    assert(~bdb.exist(db_id, 'volume'));
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_23()
+%TEST_FUNCTIONAL_23
+
+  filename = fullfile(get_test_dir, '_functional_23.bdb');
+  plain_file = fullfile(get_test_dir, '_functional_23_plain.bdb');
+  dump_file = fullfile(get_test_dir, '_functional_23.dump');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    files = [{filename, plain_file, dump_file, [filename, '.tag.idx'], ...
+              [filename, '.group.idx']}, ...
+             arrayfun(@(f)fullfile(get_test_dir, f.name), ...
+                      dir([filename, '.vlog.*'])', ...
+                      'UniformOutput', false)];
+    for j = 1:numel(files)
+      if exist(files{j}, 'file')
+        delete(files{j});
+      end
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create', 'ValueLog', 1024, ...
+                   'ValueLogSegmentSize', 65536);
+  try
+    bdb.put(db_id, 'small', 1);
+    for i = 1:10
+      bdb.put(db_id, 'large', rand(100) + i);
+    end
+    value = rand(100);
+    bdb.put(db_id, 'large', value);
+    assert(~isempty(dir([filename, '.vlog.0*'])));
+    assert(isequal(bdb.get(db_id, 'large'), value));
+    assert(bdb.get(db_id, 'small') == 1);
+    failed = false;
+    try
+      bdb.open(filename, 'ValueLog', 1024);
+    catch
+      failed = true;
+    end
+    assert(failed);
+    values = bdb.values(db_id);
+    assert(numel(values) == 2);
+    stats = bdb.vlog_gc(db_id);
+    assert(stats.segments > 0 && stats.reclaimed > 0);
+    assert(isequal(bdb.get(db_id, 'large'), value));
+    bdb.close(db_id);
+    db_id = bdb.open(filename, 'ValueLog', 1024, 'Thread', true);
+    assert(isequal(bdb.get(db_id, 'large'), value));
+    assert(bdb.export(db_id, dump_file) == 2);
+    plain_id = bdb.open(plain_file, 'Create');
+    assert(bdb.import(plain_id, dump_file) == 2);
+    assert(isequal(bdb.get(plain_id, 'large'), value));
+    bdb.close(plain_id);
+    bdb.delete(db_id, 'large');
+    assert(bdb.import(db_id, dump_file) == 2);
+    assert(isequal(bdb.get(db_id, 'large'), value));
+    bulk_value = rand(100);
+    assert(bdb.bulk_load(db_id, {'bulk'}, {bulk_value}) == 1);
+    assert(isequal(bdb.get(db_id, 'bulk'), bulk_value));
+    async_value = rand(100);
+    bdb.wait(bdb.put_async(db_id, 'async', async_value));
+    assert(isequal(bdb.get(db_id, 'async'), async_value));
+    assert(isequal(bdb.wait(bdb.get_async(db_id, 'async')), async_value));
+    values = bdb.wait(bdb.mget_async(db_id, {'large', 'bulk'}));
+    assert(isequal(values{1}, value) && isequal(values{2}, bulk_value));
+    tagged = struct('tag', 7, 'group', 1, 'data', rand(100));
+    bdb.put(db_id, 'tagged', tagged);
+    tag_id = bdb.create_index(db_id, 'FieldName', 'tag');
+    group_id = bdb.create_index(db_id, 'FieldName', 'group');
+    [values, keys] = bdb.get_by(tag_id, 7);
+    assert(isequal(values, {tagged}) && isequal(keys, {'tagged'}));
+    [values, keys] = bdb.join(db_id, {tag_id, 7; group_id, 1});
+    assert(isequal(values, {tagged}) && isequal(keys, {'tagged'}));
+    bdb.close(db_id);
+    db_id = bdb.open(filename, 'ValueLog', 1024, 'Codec', 'native');
+    signal = (1:1000)';
+    bdb.put(db_id, 'signal', signal);
+    assert(isequal(bdb.get(db_id, 'signal', 'Range', [10, 5]), (11:15)'));
+    bdb.put(db_id, 'signal', [0; 0], 'At', 500);
+    signal(501:502) = 0;
+    assert(isequal(bdb.get(db_id, 'signal'), signal));
+    assert(isequal(bdb.get(db_id, 'signal', 'Range', [499, 4]), ...
+                   [500; 0; 0; 503]));
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_24()
+%TEST_FUNCTIONAL_24
+
+  filename = fullfile(get_test_dir, '_functional_24.bdb');
+
+  function cleanup(db_id, filename)
+  %CLEANUP
+    bdb.close(db_id);
+    if exist(filename, 'file')
+      delete(filename);
+    end
+  end
+
+  db_id = bdb.open(filename, 'Create');
+  try
+    for i = 1:10
+      bdb.put(db_id, i, rand(200));
+    end
+    keys = bdb.keys(db_id);
+    assert(isequal(sort(cell2mat(keys)), (1:10)'));
+    cursor_id = bdb.cursor_open(db_id, 'KeysOnly', true);
+    cursor_keys = [];
+    failed = false;
+    while bdb.cursor_next(cursor_id)
+      cursor_keys(end + 1) = bdb.cursor_get(cursor_id);
+      try
+        [key, value] = bdb.cursor_get(cursor_id);
+      catch
+        failed = true;
+      end
+    end
+    bdb.cursor_close(cursor_id);
+    assert(isequal(sort(cursor_keys), 1:10) && failed);
+  catch e
+    cleanup(db_id, filename);
+    rethrow(e);
+  end
+  cleanup(db_id, filename);
+
+end
+
+function test_functional_25()
+%TEST_FUNCTIONAL_25
+  home_dir = fullfile(get_test_dir, 'test_functional_25');
+  if ~exist(home_dir, 'dir'), mkdir(home_dir); end
+  function cleanup(home_dir)
+    if exist(home_dir, 'dir'), rmdir(home_dir, 's'); end
+  end
+
+  try
+    env_id = bdb.env_open(home_dir, 'Private', true);
+    db_id = bdb.open('test_functional_25.bdb', 'PageSize', 512);
+    for i = 1:2000
+      bdb.put(db_id, i, i);
+    end
+    num_interior = bdb.warm(db_id);
+    num_full = bdb.warm(db_id, 'Full');
+    assert(num_interior >= 2 && num_interior < num_full);
+    assert(bdb.warm(db_id, 'MaxPages', 1) == 1);
+    assert(bdb.warm(db_id, 'Full', 'MaxPages', 3) == 3);
+    bdb.close(db_id);
+    warm_list = fullfile(home_dir, 'warm.lst');
+    bdb.env_close(env_id, 'WarmList', warm_list);
+    env_id = bdb.env_open(home_dir, 'Private', true);
+    stats = bdb.env_stat(env_id);
+    assert(stats.mpool.page_in == 0);
+    bdb.env_close(env_id);
+    env_id = bdb.env_open(home_dir, 'Private', true, 'WarmList', warm_list);
+    stats = bdb.env_stat(env_id);
+    assert(stats.mpool.page_in >= num_full);
+    bdb.env_close(env_id);
+  catch e
+    cleanup(home_dir);
+    rethrow(e);
+  end
+  cleanup(home_dir);
+end
+
+function test_functional_26()
+%TEST_FUNCTIONAL_26
+
+  pattern = fullfile(get_test_dir, '_functional_26_%d.bdb');
+
+  function cleanup(db_id, pattern)
+  %CLEANUP
+    bdb.close_sharded(db_id);
+    for i = 0:1
+      filename = sprintf(pattern, i);
+      files = [{filename}, ...
+               arrayfun(@(f)fullfile(get_test_dir, f.name), ...
+                        dir([filename, '.vlog.*'])', ...
+                        'UniformOutput', false)];
+      for j = 1:numel(files)
+        if exist(files{j}, 'file')
+          delete(files{j});
+        end
+      end
+    end
+  end
+
+  db_id = bdb.open_sharded(pattern, 2, 'ValueLog', 1024);
+  try
+    values = cell(1, 4);
+    for i = 1:numel(values)
+      values{i} = rand(100);
+      bdb.sharded_put(db_id, i, values{i});
+    end
+    assert(~isempty(dir([sprintf(pattern, 0), '.vlog.0*'])) || ...
+           ~isempty(dir([sprintf(pattern, 1), '.vlog.0*'])));
+    assert(isequal(bdb.sharded_get(db_id, 2), values{2}));
+    assert(isequal(bdb.sharded_mget(db_id, {1, 3}), values([1, 3])));
+    assert(isequal(bdb.sharded_values(db_id, 'Ordered', true), values'));
+  catch e
+    cleanup(db_id, pattern);
+    rethrow(e);
+  end
+  cleanup(db_id, pattern);
+
+end
+
 function test_dir = get_test_dir()
   test_dir = fileparts(mfilename('fullpath'));
 end
\ No newline at end of file